@@ -0,0 +1,363 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+// End-to-end benchmarks of the loop engine, run on an offline graph (no audio device needed).
+//
+// Each scenario builds a fresh graph, records its looping tracks, warms up, and then measures a fixed stretch of
+// audio one callback at a time.  Graph changes and UI polling happen between callbacks, on this same thread, as the
+// message thread would do them; only the callbacks themselves are measured.  So runs are repeatable, and the
+// numbers can be compared across commits.
+//
+// Output is one JSON object per line per scenario, on stdout or to the file given by --output.  For each
+// scenario it reports the per-callback time (mean, p50, p99, max, against the block's real-time deadline), the heap
+// allocations made per callback, and the sample bytes the AudioKernels touched per callback.
+//
+// The looping and churn scenarios each run twice, with plugin-free tracks as separate JUCE nodes and in the loop
+// bank (NowSoundLoopBankAudioProcessor), so the two can be compared on the real per-block path.
+//
+// Usage: NowSoundBenchmark [--quick] [--filter <substring of scenario name>] [--output <file>]
+
+#include "stdafx.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "LatencyRecorder.h"
+#include "NowSoundGraph.h"
+#include "NowSoundOfflineRenderer.h"
+#include "NowSoundTrack.h"
+#include "SignalGenerator.h"
+#include "ThreadWorkCounters.h"
+
+#include "JuceHeader.h"
+
+using namespace NowSound;
+using namespace std;
+using namespace std::chrono;
+
+// Count every heap allocation, per thread; the benchmark differences the rendering thread's count around each
+// callback.  (Over-aligned allocations go through the aligned operators, which are not replaced or counted.)
+void* operator new(std::size_t size)
+{
+    CountAllocation(size);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+    // Graph parameters; the frequency histogram ones match NowSoundWinFormsApp's MagicConstants.
+    const int SampleRateHz = 48000;
+    const int OutputBinCount = 20;
+    const float CentralFrequency = 261.626f;
+    const int OctaveDivisions = 5;
+    const int CentralBinIndex = 10;
+    const int FftSize = 2048;
+
+    // How often the UI polls each track's frequency histogram, when spectrum analysis is on.
+    const int SpectrumPollsPerSecond = 60;
+
+    // Seconds of audio to render before measuring, and to measure.
+    const double WarmupSeconds = 0.5;
+    const double MeasuredSeconds = 10;
+    const double QuickMeasuredSeconds = 1;
+
+    // One benchmark scenario.
+    struct Scenario
+    {
+        // The scenario's name, in the output and for --filter.
+        string Name;
+
+        // Samples per callback.
+        int BlockSize;
+
+        // The number of tracks looping throughout.
+        int LoopingTracks;
+
+        // The number of inputs with a track recording from them throughout.
+        int RecordingInputs;
+
+        // Is frequency tracking on, with the UI polling every track's histogram?
+        bool Spectrum;
+
+        // If nonzero, every this many seconds the oldest looping track is deleted and a new one recorded.
+        double ChurnPeriodSeconds;
+
+        // Are the tracks rendered by the loop bank, rather than as separate JUCE nodes?
+        bool LoopBank;
+    };
+
+    // The measurements from running one scenario.
+    struct ScenarioResult
+    {
+        LatencyRecorder CallbackMicroseconds;
+        int64_t Allocations;
+        int64_t AllocatedBytes;
+        int64_t KernelBytes;
+
+        ScenarioResult(int callbackCount)
+            : CallbackMicroseconds{ callbackCount }, Allocations{ 0 }, AllocatedBytes{ 0 }, KernelBytes{ 0 }
+        {}
+    };
+
+    vector<Scenario> AllScenarios()
+    {
+        vector<Scenario> scenarios;
+
+        // looping throughput across track counts and block sizes
+        for (int blockSize : { 32, 128, 512 })
+        {
+            for (int tracks : { 1, 16, 64, 256 })
+            {
+                scenarios.push_back({ "loops", blockSize, tracks, 0, false, 0, false });
+                scenarios.push_back({ "loops", blockSize, tracks, 0, false, 0, true });
+            }
+        }
+
+        // recording on every input at once, over a modest number of loops
+        for (int inputs : { 1, 2 })
+        {
+            scenarios.push_back({ "recording", 128, 16, inputs, false, 0, false });
+        }
+
+        // the cost of frequency tracking
+        for (int tracks : { 16, 64 })
+        {
+            scenarios.push_back({ "spectrum", 128, tracks, 0, false, 0, false });
+            scenarios.push_back({ "spectrum", 128, tracks, 0, true, 0, false });
+        }
+
+        // tracks coming and going while others play
+        for (double period : { 1.0, 0.25 })
+        {
+            scenarios.push_back({ "churn", 128, 64, 0, false, period, false });
+            scenarios.push_back({ "churn", 128, 64, 0, false, period, true });
+        }
+
+        return scenarios;
+    }
+
+    // Render until every given track is looping.
+    void RenderUntilLooping(NowSoundGraph* graph, NowSoundOfflineRenderer& renderer, const deque<TrackId>& tracks)
+    {
+        // tracks record at most a few beats; anything much longer means they are stuck
+        int maximumBlocks = SampleRateHz * 16 / renderer.SamplesPerQuantum();
+        for (int i = 0; i < maximumBlocks; i++)
+        {
+            bool allLooping = true;
+            for (TrackId id : tracks)
+            {
+                allLooping = allLooping && graph->Track(id)->State() == NowSoundTrackState::TrackLooping;
+            }
+            if (allLooping)
+            {
+                return;
+            }
+
+            renderer.RenderBlock();
+        }
+        Check(false);
+    }
+
+    // Create a track recording from the given input, which will loop after one beat.
+    TrackId CreateLoopingTrack(NowSoundGraph* graph, int inputIndex)
+    {
+        TrackId id = graph->CreateRecordingTrackAsync((AudioInputId)(inputIndex + 1));
+        graph->Track(id)->FinishRecording();
+        return id;
+    }
+
+    void RunScenario(const Scenario& scenario, double measuredSeconds, ScenarioResult& result)
+    {
+        NowSoundGraph::SetUseLoopBank(scenario.LoopBank);
+        NowSoundGraph::InitializeOfflineInstance(
+            SampleRateHz,
+            scenario.BlockSize,
+            OutputBinCount,
+            CentralFrequency,
+            OctaveDivisions,
+            CentralBinIndex,
+            scenario.Spectrum ? FftSize : -1);
+        NowSoundGraph* graph = NowSoundGraph::Instance();
+        Check(graph->State() == NowSoundGraphState::GraphRunning);
+
+        {
+            NowSoundOfflineRenderer renderer(graph);
+            int inputCount = graph->Info().ChannelCount;
+            Check(scenario.RecordingInputs <= inputCount);
+
+            renderer.SetInput(0, unique_ptr<SignalGenerator>(new SineGenerator(SampleRateHz, 220, 0.5f)));
+            renderer.SetInput(1, unique_ptr<SignalGenerator>(new NoiseGenerator(1, 0.25f)));
+
+            // record all the loops at once, alternating inputs
+            deque<TrackId> loops;
+            for (int i = 0; i < scenario.LoopingTracks; i++)
+            {
+                loops.push_back(CreateLoopingTrack(graph, i % inputCount));
+            }
+            RenderUntilLooping(graph, renderer, loops);
+
+            for (int i = 0; i < scenario.RecordingInputs; i++)
+            {
+                graph->CreateRecordingTrackAsync((AudioInputId)(i + 1));
+            }
+
+            renderer.Render((int)(WarmupSeconds * SampleRateHz / scenario.BlockSize));
+
+            int callbackCount = (int)(measuredSeconds * SampleRateHz / scenario.BlockSize);
+            int churnPeriodBlocks = (int)(scenario.ChurnPeriodSeconds * SampleRateHz / scenario.BlockSize);
+            int pollPeriodBlocks = SampleRateHz / SpectrumPollsPerSecond / scenario.BlockSize;
+            pollPeriodBlocks = pollPeriodBlocks < 1 ? 1 : pollPeriodBlocks;
+            vector<float> frequencies(OutputBinCount);
+
+            const ThreadWorkCounters& counters = CurrentThreadWorkCounters();
+            for (int i = 0; i < callbackCount; i++)
+            {
+                // the message thread's work
+                if (churnPeriodBlocks > 0 && i > 0 && i % churnPeriodBlocks == 0)
+                {
+                    graph->DeleteTrack(loops.front());
+                    loops.pop_front();
+                    loops.push_back(CreateLoopingTrack(graph, 0));
+                }
+                if (scenario.Spectrum && i % pollPeriodBlocks == 0)
+                {
+                    for (TrackId id : loops)
+                    {
+                        graph->Track(id)->GetFrequencies(frequencies.data(), OutputBinCount);
+                    }
+                }
+                graph->MessageTick();
+
+                // the device's input, which is not the callback's work
+                renderer.GenerateInputs();
+
+                // and the callback
+                ThreadWorkCounters before = counters;
+                steady_clock::time_point start = steady_clock::now();
+                renderer.ProcessBlock();
+                steady_clock::time_point end = steady_clock::now();
+
+                result.CallbackMicroseconds.Record(duration<double, micro>(end - start).count());
+                result.Allocations += counters.Allocations - before.Allocations;
+                result.AllocatedBytes += counters.AllocatedBytes - before.AllocatedBytes;
+                result.KernelBytes += counters.KernelBytes - before.KernelBytes;
+            }
+        }
+
+        NowSoundGraph::ShutdownInstance();
+    }
+
+    void WriteResult(ostream& output, const Scenario& scenario, const ScenarioResult& result)
+    {
+        int callbacks = result.CallbackMicroseconds.Count();
+        double deadlineMicroseconds = 1e6 * scenario.BlockSize / SampleRateHz;
+        double meanMicroseconds = result.CallbackMicroseconds.Mean();
+
+        output << "{\"scenario\":\"" << scenario.Name << "\""
+            << ",\"sampleRateHz\":" << SampleRateHz
+            << ",\"blockSize\":" << scenario.BlockSize
+            << ",\"loopingTracks\":" << scenario.LoopingTracks
+            << ",\"recordingInputs\":" << scenario.RecordingInputs
+            << ",\"spectrum\":" << (scenario.Spectrum ? "true" : "false")
+            << ",\"churnPeriodSeconds\":" << scenario.ChurnPeriodSeconds
+            << ",\"loopBank\":" << (scenario.LoopBank ? "true" : "false")
+            << ",\"callbacks\":" << callbacks
+            << ",\"deadlineUs\":" << deadlineMicroseconds
+            << ",\"meanUs\":" << meanMicroseconds
+            << ",\"p50Us\":" << result.CallbackMicroseconds.Percentile(50)
+            << ",\"p99Us\":" << result.CallbackMicroseconds.Percentile(99)
+            << ",\"maxUs\":" << result.CallbackMicroseconds.Max()
+            << ",\"load\":" << (meanMicroseconds / deadlineMicroseconds)
+            << ",\"allocationsPerCallback\":" << ((double)result.Allocations / callbacks)
+            << ",\"allocatedBytesPerCallback\":" << ((double)result.AllocatedBytes / callbacks)
+#ifdef NOWSOUND_COUNT_KERNEL_TRAFFIC
+            << ",\"kernelBytesPerCallback\":" << ((double)result.KernelBytes / callbacks)
+#else
+            << ",\"kernelBytesPerCallback\":null"
+#endif
+            << "}" << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    string filter;
+    string outputPath;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg{ argv[i] };
+        if (arg == "--quick")
+        {
+            quick = true;
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            cerr << "Usage: NowSoundBenchmark [--quick] [--filter <substring of scenario name>] [--output <file>]" << endl;
+            return 2;
+        }
+    }
+
+    ofstream outputFile;
+    if (!outputPath.empty())
+    {
+        outputFile.open(outputPath);
+        if (!outputFile)
+        {
+            cerr << "Can't open " << outputPath << endl;
+            return 1;
+        }
+    }
+    ostream& output = outputPath.empty() ? cout : outputFile;
+
+    // the graph needs JUCE's message manager, even with no message loop running
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    for (const Scenario& scenario : AllScenarios())
+    {
+        if (!filter.empty() && scenario.Name.find(filter) == string::npos)
+        {
+            continue;
+        }
+
+        double measuredSeconds = quick ? QuickMeasuredSeconds : MeasuredSeconds;
+        ScenarioResult result{ (int)(measuredSeconds * SampleRateHz / scenario.BlockSize) };
+        RunScenario(scenario, measuredSeconds, result);
+        WriteResult(output, scenario, result);
+    }
+
+    return 0;
+}
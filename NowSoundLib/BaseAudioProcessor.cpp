@@ -9,7 +9,10 @@
 NowSound::BaseAudioProcessor::BaseAudioProcessor(NowSoundGraph* graph, const std::wstring& name)
     : _graph{ graph },
     _name { name },
-    _nodeId{}
+    _nodeId{},
+    _processBlockTimings{},
+    _timingProcessBlock{ false },
+    _timelineName{ String(name.c_str()).toStdString() }
 {}
 
 bool NowSound::BaseAudioProcessor::CheckLogThrottle()
@@ -7,6 +7,7 @@
 
 #include <string>
 #include "NowSoundGraph.h"
+#include "TimingHistogram.h"
 
 namespace NowSound
 {
@@ -51,6 +52,15 @@ namespace NowSound
         // log counter, to count the number of (throttled) log messages we emit (this helps with sequencing)
         int _logCounter;
 
+        // How long each processBlock call took.
+        TimingHistogram _processBlockTimings;
+
+        // Is a ProcessBlockTimer timing this processor right now?  Audio thread only.
+        bool _timingProcessBlock;
+
+        // Our name in UTF-8, as the graph's timeline reports it.
+        const std::string _timelineName;
+
     public:
         // the max counter at which _logThrottlingCounter rolls over
         static const int LogThrottle = 1000;
@@ -68,6 +78,9 @@ namespace NowSound
 
         virtual const String getName() const override { return String(_name.c_str()); }
 
+        // How long this processor's processBlock calls have taken.
+        TimingHistogram& ProcessBlockTimings() { return _processBlockTimings; }
+
     protected:
         // The name of this processor.
         const std::wstring _name;
@@ -78,5 +91,42 @@ namespace NowSound
         bool CheckLogThrottle();
 
         int NextCounter() { return ++_logCounter; }
+
+        // Times the processBlock call in which it is declared (it should come first), recording the duration in
+        // ProcessBlockTimings() and noting it with the graph (which reports the slowest processors of any callback
+        // that misses its deadline).  A timer nested in another for the same processor (as when a track's processBlock
+        // calls SpatialAudioProcessor::processBlock) records nothing; the outermost one counts the whole call.
+        class ProcessBlockTimer
+        {
+        private:
+            // The processor being timed, or null if this timer is nested.
+            BaseAudioProcessor* _processor;
+
+            // When the call began.
+            int64_t _startNanoseconds;
+
+        public:
+            ProcessBlockTimer(BaseAudioProcessor* processor)
+                : _processor{ processor->_timingProcessBlock ? nullptr : processor },
+                _startNanoseconds{ 0 }
+            {
+                if (_processor != nullptr)
+                {
+                    _processor->_timingProcessBlock = true;
+                    _startNanoseconds = TimingHistogram::Now();
+                }
+            }
+
+            ~ProcessBlockTimer()
+            {
+                if (_processor != nullptr)
+                {
+                    int64_t durationNanoseconds = TimingHistogram::Now() - _startNanoseconds;
+                    _processor->_processBlockTimings.Record(durationNanoseconds);
+                    _processor->_graph->NoteProcessBlock(_processor->_timelineName.c_str(), durationNanoseconds);
+                    _processor->_timingProcessBlock = false;
+                }
+            }
+        };
     };
 }
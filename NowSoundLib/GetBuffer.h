@@ -1,12 +0,0 @@
-// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
-// Licensed under the MIT license
-
-#include "stdafx.h"
-
-#include "winrt/Windows.Foundation.h"
-
-// From https://gist.github.com/kennykerr/f1d941c2d26227abbf762481bcbd84d3
-struct __declspec(uuid("5b0d3235-4dba-4d44-865e-8f1d0e4fd04d")) __declspec(novtable) IMemoryBufferByteAccess : ::IUnknown
-{
-    virtual HRESULT __stdcall GetBuffer(uint8_t** value, uint32_t* capacity) = 0;
-};
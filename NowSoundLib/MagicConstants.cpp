@@ -13,6 +13,14 @@ using namespace NowSound;
 // If true, create audio graph with UseLowestLatency and RawMode.
 const bool MagicConstants::UseLowestLatency = true;
 
+// The bank saves JUCE scheduling, a buffer copy per connection, and a graph rebuild per track added or removed;
+// but it stays off unless the host asks for it with NowSoundGraph_SetUseLoopBank, until NowSoundBenchmark's
+// loopBank scenarios have shown it paying off end to end.
+const bool MagicConstants::UseLoopBank = false;
+
+// Far more tracks than anyone has looped at once; the bank's slots are just pointers.
+const int MagicConstants::LoopBankCapacity{ 256 };
+
 // exactly one beat per second for initial testing
 const float MagicConstants::InitialBeatsPerMinute{ 60 };
 
@@ -22,6 +30,19 @@ const int MagicConstants::BeatsPerMeasure{ 4 };
 // Could be much larger but not really any reason to
 const int MagicConstants::InitialAudioBufferCount{ 8 };
 
+// Four spare seconds is plenty, given the refill thread wakes up ten times a second.
+const int MagicConstants::AudioBufferLowWatermark{ 4 };
+
+// Refill back to the initial count, so the steady state looks like startup.
+const int MagicConstants::AudioBufferRefillTarget{ 8 };
+
+const ContinuousDuration<Second> MagicConstants::AudioBufferRefillInterval{ (float)0.1 };
+
+// Off unless the host asks for it with NowSoundGraph_SetAudioBufferArenaCount, as the arena locks all its memory
+// up front.  Audio buffers are sized in floats by BytesPerSecond, so each holds four seconds of 48Khz stereo (1.5MB);
+// 150 of them is ten minutes of recording (about 230MB), enough for a long set without ever touching the heap.
+const int MagicConstants::AudioBufferArenaCount{ 0 };
+
 // 1 second of stereo float audio at 48Khz is only 384KB.  One second buffer ensures minimal fragmentation
 // regardless of loop length.
 const Duration<Second> MagicConstants::AudioBufferSizeInSeconds{ 1 };
@@ -38,3 +59,31 @@ const int MagicConstants::DebugLogCapacity{ 1000 };
 const int MagicConstants::AudioQuantumHistogramCapacity{ 200 };
 
 const ContinuousDuration<Second> MagicConstants::RecentVolumeDuration{ (float)0.5 };
+
+// Half a second at 48Khz in blocks of as few as 32 samples is 750 blocks; block summaries are only 20 bytes each.
+const int MagicConstants::RecentVolumeBlockCapacity{ 1024 };
+
+// 75% overlap is the usual choice for a Blackman-Harris window; at an FFT size of 2048 and 48Khz that is
+// about 94 transforms per second per tracker, which the float FFT handles in well under 1% of a core.
+const int MagicConstants::FrequencyTrackerOverlap{ 4 };
+
+// Four frames of history lets the FFT task fall three whole frames behind (over 100ms at FFT size 2048) before
+// any frame is lost; at 4 bytes per sample this is 32KB per tracker.
+const int MagicConstants::FrequencyTrackerHistoryFrameCount{ 4 };
+
+// 10ms is short enough to feel immediate, and long enough that even a full-scale volume jump doesn't click.
+const ContinuousDuration<Second> MagicConstants::ParameterRampDuration{ (float)0.01 };
+
+// Two workers keep up with dozens of trackers, while leaving the rest of the cores to the audio and UI threads.
+const int MagicConstants::AnalysisWorkerCount{ 2 };
+
+// A hop at FFT size 2048 and 75% overlap is about 10ms, so polling every 5ms keeps worst-case latency to half a hop
+// while each worker wakes only 200 times a second.
+const std::chrono::microseconds MagicConstants::AnalysisPollInterval{ 5000 };
+
+// The UI polls visible trackers every frame; half a second without a poll means nobody is looking.
+const std::chrono::milliseconds MagicConstants::AnalysisIdleTimeout{ 500 };
+
+// FFT bursts are the most frequent events, at a few hundred a second with the UI watching; this keeps the last few
+// seconds of them, and any deadline misses among them.
+const int MagicConstants::TimelineCapacity{ 1024 };
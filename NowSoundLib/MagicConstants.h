@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "NowSoundTime.h"
 
 // Constants that are assigned based on manual tuning.
@@ -20,6 +22,13 @@ namespace NowSound
         // capture and playback.
         static const bool UseLowestLatency;
 
+        // Render all tracks without plugins in a single loop bank node, rather than two JUCE nodes per track?
+        // This is only the default; hosts can change it with NowSoundGraph_SetUseLoopBank.
+        static const bool UseLoopBank;
+
+        // How many tracks can the loop bank hold?  Tracks beyond this get their own JUCE nodes.
+        static const int LoopBankCapacity;
+
         // The initial tempo.
         static const float InitialBeatsPerMinute;
 
@@ -31,6 +40,22 @@ namespace NowSound
         // Not much downside to allocating many; stereo float 48Khz = only 384KB per one-sec buffer
         static const int InitialAudioBufferCount;
 
+        // When fewer than this many audio buffers are free, the background refill thread allocates more.
+        // The audio thread consumes one buffer per second per recording track, so this is effectively the number of
+        // track-seconds of recording that can happen before the refill thread must have caught up.
+        static const int AudioBufferLowWatermark;
+
+        // How many free audio buffers does the background refill thread top the free list back up to?
+        static const int AudioBufferRefillTarget;
+
+        // How often does the background refill thread check the free list?
+        static const ContinuousDuration<Second> AudioBufferRefillInterval;
+
+        // By default, how many audio buffers to carve out of a single locked, prefaulted (and ideally huge-page)
+        // memory arena at startup; 0 means all audio buffers come from the heap.  Hosts can change this with
+        // NowSoundGraph_SetAudioBufferArenaCount.
+        static const int AudioBufferArenaCount;
+
         // How many seconds long is each audio buffer?
         static const Duration<Second> AudioBufferSizeInSeconds;
 
@@ -46,5 +71,33 @@ namespace NowSound
 
         // Amount of time over which to measure volume.
         static const ContinuousDuration<Second> RecentVolumeDuration;
+
+        // How many audio blocks' summaries does each volume meter keep?
+        // This must be enough blocks to cover RecentVolumeDuration at the smallest block size the device uses.
+        static const int RecentVolumeBlockCapacity;
+
+        // How many frequency-tracker FFT frames overlap any given sample?  The hop between successive frames is the
+        // FFT size divided by this.
+        static const int FrequencyTrackerOverlap;
+
+        // How many FFT frames of input history does each frequency tracker keep?  The FFT task can fall behind the
+        // audio thread by this many frames, less one, before frames start being skipped.
+        static const int FrequencyTrackerHistoryFrameCount;
+
+        // How long do volume and pan changes take to ramp to their new values?
+        static const ContinuousDuration<Second> ParameterRampDuration;
+
+        // How many threads run the frequency trackers' FFTs?
+        static const int AnalysisWorkerCount;
+
+        // How often does each analysis worker look for queued FFT frames?
+        static const std::chrono::microseconds AnalysisPollInterval;
+
+        // How recently must a frequency tracker have been polled for its frames to be transformed at all?
+        static const std::chrono::milliseconds AnalysisIdleTimeout;
+
+        // How many events (deadline misses, track creations, graph rebuilds, FFT bursts) does the graph's timeline
+        // keep?  Must be a power of two.
+        static const int TimelineCapacity;
     };
 }
@@ -15,12 +15,13 @@ namespace NowSound
     class MeasurableAudio 
     {
         // Copy out the volume signal info for reading.
-        // This locks the info mutex.
+        // This must not block the audio thread.
         virtual NowSoundSignalInfo SignalInfo() = 0;
 
         // Get the frequency histogram, by updating the given WCHAR buffer as though it were a float* buffer.
-        // This locks the info mutex.  The frequency histogram is averaged over all channels; this is not per-channel.
-        virtual void GetFrequencies(void* floatBuffer, int floatBufferCapacity) = 0;
+        // This must not block the audio thread.  The frequency histogram is averaged over all channels; this is not per-channel.
+        // Returns the Clock time at which the audio the histogram describes ended (0 if there is no histogram yet).
+        virtual Time<AudioSample> GetFrequencies(void* floatBuffer, int floatBufferCapacity) = 0;
     };
 }
 
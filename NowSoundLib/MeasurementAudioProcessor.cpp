@@ -3,7 +3,6 @@
 
 #include "stdafx.h"
 
-using namespace concurrency; 
 using namespace std;
 
 #include "Clock.h"
@@ -14,12 +13,19 @@ using namespace NowSound;
 
 MeasurementAudioProcessor::MeasurementAudioProcessor(NowSoundGraph* graph, const wstring& name)
     : BaseAudioProcessor(graph, name),
-    _frequencyDataMutex{},
     // hardcoded to the clock's channel count, e.g. the overall output bus width.
-    _volumeHistogram{ new Histogram((int)Clock::Instance().TimeToSamples(MagicConstants::RecentVolumeDuration).Value()) },
+    _volumeHistogram{ new BlockHistogram(
+        (int)Clock::Instance().TimeToSamples(MagicConstants::RecentVolumeDuration).Value(),
+        MagicConstants::RecentVolumeBlockCapacity) },
+    _signalSnapshot{ 3 },
     _frequencyTracker{ graph->FftSize() < 0
         ? ((NowSoundFrequencyTracker*)nullptr)
-        : new NowSoundFrequencyTracker(graph->BinBounds(), graph->FftSize()) },
+        : new NowSoundFrequencyTracker(
+            graph->BinMapping(),
+            graph->AnalysisPool(),
+            graph->FftSize(),
+            graph->FftSize() / MagicConstants::FrequencyTrackerOverlap,
+            MagicConstants::FrequencyTrackerHistoryFrameCount) },
     _recordingFile{},
     _recordingMutex{},
     _recordingThread{},
@@ -29,29 +35,28 @@ MeasurementAudioProcessor::MeasurementAudioProcessor(NowSoundGraph* graph, const
 
 NowSoundSignalInfo MeasurementAudioProcessor::SignalInfo()
 {
-    std::lock_guard<std::mutex> guard(_frequencyDataMutex);
-    float min = _volumeHistogram->Min();
-    float max = _volumeHistogram->Max();
-    float avg = _volumeHistogram->Average();
-    return CreateNowSoundSignalInfo(min, max, avg);
+    float minMaxAvg[3];
+    _signalSnapshot.Read(minMaxAvg, 3);
+    return CreateNowSoundSignalInfo(minMaxAvg[0], minMaxAvg[1], minMaxAvg[2]);
 }
 
-void MeasurementAudioProcessor::GetFrequencies(void* floatBuffer, int floatBufferCapacity)
+Time<AudioSample> MeasurementAudioProcessor::GetFrequencies(void* floatBuffer, int floatBufferCapacity)
 {
     // avoid race condition at init time
     if (_frequencyTracker == nullptr)
     {
-        return;
+        return 0;
     }
 
-    std::lock_guard<std::mutex> guard(_frequencyDataMutex);
-    _frequencyTracker->GetLatestHistogram((float*)floatBuffer, floatBufferCapacity);
+    return _frequencyTracker->GetLatestHistogram((float*)floatBuffer, floatBufferCapacity);
 }
 
 const double Pi = std::atan(1) * 4;
 
 void MeasurementAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, MidiBuffer& midiBuffer)
 {
+    ProcessBlockTimer timer{ this };
+
     // temporary debugging code: see if processBlock is ever being called under Holofunk
     if (CheckLogThrottle())
     {
@@ -67,23 +72,21 @@ void MeasurementAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, Mi
     const float* outputBufferChannel0 = audioBuffer.getReadPointer(0);
     const float* outputBufferChannel1 = audioBuffer.getReadPointer(1);
 
-    // Pan each mono sample (and track its volume), if we're not muted.
-    {
-        std::lock_guard<std::mutex> guard(_frequencyDataMutex);
+    // Track the volume, and publish it for the UI.
+    // we average the stereo channels when computing the histogram values to add
+    _volumeHistogram->AddStereoMagnitudeBlock(outputBufferChannel0, outputBufferChannel1, numSamples);
+    float minMaxAvg[3] = { _volumeHistogram->Min(), _volumeHistogram->Max(), _volumeHistogram->Average() };
+    _signalSnapshot.Publish(minMaxAvg, 3);
 
-        for (int i = 0; i < numSamples; i++)
-        {
-            // we average the stereo channels when computing the histogram values to add
-            float value0 = outputBufferChannel0[i];
-            float value1 = outputBufferChannel1[i];
-            _volumeHistogram->Add(std::abs(value0) / 2 + std::abs(value1) / 2);
-        }
-
-        // and provide it to frequency histogram as well
-        if (_frequencyTracker != nullptr)
-        {
-            _frequencyTracker->Record(outputBufferChannel0, outputBufferChannel1, numSamples);
-        }
+    // and provide it to frequency histogram as well
+    if (_frequencyTracker != nullptr)
+    {
+        // The clock has already been advanced past this block by the first input's processBlock.
+        _frequencyTracker->Record(
+            outputBufferChannel0,
+            outputBufferChannel1,
+            numSamples,
+            Clock::Instance().Now() - Duration<AudioSample>{ numSamples });
     }
 
     // and write to recording thread, if any
@@ -112,7 +115,7 @@ void MeasurementAudioProcessor::StartRecording(LPWSTR fileName, int32_t fileName
         return;
     }
 
-    _recordingFile = File{ String{ fileName } };
+    _recordingFile = File{ String{ Platform::ToWideString(fileName).c_str() } };
 
     // TODO: test if this actually works... can we reuse threads across multiple ThreadedWriters?
     if (_recordingThread.get() == nullptr)
@@ -9,6 +9,7 @@
 #include "NowSoundGraph.h"
 #include "BaseAudioProcessor.h"
 #include "MeasurableAudio.h"
+#include "MeteringSnapshot.h"
 
 namespace NowSound
 {
@@ -17,11 +18,12 @@ namespace NowSound
     // Subclasses can use this to measure either before or after subclass processing.
     class MeasurementAudioProcessor : public BaseAudioProcessor, public MeasurableAudio
     {
-        // Mutex to use when returning or updating signal info; to prevent racing between data access and update.
-        std::mutex _frequencyDataMutex;
+        // histogram of volume, kept per block; touched only by the audio thread
+        std::unique_ptr<BlockHistogram> _volumeHistogram;
 
-        // histogram of volume
-        std::unique_ptr<Histogram> _volumeHistogram;
+        // The volume histogram's min, max and average as of the last block, published for SignalInfo()
+        // so that UI polling never blocks the audio thread.
+        MeteringSnapshot _signalSnapshot;
 
         // The frequency tracker for the audio traveling through this processor.
         // TODOFX: make this actually track the *post-effects* audio... probably via its own tracker at that stage?
@@ -46,16 +48,17 @@ namespace NowSound
         MeasurementAudioProcessor(NowSoundGraph* graph, const std::wstring& name);
 
         // Process the given buffer; use the number of output channels as the channel count.
-        // This locks the info mutex.
+        // This publishes the signal info and never waits on readers.
         virtual void processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
 
         // Copy out the volume signal info for reading.
-        // This locks the info mutex.
+        // This takes no lock; it reads the snapshot published by the last processBlock.
         NowSoundSignalInfo SignalInfo();
 
-        // Get the frequency histogram, by updating the given WCHAR buffer as though it were a float* buffer.
-        // This locks the info mutex.
-        void GetFrequencies(void* floatBuffer, int floatBufferCapacity);
+        // Get the frequency histogram, by updating the given WCHAR buffer as though it were a float* buffer, and
+        // return the Clock time at which the histogram's audio ended (0 if there is no histogram yet).
+        // This takes no lock; it reads the frequency tracker's latest published histogram.
+        Time<AudioSample> GetFrequencies(void* floatBuffer, int floatBufferCapacity);
 
         // Start recording to the given file (WAV format); ignored if already recording.
         void StartRecording(LPWSTR fileName, int32_t fileNameLength);
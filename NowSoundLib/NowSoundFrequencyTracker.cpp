@@ -7,143 +7,112 @@
 
 #include "stdint.h"
 
+#include "AudioKernels.h"
 #include "NowSoundFrequencyTracker.h"
 
-using namespace concurrency;
 using namespace RosettaFFT;
 using namespace std;
 using namespace std::chrono;
-using namespace winrt;
-using namespace winrt::Windows::Foundation;
 
 namespace NowSound
 {
     NowSoundFrequencyTracker::NowSoundFrequencyTracker(
-        const std::vector<FrequencyBinBounds>* bounds,
-        int fftSize)
-        : _bufferStates{},
-        _fftBuffers{},
-        _outputBuffer{},
-        _latestOutputBufferIndex{ -1 },
-        _recordingBufferIndex{ 0 },
-        _recordingBufferSize{ 0 },
-        _binBounds(bounds),
-        _fftSize{ fftSize }
+        const BinMappingMatrix* binMapping,
+        AnalysisWorkerPool* pool,
+        int fftSize,
+        int hopSize,
+        int historyFrameCount)
+        : _fftSize{ fftSize },
+        _stftBuffer{ fftSize, hopSize, historyFrameCount },
+        _nextFrameEnd{ fftSize },
+        _frameJobs{ StftBuffer::RoundUpToPowerOfTwo(_stftBuffer.Capacity() / hopSize) },
+        _skippedFrameCount{ 0 },
+        _lastPolled{ steady_clock::now().time_since_epoch().count() },
+        _frame{ new float[fftSize] },
+        _fftReal{ new float[fftSize / 2 + 1] },
+        _fftImaginary{ new float[fftSize / 2 + 1] },
+        _fftMagnitudes{ new float[fftSize / 2 + 1] },
+        _transformOutputBuffer{ new float[binMapping->OutputCount()] },
+        _outputSnapshot{ binMapping->OutputCount() },
+        _binMapping{ binMapping },
+        _pool{ pool }
     {
-        _outputBuffer = std::unique_ptr<float>(new float[bounds->size()]);
-        // TODO: BROKEN: std::fill(_outputBuffer.get(), _outputBuffer.get() + bounds->size(), 0);
-        for (int i = 0; i < BufferCount; i++)
-        {
-            _bufferStates.push_back(BufferState::Available);
-            _fftBuffers.push_back(std::unique_ptr<Complex>(new Complex[fftSize]));
-        }
-        _bufferStates[0] = BufferState::Recording;
+        Check(binMapping->InputCount() == fftSize / 2 + 1);
+        Check(_nextFrameEnd == _stftBuffer.FirstFrameEnd());
+
+        _pool->Register(this);
     }
 
-    void NowSoundFrequencyTracker::GetLatestHistogram(float* outputBuffer, int capacity)
+    NowSoundFrequencyTracker::~NowSoundFrequencyTracker()
     {
-        Check(capacity == _binBounds->size());
-
-        // No thread synchronization here.  Slightly inconsistent data is fine.
-        std::copy(_outputBuffer.get(), _outputBuffer.get() + capacity, outputBuffer);
+        _pool->Unregister(this);
     }
 
-    void NowSoundFrequencyTracker::Record(const float* buffer0, const float* buffer1, int sampleCount)
+    Time<AudioSample> NowSoundFrequencyTracker::GetLatestHistogram(float* outputBuffer, int capacity)
     {
-        // lock the buffers as we may very well fill the recording buffer now
-        std::lock_guard<std::mutex> guard(_bufferMutex);
+        Check(capacity == _binMapping->OutputCount());
 
-        Check(_bufferStates[_recordingBufferIndex] == BufferState::Recording);
-        Check(_recordingBufferSize < _fftSize);
+        _lastPolled.store(steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
 
-        int inputPosition = 0;
-        while (sampleCount > 0)
-        {
-            int recordingBufferCapacity = _fftSize - _recordingBufferSize;
+        return _outputSnapshot.Read(outputBuffer, capacity);
+    }
 
-            int samplesToRecord = sampleCount > recordingBufferCapacity ? recordingBufferCapacity : sampleCount;
+    steady_clock::time_point NowSoundFrequencyTracker::LastPolled() const
+    {
+        return steady_clock::time_point(steady_clock::duration(_lastPolled.load(std::memory_order_relaxed)));
+    }
 
-            Complex* recordingBuffer = _fftBuffers[_recordingBufferIndex].get();
+    void NowSoundFrequencyTracker::Record(const float* buffer0, const float* buffer1, int sampleCount, Time<AudioSample> startTime)
+    {
+        // the Clock time of StftBuffer position 0, as of this block (in case the clock is ever reset)
+        int64_t timeOffset = startTime.Value() - _stftBuffer.WritePosition();
 
-            for (int i = 0; i < samplesToRecord; i++)
-            {
-                // Assigning float to complex leaves imaginary value as 0, as desired.
-                // Note that std::copy is inapplicable here as we are writing into a Complex array.
-                // TODO: add back Blackman-Harris windowing here
-                recordingBuffer[_recordingBufferSize + i] = buffer0[inputPosition + i] / 2 + buffer1[inputPosition + 1] / 2;
-            }
+        _stftBuffer.AppendStereo(buffer0, buffer1, sampleCount);
 
-            _recordingBufferSize += samplesToRecord;
-            if (_recordingBufferSize == _fftSize)
+        // queue every frame this block completed
+        int64_t writePosition = _stftBuffer.WritePosition();
+        while (_nextFrameEnd <= writePosition)
+        {
+            if (!_frameJobs.TryPush(FrameJob{ _nextFrameEnd, _nextFrameEnd + timeOffset }))
             {
-                // this buffer is full.
-                // If we are still transforming something, then just reset this buffer.
-                bool reset = false;
-                for (int i = 0; i < BufferCount; i++)
-                {
-                    if (_bufferStates[i] == BufferState::Transforming)
-                    {
-                        // just reset this one
-                        reset = true;
-                        break;
-                    }
-                }
-
-                if (reset)
-                {
-                    // Throw away the data and start again.  If we are running behind on transformation,
-                    // it won't help us catch up to continually cancel the overly slow transformations.
-                    _recordingBufferSize = 0;
-                }
-                else
-                {
-                    int transformingBufferIndex = _recordingBufferIndex;
-                    _bufferStates[transformingBufferIndex] = BufferState::Transforming;
-                    bool found = false;
-                    for (int i = 0; i < BufferCount; i++)
-                    {
-                        if (_bufferStates[i] == BufferState::Available)
-                        {
-                            found = true;
-                            _recordingBufferIndex = i;
-                            _recordingBufferSize = 0;
-                            _bufferStates[i] = BufferState::Recording;
-                            break;
-                        }
-                    }
-
-                    // We had better have found an available buffer, or we need more buffers or task cancellation or something
-                    // because we are not managing to keep up.
-                    Check(found);
-
-                    // Spawn task to transform the buffer.
-                    create_task([this, transformingBufferIndex]() -> void { TransformBufferAsync(transformingBufferIndex); });
-                }
+                _skippedFrameCount++;
             }
-
-            sampleCount -= samplesToRecord;
-            inputPosition += samplesToRecord;
+            _nextFrameEnd += _stftBuffer.HopSize();
         }
     }
-    
-    void NowSoundFrequencyTracker::TransformBufferAsync(int transformingBufferIndex)
+
+    void NowSoundFrequencyTracker::RunPendingJobs(FftEngine& engine)
     {
-        Check(_bufferStates[transformingBufferIndex] == BufferState::Transforming);
+        Check(engine.Size() == _fftSize);
 
-        // actually run the FFT in placeB!
-        RosettaFFT::Complex* fftBuffer = _fftBuffers[transformingBufferIndex].get();
-        RosettaFFT::CArray fftArray(fftBuffer, _fftSize);
+        FrameJob job;
+        while (_frameJobs.TryPop(job))
+        {
+            if (!_stftBuffer.ReadWindowedFrame(job.FrameEnd, _frame.get()))
+            {
+                // we fell so far behind that this frame was overwritten
+                _skippedFrameCount++;
+                continue;
+            }
 
-        // and run it!
-        RosettaFFT::optimized_fft(fftArray);
+            // actually run the FFT!
+            engine.Transform(_frame.get(), _fftReal.get(), _fftImaginary.get());
+            AudioKernels::Magnitude(_fftReal.get(), _fftImaginary.get(), _fftMagnitudes.get(), _fftSize / 2 + 1);
 
-        // and rescale it!
-        RosettaFFT::RescaleFFT(*_binBounds, fftArray, _outputBuffer.get(), _binBounds->size());
+            // and rescale it!
+            _binMapping->Apply(_fftMagnitudes.get(), _transformOutputBuffer.get(), _binMapping->OutputCount());
 
-        // and now release our transforming buffer and update output buffer index!
-        std::lock_guard<std::mutex> guard(_bufferMutex);
-        Check(_bufferStates[transformingBufferIndex] == BufferState::Transforming);
-        _bufferStates[transformingBufferIndex] = BufferState::Available;
-        _latestOutputBufferIndex = transformingBufferIndex;
+            // and publish it, stamped with when its frame ended!
+            _outputSnapshot.Publish(_transformOutputBuffer.get(), _binMapping->OutputCount(), job.SampleTime);
+        }
+    }
+
+    void NowSoundFrequencyTracker::DiscardPendingJobs()
+    {
+        FrameJob job;
+        while (_frameJobs.TryPop(job))
+        {
+            _skippedFrameCount++;
+        }
     }
 }
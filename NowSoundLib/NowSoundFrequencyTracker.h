@@ -3,86 +3,107 @@
 
 #pragma once
 
-#include <complex>
-#include <vector>
+#include <atomic>
+#include <memory>
 
 #include "stdafx.h"
 
+#include "AnalysisWorkerPool.h"
 #include "Clock.h"
+#include "FftEngine.h"
 #include "Histogram.h"
+#include "MeteringSnapshot.h"
+#include "SpscQueue.h"
+#include "StftBuffer.h"
 #include "NowSoundLibTypes.h"
 #include "rosetta_fft.h"
 #include "NowSoundTime.h"
 
 namespace NowSound
 {
-    // Tracks the frequencies of a stream of input audio, by buffering the audio until a FFT
-    // window is accumulated, then firing a task to run an FFT on that data while buffering
-    // more.  Ultimately the tracker allows copying the current histogram of binned values.
+    // Tracks the frequencies of a stream of input audio, as a short-time Fourier transform: the audio thread
+    // appends each block to a StftBuffer, and whenever another hop's worth of audio has arrived, queues a job to
+    // window and transform the frame that is now complete.  The jobs are run by the graph's AnalysisWorkerPool,
+    // which skips them entirely while nobody is polling this tracker.  Ultimately the tracker allows copying the
+    // histogram of binned values from the latest frame, along with the sample time at which that frame ended.
     // All buffer management and concurrency is internal to this class.
-    class NowSoundFrequencyTracker
+    class NowSoundFrequencyTracker : public AnalysisJobSource
     {
     private:
-        // The number of buffers to create.
-        // The expectation is that we will never need more than two, due to transforming being
-        // able to keep ahead of recording.
-        const int BufferCount = 2;
-
-        // States of a buffer.
-        enum BufferState
+        // A queued frame: where it ends in the StftBuffer, and the Clock time at which it ends.
+        struct FrameJob
         {
-            // Vacant value
-            Uninitialized,
-            // Buffer is available for use
-            Available,
-            // Buffer is being recorded into
-            Recording,
-            // Buffer is having the FFT executed on it
-            Transforming
+            int64_t FrameEnd;
+            int64_t SampleTime;
         };
 
-        // The states of each buffer.
-        std::vector<BufferState> _bufferStates;
+        // The total FFT size, measured as number of samples in the FFT window.
+        const int _fftSize;
 
-        // The FFT buffers themselves.
-        std::vector<std::unique_ptr<RosettaFFT::Complex>> _fftBuffers;
+        // The history of input audio, from which windowed frames are read.
+        StftBuffer _stftBuffer;
 
-        // The single lock-free output buffer.
-        // This may get written and read concurrently, which is fine; slightly inconsistent data
-        // is better than locking overhead.
-        std::unique_ptr<float> _outputBuffer;
+        // The end of the next frame to be queued.  Touched only by the audio thread.
+        int64_t _nextFrameEnd;
 
-        // The currently recording buffer index.
-        int _recordingBufferIndex;
+        // Frames queued by the audio thread for the worker pool.  Holding at most a history's worth of frames,
+        // since any older frame will have been overwritten by the time a worker gets to it.
+        SpscQueue<FrameJob> _frameJobs;
 
-        // The current size of the recording buffer.
-        int _recordingBufferSize;
+        // The number of frames that were never transformed, because the queue was full, the frame was overwritten
+        // before a worker got to it, or nobody was polling.
+        std::atomic<int64_t> _skippedFrameCount;
 
-        // The most recently updated output buffer.
-        int _latestOutputBufferIndex;
+        // When GetLatestHistogram() was last called, in steady_clock ticks.
+        std::atomic<int64_t> _lastPolled;
 
-        // Mutex for buffer changes.
-        std::mutex _bufferMutex;
+        // The windowed frame being transformed, _fftSize long.
+        std::unique_ptr<float[]> _frame;
 
-        // The per-bin bounds; equal in length to the number of bins.
-        const std::vector<RosettaFFT::FrequencyBinBounds>* _binBounds;
+        // The complex FFT output and its magnitudes, each _fftSize / 2 + 1 long.
+        std::unique_ptr<float[]> _fftReal;
+        std::unique_ptr<float[]> _fftImaginary;
+        std::unique_ptr<float[]> _fftMagnitudes;
 
-        // The total FFT size, measured as number of samples in the FFT window.
-        const int _fftSize;
+        // The buffer into which the worker rescales the FFT output.
+        std::unique_ptr<float[]> _transformOutputBuffer;
 
-    private:
-        // Run the FFT inside a task and update the requisite output buffer.
-        void TransformBufferAsync(int transformBufferIndex);
+        // The latest rescaled FFT output, stamped with the Clock time its frame ended at, published by the
+        // worker for GetLatestHistogram().
+        MeteringSnapshot _outputSnapshot;
 
-    public:
-        NowSoundFrequencyTracker(
-            const std::vector<RosettaFFT::FrequencyBinBounds>* bounds,
-            int fftSize);
+        // The mapping from FFT magnitudes to output bins; shared with the other trackers.
+        const RosettaFFT::BinMappingMatrix* _binMapping;
 
-        // Get the latest histogram of output values.
-        void GetLatestHistogram(float* outputBuffer, int capacity);
+        // The pool that runs our jobs.
+        AnalysisWorkerPool* _pool;
 
-        // Record the given amount of float data.
-        void Record(const float* channel0, const float* channel1, int sampleCount);
+    public:
+        NowSoundFrequencyTracker(
+            const RosettaFFT::BinMappingMatrix* binMapping,
+            AnalysisWorkerPool* pool,
+            int fftSize,
+            int hopSize,
+            int historyFrameCount);
+
+        // Unregisters from the pool, waiting for any job in progress.
+        ~NowSoundFrequencyTracker();
+
+        // Get the latest histogram of output values, and return the Clock time at which the audio it was computed
+        // from ended (0 if no histogram has been computed yet).  Never blocks the threads that update it.
+        Time<AudioSample> GetLatestHistogram(float* outputBuffer, int capacity);
+
+        // Record the given amount of float data, which started at the given Clock time.
+        void Record(const float* channel0, const float* channel1, int sampleCount, Time<AudioSample> startTime);
+
+        // The number of frames which were never transformed.
+        int64_t SkippedFrameCount() const { return _skippedFrameCount; }
+
+        // AnalysisJobSource implementation, called by the pool's workers.
+        virtual int FftSize() const override { return _fftSize; }
+        virtual std::chrono::steady_clock::time_point LastPolled() const override;
+        virtual bool HasPendingJobs() const override { return !_frameJobs.IsEmpty(); }
+        virtual void RunPendingJobs(FftEngine& engine) override;
+        virtual void DiscardPendingJobs() override;
     };
 }
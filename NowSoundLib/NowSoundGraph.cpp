@@ -4,23 +4,20 @@
 #include "stdafx.h"
 
 #include <algorithm>
+#include <stdexcept>
 
 #include "Clock.h"
-#include "GetBuffer.h"
 #include "Histogram.h"
 #include "MagicConstants.h"
 #include "NowSoundLib.h"
 #include "NowSoundGraph.h"
 #include "NowSoundInput.h"
+#include "NowSoundLoopBank.h"
 #include "NowSoundTrack.h"
 #include "Option.h"
 
-using namespace concurrency;
 using namespace std;
 using namespace std::chrono;
-using namespace winrt;
-
-using namespace winrt::Windows::Foundation;
 
 bool juce::NowSound_CheckLogThrottle()
 {
@@ -34,16 +31,27 @@ void juce::NowSound_Log(const std::wstring& message)
 
 namespace NowSound
 {
-    TimeSpan timeSpanFromSeconds(int seconds)
-    {
-        // TimeSpan is in 100ns units
-        return TimeSpan(seconds * Clock::TicksPerSecond);
-    }
-
     std::unique_ptr<NowSoundGraph> NowSoundGraph::s_instance{ nullptr };
 
+    int NowSoundGraph::s_audioBufferArenaCount{ MagicConstants::AudioBufferArenaCount };
+
+    bool NowSoundGraph::s_useLoopBank{ MagicConstants::UseLoopBank };
+
     NowSoundGraph* NowSoundGraph::Instance() { return s_instance.get(); }
 
+    void NowSoundGraph::SetAudioBufferArenaCount(int audioBufferArenaCount)
+    {
+        Check(s_instance == nullptr);
+        Check(audioBufferArenaCount >= 0);
+        s_audioBufferArenaCount = audioBufferArenaCount;
+    }
+
+    void NowSoundGraph::SetUseLoopBank(bool useLoopBank)
+    {
+        Check(s_instance == nullptr);
+        s_useLoopBank = useLoopBank;
+    }
+
     void NowSoundGraph::InitializeInstance(
         int outputBinCount,
         float centralFrequency,
@@ -61,19 +69,50 @@ namespace NowSound
             fftSize);
     }
 
+    void NowSoundGraph::InitializeOfflineInstance(
+        int sampleRateHz,
+        int samplesPerQuantum,
+        int outputBinCount,
+        float centralFrequency,
+        int octaveDivisions,
+        int centralBinIndex,
+        int fftSize)
+    {
+        std::unique_ptr<NowSoundGraph> temp{ new NowSoundGraph() };
+        s_instance = std::move(temp);
+        s_instance.get()->InitializeOffline(
+            sampleRateHz,
+            samplesPerQuantum,
+            outputBinCount,
+            centralFrequency,
+            octaveDivisions,
+            centralBinIndex,
+            fftSize);
+    }
+
     NowSoundGraph::NowSoundGraph() :
         _audioGraphState{ NowSoundGraphState::GraphUninitialized },
+        _timeline{ MagicConstants::TimelineCapacity },
+        _analysisWorkerPool{ nullptr },
         _audioDeviceManager{},
+        _isOffline{ false },
+        _offlineInfo{},
+        _audioProcessorPlayer{ this },
+        _callbackTimings{},
+        _deadlineMissCount{ 0 },
+        _callbackEvent{},
         _audioAllocator{ nullptr },
+        _loggedForcedAllocationCount{ 0 },
         _nextTrackId{ TrackId::TrackIdUndefined },
         _nextAudioInputId{ AudioInputId::AudioInputUndefined },
         // JUCETODO: _inputDeviceIndicesToInitialize{},
         _audioInputs{ },
         _changingState{ false },
         _fftBinBounds{},
+        _fftBinMapping{},
         _fftSize{ -1 },
+        _loopBank{ nullptr },
         _stateMutex{},
-        _outputSignalMutex{},
         _logMessages{},
         _logMutex{},
         _juceGraphChanged{},
@@ -122,6 +161,54 @@ namespace NowSound
         return false; // never, never print anything (for now)
     }
 
+    void NowSoundGraph::RecordCallback(int64_t startNanoseconds, int64_t endNanoseconds, int sampleCount)
+    {
+        int64_t durationNanoseconds = endNanoseconds - startNanoseconds;
+        _callbackTimings.Record(durationNanoseconds);
+
+        if (Clock::IsInitialized())
+        {
+            int64_t deadlineNanoseconds = (int64_t)sampleCount * 1000000000 / Clock::Instance().SampleRateHz();
+            if (durationNanoseconds > deadlineNanoseconds)
+            {
+                _callbackEvent.Kind = TimelineEventKind::DeadlineMiss;
+                _callbackEvent.StartNanoseconds = startNanoseconds;
+                _callbackEvent.DurationNanoseconds = durationNanoseconds;
+                _callbackEvent.SampleTime = Clock::Instance().Now().Value();
+                _callbackEvent.DeadlineNanoseconds = deadlineNanoseconds;
+                _timeline.Record(_callbackEvent);
+                _deadlineMissCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // start afresh for the next callback
+        _callbackEvent.SlowNodeCount = 0;
+    }
+
+    void NowSoundGraph::NoteProcessBlock(const char* processorName, int64_t nanoseconds)
+    {
+        _callbackEvent.AddSlowNode(processorName, nanoseconds);
+    }
+
+    void NowSoundAudioProcessorPlayer::audioDeviceIOCallback(
+        const float** inputChannelData,
+        int numInputChannels,
+        float** outputChannelData,
+        int numOutputChannels,
+        int numSamples)
+    {
+        int64_t startNanoseconds = TimingHistogram::Now();
+
+        AudioProcessorPlayer::audioDeviceIOCallback(
+            inputChannelData,
+            numInputChannels,
+            outputChannelData,
+            numOutputChannels,
+            numSamples);
+
+        _graph->RecordCallback(startNanoseconds, TimingHistogram::Now(), numSamples);
+    }
+
     // AudioGraph NowSoundGraph::GetAudioGraph() const { return _audioGraph; }
 
     // AudioDeviceOutputNode NowSoundGraph::AudioDeviceOutputNode() const { return _deviceOutputNode; }
@@ -183,7 +270,7 @@ namespace NowSound
         // We don't need to synchronize when getting the log message, so long as we never call DropLogMessages()
         // concurrently with this.
         const std::wstring& message = _logMessages.at(logMessageIndex);
-        wcsncpy_s(buffer, (size_t)bufferCapacity, message.c_str(), message.size());
+        Platform::CopyWideString(buffer, (size_t)bufferCapacity, message.c_str(), message.size());
     }
 
     void NowSoundGraph::DropLogMessages(int32_t messageCountToDrop)
@@ -236,14 +323,14 @@ namespace NowSound
                     {
                         _exceptionMessage.insert(_exceptionMessage.end(), (char)result[i]);
                     }
-                    throw std::exception(_exceptionMessage.c_str());
+                    throw std::runtime_error(_exceptionMessage);
                 }
             }
 
             if (targetBufferSize != device->getCurrentBufferSizeSamples())
             {
                 // die horribly
-                throw std::exception("Can't set buffer size to target");
+                throw std::runtime_error("Can't set buffer size to target");
             }
         }
     }
@@ -300,7 +387,7 @@ namespace NowSound
             Log(L"Initialize(): end");
         }
 
-        // Set up the ASIO device, clock, and audio allocator.
+        // Set up the ASIO device.
         NowSoundGraphInfo info;
         {
             // we expect ASIO
@@ -309,7 +396,74 @@ namespace NowSound
             setBufferSize();
 
             info = Info();
+        }
+
+        // call the JUCE method because it returns a higher precision than NowSoundInfo.SampleRate
+        // TODO: consider making NowSoundInfo.SampleRate into a double
+        InitializeEngine(
+            info,
+            _audioDeviceManager.getCurrentAudioDevice()->getCurrentSampleRate(),
+            outputBinCount,
+            centralFrequency,
+            octaveDivisions,
+            centralBinIndex,
+            fftSize);
+
+        // and start everything!
+        _audioDeviceManager.getCurrentAudioDevice()->start(&_audioProcessorPlayer);
+
+        ChangeState(NowSoundGraphState::GraphRunning);
+    }
+
+    void NowSoundGraph::InitializeOffline(
+        int sampleRateHz,
+        int samplesPerQuantum,
+        int outputBinCount,
+        float centralFrequency,
+        int octaveDivisions,
+        int centralBinIndex,
+        int fftSize)
+    {
+        Log(L"InitializeOffline(): start");
+
+        PrepareToChangeState(NowSoundGraphState::GraphUninitialized);
 
+        Check(sampleRateHz > 0);
+        Check(samplesPerQuantum > 0);
+
+        // See Initialize(); the JUCE graph needs a MessageManager whether or not there is a device.
+        MessageManager::getInstance();
+
+        // No device; Info() reports this instead.  TODO: generalize channel count
+        _isOffline = true;
+        _offlineInfo = CreateNowSoundGraphInfo(sampleRateHz, 2, 32, 0, samplesPerQuantum);
+
+        InitializeEngine(
+            _offlineInfo,
+            sampleRateHz,
+            outputBinCount,
+            centralFrequency,
+            octaveDivisions,
+            centralBinIndex,
+            fftSize);
+
+        // Nothing starts; a NowSoundOfflineRenderer pulls blocks through the graph instead.
+        ChangeState(NowSoundGraphState::GraphRunning);
+
+        Log(L"InitializeOffline(): end");
+    }
+
+    void NowSoundGraph::InitializeEngine(
+        const NowSoundGraphInfo& info,
+        double sampleRate,
+        int outputBinCount,
+        float centralFrequency,
+        int octaveDivisions,
+        int centralBinIndex,
+        int fftSize)
+    {
+        // Set up the clock and audio allocator.
+        {
             // insist on stereo float samples.  TODO: generalize channel count
             // For right now let's just make absolutely sure these values are all precisely as we intend every time.
             Check(!Clock::IsInitialized());
@@ -324,16 +478,26 @@ namespace NowSound
 
             _audioAllocator = std::unique_ptr<BufferAllocator<float>>(new BufferAllocator<float>(
                 (int)(Clock::Instance().BytesPerSecond() * MagicConstants::AudioBufferSizeInSeconds.Value()),
-                MagicConstants::InitialAudioBufferCount));
+                MagicConstants::InitialAudioBufferCount,
+                BufferAllocator<float>::DefaultCheckFrees,
+                s_audioBufferArenaCount));
+
+            // keep spare buffers ready so recording never needs to allocate on the audio thread
+            _audioAllocator->StartRefillThread(
+                MagicConstants::AudioBufferLowWatermark,
+                MagicConstants::AudioBufferRefillTarget,
+                std::chrono::milliseconds((int)(MagicConstants::AudioBufferRefillInterval.Value() * 1000)));
         }
 
+        _fftSize = fftSize;
+
+        // A negative FFT size turns frequency tracking off altogether (see MeasurementAudioProcessor).
+        if (fftSize >= 0)
         {
             _fftBinBounds.resize(outputBinCount);
             Check(_fftBinBounds.capacity() == outputBinCount);
             Check(_fftBinBounds.size() == outputBinCount);
 
-            _fftSize = fftSize;
-
             // Initialize the bounds of the bins into which we collate FFT data.
             RosettaFFT::MakeBinBounds(
                 _fftBinBounds,
@@ -343,12 +507,26 @@ namespace NowSound
                 centralBinIndex,
                 Clock::Instance().SampleRateHz(),
                 fftSize);
+
+            // and compile them once, for all the trackers to share
+            _fftBinMapping = RosettaFFT::BinMappingMatrix(_fftBinBounds, fftSize / 2 + 1);
+
+            // and start the workers that will run all the trackers' transforms
+            _analysisWorkerPool.reset(new AnalysisWorkerPool(
+                MagicConstants::AnalysisWorkerCount,
+                MagicConstants::AnalysisPollInterval,
+                MagicConstants::AnalysisIdleTimeout,
+                &_timeline));
         }
 
         // Set up the audio processor graph and its related components.
         {
-            _audioProcessorPlayer.setProcessor(&_audioProcessorGraph);
-            _audioDeviceManager.addAudioCallback(&_audioProcessorPlayer);
+            // Offline, there is no device to call the player; the renderer calls the graph directly.
+            if (!_isOffline)
+            {
+                _audioProcessorPlayer.setProcessor(&_audioProcessorGraph);
+                _audioDeviceManager.addAudioCallback(&_audioProcessorPlayer);
+            }
 
             AudioProcessorGraph::AudioGraphIOProcessor* inputAudioProcessor =
                 new AudioProcessorGraph::AudioGraphIOProcessor(AudioProcessorGraph::AudioGraphIOProcessor::IODeviceType::audioInputNode);
@@ -364,17 +542,13 @@ namespace NowSound
             _audioProcessorGraph.setPlayConfigDetails(
                 info.ChannelCount,
                 info.ChannelCount,
-                // call the JUCE method because it returns a higher precision than NowSoundInfo.SampleRate
-                // TODO: consider making NowSoundInfo.SampleRate into a double
-                _audioDeviceManager.getCurrentAudioDevice()->getCurrentSampleRate(),
+                sampleRate,
                 info.SamplesPerQuantum);
 
             // TBD: is double better?  Single (e.g. float32) definitely best for starters though
             _audioProcessorGraph.setProcessingPrecision(AudioProcessor::singlePrecision);
 
-            _audioProcessorGraph.prepareToPlay(
-                _audioDeviceManager.getCurrentAudioDevice()->getCurrentSampleRate(),
-                info.SamplesPerQuantum);
+            _audioProcessorGraph.prepareToPlay(sampleRate, info.SamplesPerQuantum);
 
             _audioInputNodePtr = _audioProcessorGraph.addNode(inputAudioProcessor);
             _audioOutputNodePtr = _audioProcessorGraph.addNode(outputAudioProcessor);
@@ -388,17 +562,38 @@ namespace NowSound
                 // connect output mix to output
                 Check(JuceGraph().addConnection({ { _audioOutputMixNodePtr->nodeID, i }, { _audioOutputNodePtr->nodeID, i } }));
             }
-        }
 
-        // and start everything!
-        _audioDeviceManager.getCurrentAudioDevice()->start(&_audioProcessorPlayer);
+            if (s_useLoopBank)
+            {
+                // The bank takes every input's post-effects stereo pair (for its recording tracks), and sums all
+                // its tracks into the output mix.
+                int inputCount = (int)_audioInputs.size();
+                _loopBank = new NowSoundLoopBankAudioProcessor(this, inputCount, MagicConstants::LoopBankCapacity);
+                _loopBank->setPlayConfigDetails(inputCount * 2, 2, Info().SampleRateHz, Info().SamplesPerQuantum);
 
-        ChangeState(NowSoundGraphState::GraphRunning);
+                AudioProcessorGraph::Node::Ptr loopBankNode = _audioProcessorGraph.addNode(_loopBank);
+                _loopBank->SetNodeId(loopBankNode->nodeID);
+
+                for (int i = 0; i < inputCount; i++)
+                {
+                    AudioProcessorGraph::NodeID inputNodeId = _audioInputs[i]->OutputProcessor()->NodeId();
+                    Check(JuceGraph().addConnection({ { inputNodeId, 0 }, { loopBankNode->nodeID, i * 2 } }));
+                    Check(JuceGraph().addConnection({ { inputNodeId, 1 }, { loopBankNode->nodeID, i * 2 + 1 } }));
+                }
+                Check(JuceGraph().addConnection({ { loopBankNode->nodeID, 0 }, { _audioOutputMixNodePtr->nodeID, 0 } }));
+                Check(JuceGraph().addConnection({ { loopBankNode->nodeID, 1 }, { _audioOutputMixNodePtr->nodeID, 1 } }));
+            }
+        }
     }
 
     NowSoundGraphInfo NowSoundGraph::Info()
     {
         // TODO: verify not on audio graph thread
+        if (_isOffline)
+        {
+            return _offlineInfo;
+        }
+
         AudioIODevice* device = _audioDeviceManager.getCurrentAudioDevice();
 
         auto activeInputChannels = device->getActiveInputChannels();
@@ -451,17 +646,18 @@ namespace NowSound
     }
 #endif
 
-    const std::vector<RosettaFFT::FrequencyBinBounds>* NowSoundGraph::BinBounds() const { return &_fftBinBounds; }
+    const RosettaFFT::BinMappingMatrix* NowSoundGraph::BinMapping() const { return &_fftBinMapping; }
 
     int NowSoundGraph::FftSize() const { return _fftSize; }
 
+    AnalysisWorkerPool* NowSoundGraph::AnalysisPool() const { return _analysisWorkerPool.get(); }
+
     void NowSoundGraph::CreateNowSoundInputForChannel(int channel)
     {
         AudioInputId id(static_cast<AudioInputId>((int)(channel + 1)));
         NowSoundInputAudioProcessor* inputProcessor = new NowSoundInputAudioProcessor(
             this,
             id,
-            _audioAllocator.get(),
             channel);
 
         AddInputNodeToJuceGraph(inputProcessor, channel);
@@ -477,7 +673,7 @@ namespace NowSound
 
         Time<AudioSample> now = Clock::Instance().Now();
         ContinuousDuration<Beat> durationBeats = Clock::Instance().TimeToBeats(now);
-        int64_t completeBeats = (int64_t)durationBeats.Value();
+        int64_t completeBeats = Clock::Instance().TimeToCompleteBeats(now);
         int32_t beatsPerMeasure = Clock::Instance().BeatsPerMeasure();
         int64_t completeMeasures = completeBeats / beatsPerMeasure;
 
@@ -485,7 +681,7 @@ namespace NowSound
             now.Value(),
             durationBeats.Value(),
             Clock::Instance().BeatsPerMinute(),
-            durationBeats.Value() - (completeMeasures * beatsPerMeasure));
+            (completeBeats - (completeMeasures * beatsPerMeasure)) + Clock::Instance().TimeToFractionalBeat(now).Value());
 
         return timeInfo;
     }
@@ -538,14 +734,30 @@ namespace NowSound
         // TODO: verify not on audio graph thread
         Check(_audioGraphState == NowSoundGraphState::GraphRunning);
 
+        int64_t startNanoseconds = TimingHistogram::Now();
+
         // by construction this will be greater than TrackId::Undefined
         TrackId id = (TrackId)((int)_nextTrackId + 1);
         _nextTrackId = id;
 
         NowSoundTrackAudioProcessor* newTrack = Input(audioInputId)->CreateRecordingTrack(id);
 
-        // convert from audio input numbering (1-based) to channel id (0-based)
-        AddRecordingNodeToJuceGraph(newTrack, audioInputId);
+        if (_loopBank != nullptr && !_loopBank->IsFull())
+        {
+            // no JUCE graph change at all
+            _loopBank->AddTrack(newTrack);
+        }
+        else
+        {
+            // convert from audio input numbering (1-based) to channel id (0-based)
+            AddRecordingNodeToJuceGraph(newTrack, audioInputId);
+        }
+
+        _timeline.Record(TimelineEvent::Create(
+            TimelineEventKind::TrackCreated,
+            (int32_t)id,
+            startNanoseconds,
+            TimingHistogram::Now() - startNanoseconds));
 
         return id;
     }
@@ -560,16 +772,37 @@ namespace NowSound
         // wipe the weak reference first (it will be destructed after the Delete() anyway)
         _tracks.erase(trackId);
 
-        // delete the track; this drops all nodes it manages from the JUCE graph, including the track object itself
-        track->Delete();
+        if (_loopBank != nullptr && _loopBank->Contains(track))
+        {
+            // the bank owns it; no JUCE graph change at all
+            _loopBank->DeleteTrack(track);
+        }
+        else
+        {
+            // delete the track; this drops all nodes it manages from the JUCE graph, including the track object itself
+            track->Delete();
 
-        // this is an async update (if we weren't running JUCE in such a hacky way, we wouldn't need to know this)
-        JuceGraphChanged();
+            // this is an async update (if we weren't running JUCE in such a hacky way, we wouldn't need to know this)
+            JuceGraphChanged();
+        }
+    }
+
+    void NowSoundGraph::SeparateTrackFromLoopBank(TrackId trackId)
+    {
+        NowSoundTrackAudioProcessor* track = Track(trackId);
+        if (_loopBank == nullptr || !_loopBank->Contains(track))
+        {
+            return;
+        }
+
+        // the JUCE graph takes ownership from the bank; connect it as a recording track, since it may still be one
+        _loopBank->ReleaseTrack(track);
+        AddRecordingNodeToJuceGraph(track, track->InputId());
     }
 
     void NowSoundGraph::AddPluginSearchPath(LPWSTR wcharBuffer, int32_t bufferCapacity)
     {
-        String path(wcharBuffer);
+        String path(Platform::ToWideString(wcharBuffer).c_str());
         _audioPluginSearchPaths.push_back(path);
     }
 
@@ -630,7 +863,7 @@ namespace NowSound
         PluginDescription* desc = _knownPluginList.getType(((int)pluginId) - 1);
         const String& name = desc->name;
 
-        wcsncpy_s(wcharBuffer, (size_t)bufferCapacity, name.getCharPointer(), name.length());
+        Platform::CopyWideString(wcharBuffer, (size_t)bufferCapacity, name.toWideCharPointer(), (size_t)name.length());
     }
 
     struct FileNameComparer
@@ -644,12 +877,12 @@ namespace NowSound
     bool NowSoundGraph::LoadPluginPrograms(PluginId pluginId, LPWSTR pathnameBuffer)
     {
         // Verify that pathnameBuffer exists
-        String pathname{ pathnameBuffer };
+        std::wstring pathNameWString{ Platform::ToWideString(pathnameBuffer) };
+        String pathname{ pathNameWString.c_str() };
         File path{ pathname };
         if (!path.isDirectory())
         {
             Log(L"NowSoundGraph::LoadPluginPrograms(): path is not directory");
-            std::wstring pathNameWString{ pathnameBuffer };
             Log(pathNameWString);
             return false;
         }
@@ -688,7 +921,7 @@ namespace NowSound
     {
         const String& name = _loadedPluginPrograms[(int)pluginId - 1][(int)programId - 1].Name();
 
-        wcsncpy_s(wcharBuffer, (size_t)bufferCapacity, name.getCharPointer(), name.length());
+        Platform::CopyWideString(wcharBuffer, (size_t)bufferCapacity, name.toWideCharPointer(), (size_t)name.length());
     }
 
     void NowSoundGraph::AddInputNodeToJuceGraph(SpatialAudioProcessor* newProcessor, int inputChannel)
@@ -848,7 +1081,27 @@ namespace NowSound
         if (WasJuceGraphChanged())
         {
             // call the JUCE graph's handleAsyncUpdate() method directly.
+            int64_t startNanoseconds = TimingHistogram::Now();
             _audioProcessorGraph.handleAsyncUpdate();
+            _timeline.Record(TimelineEvent::Create(
+                TimelineEventKind::GraphRebuild,
+                0,
+                startNanoseconds,
+                TimingHistogram::Now() - startNanoseconds));
+        }
+
+        // Report any audio buffer allocations that the refill thread failed to get ahead of.
+        if (_audioAllocator != nullptr)
+        {
+            int forcedAllocationCount = _audioAllocator->ForcedAllocationCount();
+            if (forcedAllocationCount != _loggedForcedAllocationCount)
+            {
+                std::wstringstream wstr{};
+                wstr << L"NowSoundGraph::MessageTick(): audio buffer pool ran dry; "
+                    << forcedAllocationCount << L" forced allocations so far";
+                Log(wstr.str());
+                _loggedForcedAllocationCount = forcedAllocationCount;
+            }
         }
     }
 
@@ -875,6 +1128,103 @@ namespace NowSound
         outputMixProcessor->StopRecording();
     }
 
+    void NowSoundGraph::ForEachTimedProcessor(std::function<void(BaseAudioProcessor*, NowSoundProcessorKind, int32_t)> function)
+    {
+        for (NowSoundInputAudioProcessor* input : _audioInputs)
+        {
+            function(input, NowSoundProcessorKind::ProcessorInput, (int32_t)input->InputId());
+            function(input->OutputProcessor(), NowSoundProcessorKind::ProcessorInputMeasurement, (int32_t)input->InputId());
+        }
+
+        if (_loopBank != nullptr)
+        {
+            function(_loopBank, NowSoundProcessorKind::ProcessorLoopBank, 0);
+        }
+
+        for (const std::pair<const TrackId, NowSoundTrackAudioProcessor*>& entry : _tracks)
+        {
+            function(entry.second, NowSoundProcessorKind::ProcessorTrack, (int32_t)entry.first);
+            function(entry.second->OutputProcessor(), NowSoundProcessorKind::ProcessorTrackMeasurement, (int32_t)entry.first);
+        }
+
+        function(
+            dynamic_cast<MeasurementAudioProcessor*>(_audioOutputMixNodePtr->getProcessor()),
+            NowSoundProcessorKind::ProcessorOutputMix,
+            0);
+    }
+
+    NowSoundCallbackTimingInfo NowSoundGraph::GetProcessorTimings(void* processorTimingBuffer, int32_t processorTimingBufferCapacity)
+    {
+        Check(State() == NowSoundGraphState::GraphRunning);
+        Check(processorTimingBufferCapacity >= 0);
+
+        NowSoundProcessorTimingInfo* processorTimings = (NowSoundProcessorTimingInfo*)processorTimingBuffer;
+        int32_t processorCount = 0;
+        ForEachTimedProcessor([&](BaseAudioProcessor* processor, NowSoundProcessorKind kind, int32_t id)
+        {
+            if (processorCount < processorTimingBufferCapacity)
+            {
+                TimingSummary summary = processor->ProcessBlockTimings().Summarize();
+                processorTimings[processorCount] = CreateNowSoundProcessorTimingInfo(
+                    kind,
+                    id,
+                    summary.Count,
+                    (float)(summary.MeanNanoseconds / 1000),
+                    (float)summary.P99Nanoseconds / 1000,
+                    (float)summary.MaxNanoseconds / 1000);
+            }
+            processorCount++;
+        });
+
+        TimingSummary callbackSummary = _callbackTimings.Summarize();
+        float deadlineMicroseconds = (float)Info().SamplesPerQuantum * 1000000 / Info().SampleRateHz;
+        float meanMicroseconds = (float)(callbackSummary.MeanNanoseconds / 1000);
+        return CreateNowSoundCallbackTimingInfo(
+            callbackSummary.Count,
+            processorCount,
+            deadlineMicroseconds,
+            meanMicroseconds,
+            (float)callbackSummary.P99Nanoseconds / 1000,
+            (float)callbackSummary.MaxNanoseconds / 1000,
+            meanMicroseconds / deadlineMicroseconds,
+            _deadlineMissCount.load());
+    }
+
+    void NowSoundGraph::ResetProcessorTimings()
+    {
+        Check(State() == NowSoundGraphState::GraphRunning);
+
+        ForEachTimedProcessor([](BaseAudioProcessor* processor, NowSoundProcessorKind, int32_t)
+        {
+            processor->ProcessBlockTimings().Reset();
+        });
+        _callbackTimings.Reset();
+        _deadlineMissCount = 0;
+    }
+
+    void NowSoundGraph::WriteTimeline(LPWSTR fileName, int32_t fileNameLength)
+    {
+        Check(State() == NowSoundGraphState::GraphRunning);
+
+        std::stringstream trace{};
+        _timeline.WriteChromeTrace(trace);
+        std::string traceText = trace.str();
+
+        // createOutputStream() appends, so start from scratch
+        File file{ String{ Platform::ToWideString(fileName, (size_t)fileNameLength).c_str() } };
+        file.deleteFile();
+        if (auto fileStream = std::unique_ptr<FileOutputStream>(file.createOutputStream()))
+        {
+            fileStream->write(traceText.data(), traceText.size());
+        }
+        else
+        {
+            std::wstringstream wstr{};
+            wstr << L"NowSoundGraph::WriteTimeline(): could not open " << file.getFullPathName().toWideCharPointer();
+            Log(wstr.str());
+        }
+    }
+
     void NowSoundGraph::ShutdownInstance()
     {
         // SHUT. DOWN. EVERYTHING
@@ -893,6 +1243,11 @@ namespace NowSound
     // instance shutdown method for instance internal state
     void NowSoundGraph::Shutdown()
     {
+        if (_audioAllocator != nullptr)
+        {
+            _audioAllocator->StopRefillThread();
+        }
+
         _audioDeviceManager.removeAllChangeListeners();
         _audioDeviceManager.closeAudioDevice();
         _audioDeviceManager.removeAudioCallback(&_audioProcessorPlayer);
@@ -5,17 +5,21 @@
 
 #include "stdafx.h"
 
+#include <functional>
 #include <future>
 #include <vector>
 
 #include "stdint.h"
 
+#include "AnalysisWorkerPool.h"
 #include "BufferAllocator.h"
 #include "Check.h"
 #include "Histogram.h"
 #include "NowSoundLibTypes.h"
 #include "rosetta_fft.h"
 #include "SliceStream.h"
+#include "TimelineRecorder.h"
+#include "TimingHistogram.h"
 
 #include "JuceHeader.h"
 
@@ -24,7 +28,27 @@ namespace NowSound
     class BaseAudioProcessor;
     class SpatialAudioProcessor;
     class NowSoundInputAudioProcessor;
+    class NowSoundLoopBankAudioProcessor;
     class NowSoundTrackAudioProcessor;
+    class NowSoundGraph;
+
+    // Couples the device manager to the audio processor graph, as juce::AudioProcessorPlayer does, and tells the
+    // graph how long each device callback took.
+    class NowSoundAudioProcessorPlayer : public juce::AudioProcessorPlayer
+    {
+    private:
+        NowSoundGraph* _graph;
+
+    public:
+        NowSoundAudioProcessorPlayer(NowSoundGraph* graph) : _graph{ graph } {}
+
+        virtual void audioDeviceIOCallback(
+            const float** inputChannelData,
+            int numInputChannels,
+            float** outputChannelData,
+            int numOutputChannels,
+            int numSamples) override;
+    };
 
     class PluginProgram
     {
@@ -54,6 +78,20 @@ namespace NowSound
             int centralBinIndex,
             int fftSize);
 
+        // Initialize the audio graph subsystem with no audio device, at the given sample rate and block size.
+        // Nothing calls the graph until a NowSoundOfflineRenderer pulls blocks through it, which it may do as fast
+        // as the machine allows; this is for benchmarking and regression testing without a sound card.
+        // A negative fftSize turns off frequency tracking.
+        // Graph must be Uninitialized.  On completion, graph becomes Running.
+        void InitializeOffline(
+            int sampleRateHz,
+            int samplesPerQuantum,
+            int outputBinCount,
+            float centralFrequency,
+            int octaveDivisions,
+            int centralBinIndex,
+            int fftSize);
+
         // Get the current state of the audio graph; intended to be efficiently pollable by the client.
         // This is one of the only two methods that may be called in any state whatoever.
         // All other methods declare which state the graph must be in to call the method, and the state
@@ -116,6 +154,20 @@ namespace NowSound
         // Stop recording and close the file; if not recording, this is ignored.
         void StopRecording();
 
+        // Get how long the audio callbacks, and each audio processor's part of them, have taken.
+        // processorTimingBuffer must hold processorTimingBufferCapacity NowSoundProcessorTimingInfos; as many
+        // processors' timings as fit are written there, and the result's ProcessorCount says how many exist.
+        // Graph must be Running.
+        NowSoundCallbackTimingInfo GetProcessorTimings(void* processorTimingBuffer, int32_t processorTimingBufferCapacity);
+
+        // Forget all timings so far, so that the next GetProcessorTimings() reports only what happens from now on.
+        // Graph must be Running.
+        void ResetProcessorTimings();
+
+        // Write the timeline's recent events to the given file, as Chrome trace-event JSON.
+        // Graph must be Running.
+        void WriteTimeline(LPWSTR fileName, int32_t fileNameLength);
+
     public: // Plugin support
 
         // Plugin searching requires setting paths to search.
@@ -160,9 +212,24 @@ namespace NowSound
         // Set minimum buffer size in the device manager.
         void setBufferSize();
 
+        // Set up everything but the audio device: clock, allocator, FFT bins, and the JUCE graph with its inputs
+        // and output mix.  Shared by Initialize() and InitializeOffline().
+        void InitializeEngine(
+            const NowSoundGraphInfo& info,
+            double sampleRate,
+            int outputBinCount,
+            float centralFrequency,
+            int octaveDivisions,
+            int centralBinIndex,
+            int fftSize);
+
         // Was the JUCE audio processor graph changed since the last call to this method?
         bool WasJuceGraphChanged();
 
+        // Call the given function on every processor whose processBlock calls are timed, with the kind and ID it
+        // is reported under.
+        void ForEachTimedProcessor(std::function<void(BaseAudioProcessor*, NowSoundProcessorKind, int32_t)> function);
+
         // Add the connections of a SpatialAudioProcessor node.
         // This returns the input node so that input connections can be set up.
         // If isRecording, the returned node will have two input connections; otherwise, it will have one.
@@ -174,6 +241,12 @@ namespace NowSound
         // The singleton (for now) graph; created by Initialize(), destroyed by Shutdown().
         static ::std::unique_ptr<NowSoundGraph> s_instance;
 
+        // How many audio buffers the next graph to be initialized carves out of an arena.
+        static int s_audioBufferArenaCount;
+
+        // Does the next graph to be initialized render its plugin-free tracks in a loop bank?
+        static bool s_useLoopBank;
+
         // Fixed capacity for log messages (between calls to DropLogMessagesUpTo()).
         const int32_t s_logMessageCapacity = 10000;
 
@@ -184,12 +257,36 @@ namespace NowSound
         // The mutex used when updating log state variables.
         std::mutex _logMutex;
 
+        // Recent deadline misses, track creations, graph rebuilds and FFT bursts.  Declared before the analysis
+        // workers, which record into it, so that it is destroyed after them.
+        TimelineRecorder _timeline;
+
+        // The threads which run the frequency trackers' FFTs.  Declared before the JUCE objects, so that it is
+        // destroyed after them (and hence after all the trackers, which are owned by processors in the JUCE graph).
+        std::unique_ptr<AnalysisWorkerPool> _analysisWorkerPool;
+
         // The AudioDeviceManager held by this Graph.
         // This is conceptually a singleton (just as the NowSoundGraph is), but we scope it within this type.
         juce::AudioDeviceManager _audioDeviceManager;
 
+        // Was this graph initialized offline (with no audio device)?
+        bool _isOffline;
+
+        // If _isOffline, the info Info() returns, as there is no device to ask.
+        NowSoundGraphInfo _offlineInfo;
+
         // Callback object which couples the device manager to the audio processor graph.
-        juce::AudioProcessorPlayer _audioProcessorPlayer;
+        NowSoundAudioProcessorPlayer _audioProcessorPlayer;
+
+        // How long each audio callback has taken.
+        TimingHistogram _callbackTimings;
+
+        // The number of audio callbacks which have overrun their deadline.
+        std::atomic<int64_t> _deadlineMissCount;
+
+        // The deadline miss the current audio callback will be recorded as, if it is one; the processors note their
+        // durations here as they finish.  Audio thread only.
+        TimelineEvent _callbackEvent;
 
         // The audio processor graph.
         juce::AudioProcessorGraph _audioProcessorGraph;
@@ -203,14 +300,6 @@ namespace NowSound
         // Ptr to the actual output node.
         juce::AudioProcessorGraph::Node::Ptr _audioOutputNodePtr;
 
-        // Information about the output signal.
-        // Atomically updated using the associated mutex.
-        NowSoundSignalInfo _outputSignalInfo;
-
-        // Mutex guarding _outputSignalInfo, which may be polled from the UI thread while being
-        // updated on the audio thread.
-        std::mutex _outputSignalMutex;
-
         // Is this graph changing state? (Prevent re-entrant state changing methods.)
         bool _changingState;
 
@@ -220,6 +309,9 @@ namespace NowSound
         // First, an allocator for 128-second 48Khz stereo float sample buffers.
         std::unique_ptr<BufferAllocator<float>> _audioAllocator;
 
+        // The audio allocator's ForcedAllocationCount as of the last time MessageTick logged it.
+        int _loggedForcedAllocationCount;
+
         // The next TrackId to be allocated.
         TrackId _nextTrackId;
 
@@ -229,6 +321,9 @@ namespace NowSound
         // The vector of frequency bins.
         ::std::vector<RosettaFFT::FrequencyBinBounds> _fftBinBounds;
 
+        // _fftBinBounds compiled for applying to FFT magnitudes; shared by every frequency tracker.
+        RosettaFFT::BinMappingMatrix _fftBinMapping;
+
         // The FFT size.
         int _fftSize;
 
@@ -244,9 +339,13 @@ namespace NowSound
         int _logThrottlingCounter;
 
         // The collection of all tracks.
-        // Note that this vector does not own the processors; the JUCE graph does.
+        // Note that this vector does not own the processors; the JUCE graph (or the loop bank) does.
         std::map<TrackId, NowSoundTrackAudioProcessor*> _tracks;
 
+        // The node which renders all tracks without plugins, if s_useLoopBank was set at initialization; else null.
+        // Not owned; the JUCE graph owns it.
+        NowSoundLoopBankAudioProcessor* _loopBank;
+
         // True if the JUCE graph was changed.
         bool _juceGraphChanged;
 
@@ -284,11 +383,24 @@ namespace NowSound
 
         void DeleteTrack(TrackId id);
 
+        // Make sure the track has its own JUCE nodes, moving it out of the loop bank if it is there.
+        // Tracks need this before plugins can be connected to them.
+        void SeparateTrackFromLoopBank(TrackId id);
+
     public: // Implementation methods used from elsewhere in the library
 
         // The static instance of the graph.  We may eventually have multiple.
         static NowSoundGraph* Instance();
 
+        // Back the first audioBufferArenaCount audio buffers of graphs initialized from now on with a single locked,
+        // prefaulted (and ideally huge-page) memory arena, rather than the heap; 0 turns the arena off, as it is by
+        // default.  Graph must be Uninitialized.
+        static void SetAudioBufferArenaCount(int audioBufferArenaCount);
+
+        // Render the plugin-free tracks of graphs initialized from now on in a single loop bank node, rather than
+        // two JUCE nodes per track; off by default.  Graph must be Uninitialized.
+        static void SetUseLoopBank(bool useLoopBank);
+
         // Create the singleton graph instance and initialize it.
         static void InitializeInstance(
             int outputBinCount,
@@ -297,6 +409,19 @@ namespace NowSound
             int centralBinIndex,
             int fftSize);
 
+        // Create the singleton graph instance and initialize it offline.
+        static void InitializeOfflineInstance(
+            int sampleRateHz,
+            int samplesPerQuantum,
+            int outputBinCount,
+            float centralFrequency,
+            int octaveDivisions,
+            int centralBinIndex,
+            int fftSize);
+
+        // Was this graph initialized offline?
+        bool IsOffline() const { return _isOffline; }
+
         // Record this log message.
         // These messages can be queried via the external NowSoundGraphAPI, for scenarios when native debugging is
         // inaccessible (such as VS2019 debugging Unity with the Mono runtime).
@@ -309,12 +434,15 @@ namespace NowSound
         // Create a NowSoundInputAudioProcessor for the specified channel.
         void CreateNowSoundInputForChannel(int channel);
 
-        // Access the vector of frequency bins, when generating frequency histograms.
-        const std::vector<RosettaFFT::FrequencyBinBounds>* BinBounds() const;
+        // Access the mapping from FFT magnitudes to frequency bins, when generating frequency histograms.
+        const RosettaFFT::BinMappingMatrix* BinMapping() const;
 
         // Access to the FFT size.
         int FftSize() const;
 
+        // Access the pool which runs the frequency trackers' FFTs.
+        AnalysisWorkerPool* AnalysisPool() const;
+
         // Access to the audio graph for node instantiation.
         juce::AudioProcessorGraph& JuceGraph();
 
@@ -342,6 +470,15 @@ namespace NowSound
 
         bool CheckLogThrottle();
 
+        // Record that an audio callback (a device callback, or an offline renderer's block) of sampleCount samples
+        // ran between the given TimingHistogram::Now() times; if it took longer than sampleCount samples last,
+        // record a DeadlineMiss in the timeline.  Audio thread only.
+        void RecordCallback(int64_t startNanoseconds, int64_t endNanoseconds, int sampleCount);
+
+        // Note that the named processor's processBlock took the given time, in case the callback misses its deadline.
+        // Audio thread only.
+        void NoteProcessBlock(const char* processorName, int64_t nanoseconds);
+
         // Record that an async update happened (e.g. a change to the JUCE audio processor graph, that needs to cause
         // the audio rendering graph to be recreated).
         // If we weren't running JUCE in such a hacky way under Unity, this wouldn't be needed.
@@ -6,7 +6,6 @@
 #include <algorithm>
 
 #include "Clock.h"
-#include "GetBuffer.h"
 #include "Histogram.h"
 #include "MagicConstants.h"
 #include "NowSoundLib.h"
@@ -15,23 +14,21 @@
 #include "NowSoundInput.h"
 
 using namespace std;
-using namespace winrt;
-
-using namespace winrt::Windows::Foundation;
 
 namespace NowSound
 {
     NowSoundInputAudioProcessor::NowSoundInputAudioProcessor(
         NowSoundGraph* nowSoundGraph,
         AudioInputId inputId,
-        BufferAllocator<float>* audioAllocator,
         int channel)
         : SpatialAudioProcessor(nowSoundGraph, MakeName(L"Input ", (int)inputId), /*initialVolume*/1.0, /*initialPan*/0.5),
         _audioInputId{ inputId },
         _channel{ channel },
-        _incomingAudioStream{ 0, Clock::Instance().ChannelCount(), audioAllocator, Clock::Instance().SampleRateHz(), /*useExactLoopingMapper:*/false },
-        _rawInputHistogram{ new Histogram((int)Clock::Instance().TimeToSamples(MagicConstants::RecentVolumeDuration).Value()) },
-        _mutex{}
+        _incomingAudioStream{ 0, Clock::Instance().ChannelCount(), Clock::Instance().SampleRateHz() },
+        _rawInputHistogram{ new BlockHistogram(
+            (int)Clock::Instance().TimeToSamples(MagicConstants::RecentVolumeDuration).Value(),
+            MagicConstants::RecentVolumeBlockCapacity) },
+        _rawInputSnapshot{ 3 }
     {
     }
 
@@ -55,15 +52,15 @@ namespace NowSound
 
     NowSoundSignalInfo NowSoundInputAudioProcessor::RawSignalInfo()
     {
-        std::lock_guard<std::mutex> guard(_mutex);
-        float min = _rawInputHistogram->Min();
-        float max = _rawInputHistogram->Max();
-        float avg = _rawInputHistogram->Average();
-        return CreateNowSoundSignalInfo(min, max, avg);
+        float minMaxAvg[3];
+        _rawInputSnapshot.Read(minMaxAvg, 3);
+        return CreateNowSoundSignalInfo(minMaxAvg[0], minMaxAvg[1], minMaxAvg[2]);
     }
 
     void NowSoundInputAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, MidiBuffer& midiBuffer)
     {
+        ProcessBlockTimer timer{ this };
+
         // temporary debugging code: see if processBlock is ever being called under Holofunk
         if (CheckLogThrottle()) {
             std::wstringstream wstr{};
@@ -85,10 +82,9 @@ namespace NowSound
         const float* buffer = audioBuffer.getReadPointer(0);
 
         // update raw input data because need ALL THE SIGNAL DATA
-        for (int i = 0; i < audioBuffer.getNumSamples(); i++)
-        {
-            _rawInputHistogram->Add(std::abs(buffer[i]));
-        }
+        _rawInputHistogram->AddBlock(buffer, audioBuffer.getNumSamples(), /*absoluteValue:*/ true);
+        float minMaxAvg[3] = { _rawInputHistogram->Min(), _rawInputHistogram->Max(), _rawInputHistogram->Average() };
+        _rawInputSnapshot.Publish(minMaxAvg, 3);
 
         // TODO: actually record into the bounded input stream!  if we decide that lookback is actually needed again.
 
@@ -12,6 +12,7 @@
 #include "BufferAllocator.h"
 #include "Check.h"
 #include "Histogram.h"
+#include "MeteringSnapshot.h"
 #include "NowSoundLibTypes.h"
 #include "Option.h"
 #include "SliceStream.h"
@@ -37,25 +38,28 @@ namespace NowSound
         // (Not really clear why latency compensation should be needed for NowSoundApp which shouldn't really
         // have any problematic latency... but this was needed for gesture latency compensation with Kinect,
         // so let's at least experiment with it.)
-        BufferedSliceStream<AudioSample, float> _incomingAudioStream;
+        // This is a ring, so bounding it costs nothing per block.
+        RingSliceStream<AudioSample, float> _incomingAudioStream;
 
-        // Volume histogram for recording the raw input volume.
-        std::unique_ptr<Histogram> _rawInputHistogram;
+        // Volume histogram for recording the raw input volume; touched only by the audio thread.
+        std::unique_ptr<BlockHistogram> _rawInputHistogram;
 
-        // Mutex to use when returning or updating signal info; to prevent racing between data access and update.
-        std::mutex _mutex;
+        // The raw input histogram's min, max and average as of the last block, published for RawSignalInfo().
+        MeteringSnapshot _rawInputSnapshot;
 
     public:
         // Construct a NowSoundInput.
         NowSoundInputAudioProcessor(
             NowSoundGraph* audioGraph,
             AudioInputId audioInputId,
-            BufferAllocator<float>* audioAllocator,
             int channel);
 
         // Process input audio by recording it into the (bounded) incomingAudioStream.
         virtual void processBlock(juce::AudioBuffer<float>& audioBuffer, juce::MidiBuffer& midiBuffer);
         
+        // The ID of this input.
+        AudioInputId InputId() const { return _audioInputId; }
+
         // Get information about this input.
         NowSoundSpatialParameters SpatialParameters();
 
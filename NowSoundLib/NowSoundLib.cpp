@@ -45,6 +45,18 @@ namespace NowSound
         }
     }
 
+    void NowSoundGraph_SetAudioBufferArenaCount(int32_t audioBufferArenaCount)
+    {
+        Check(NowSoundGraph_State() == NowSoundGraphState::GraphUninitialized);
+        NowSoundGraph::SetAudioBufferArenaCount(audioBufferArenaCount);
+    }
+
+    void NowSoundGraph_SetUseLoopBank(bool useLoopBank)
+    {
+        Check(NowSoundGraph_State() == NowSoundGraphState::GraphUninitialized);
+        NowSoundGraph::SetUseLoopBank(useLoopBank);
+    }
+
     void NowSoundGraph_InitializeInstance(
         int outputBinCount,
         float centralFrequency,
@@ -179,10 +191,10 @@ namespace NowSound
         NowSoundGraph::Instance()->SetBeatsPerMinute(bpm);
     }
 
-    void NowSoundGraph_GetInputFrequencies(AudioInputId audioInputId, void* floatBuffer, int32_t floatBufferCapacity)
+    int64_t NowSoundGraph_GetInputFrequencies(AudioInputId audioInputId, void* floatBuffer, int32_t floatBufferCapacity)
     {
         Check(NowSoundGraph::Instance() != nullptr);
-        NowSoundGraph::Instance()->Input(audioInputId)->GetFrequencies(floatBuffer, floatBufferCapacity);
+        return NowSoundGraph::Instance()->Input(audioInputId)->GetFrequencies(floatBuffer, floatBufferCapacity).Value();
     }
 
     NowSoundSpatialParameters NowSoundGraph_SpatialParameters(AudioInputId audioInputId)
@@ -220,6 +232,24 @@ namespace NowSound
         NowSoundGraph::Instance()->StopRecording();
     }
 
+    NowSoundCallbackTimingInfo NowSoundGraph_GetProcessorTimings(void* processorTimingBuffer, int32_t processorTimingBufferCapacity)
+    {
+        Check(NowSoundGraph::Instance() != nullptr);
+        return NowSoundGraph::Instance()->GetProcessorTimings(processorTimingBuffer, processorTimingBufferCapacity);
+    }
+
+    void NowSoundGraph_ResetProcessorTimings()
+    {
+        Check(NowSoundGraph::Instance() != nullptr);
+        NowSoundGraph::Instance()->ResetProcessorTimings();
+    }
+
+    void NowSoundGraph_WriteTimeline(LPWSTR fileName, int32_t fileNameLength)
+    {
+        Check(NowSoundGraph::Instance() != nullptr);
+        NowSoundGraph::Instance()->WriteTimeline(fileName, fileNameLength);
+    }
+
     // Plugin searching requires setting paths to search.
     // TODO: make this use the idiom for passing in strings rather than StringBuilders.
     void NowSoundGraph_AddPluginSearchPath(LPWSTR wcharBuffer, int32_t bufferCapacity)
@@ -363,16 +393,17 @@ namespace NowSound
         NowSoundGraph::Instance()->Track(trackId)->FinishRecording();
     }
 
-    void NowSoundTrack_GetFrequencies(TrackId trackId, void* floatBuffer, int32_t floatBufferCapacity)
+    int64_t NowSoundTrack_GetFrequencies(TrackId trackId, void* floatBuffer, int32_t floatBufferCapacity)
     {
         Check(NowSoundGraph::Instance() != nullptr);
         if (NowSoundGraph::Instance()->TrackIsDefined(trackId))
         {
-            NowSoundGraph::Instance()->Track(trackId)->GetFrequencies(floatBuffer, floatBufferCapacity);
+            return NowSoundGraph::Instance()->Track(trackId)->GetFrequencies(floatBuffer, floatBufferCapacity).Value();
         }
         else
         {
             NowSoundGraph::Instance()->Log(L"Track ID *WAS NOT DEFINED* in NowSoundTrack_GetFrequencies");
+            return 0;
         }
     }
 
@@ -415,6 +446,8 @@ namespace NowSound
     PluginInstanceIndex NowSoundTrack_AddPluginInstance(TrackId trackId, PluginId pluginId, ProgramId programId, int32_t dryWet_0_100)
     {
         Check(NowSoundGraph::Instance() != nullptr);
+        // plugins need JUCE connections, which tracks in the loop bank don't have
+        NowSoundGraph::Instance()->SeparateTrackFromLoopBank(trackId);
         return NowSoundGraph::Instance()->Track(trackId)->AddPluginInstance(pluginId, programId, dryWet_0_100);
     }
 
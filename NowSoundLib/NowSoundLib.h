@@ -11,6 +11,7 @@
 #include "BufferAllocator.h"
 #include "Check.h"
 #include "NowSoundLibTypes.h"
+#include "Platform.h"
 #include "SliceStream.h"
 
 namespace NowSound
@@ -33,32 +34,42 @@ namespace NowSound
         // TODO: consider ditching the wrapper class here and having top-level global functions so extern "C" would actually work properly.
 
         // Test method only: get a predefined NowSound_GraphInfo instance to test P/Invoke serialization.
-        __declspec(dllexport) NowSoundGraphInfo NowSoundGraph_GetStaticGraphInfo();
+        NOWSOUND_EXPORT NowSoundGraphInfo NowSoundGraph_GetStaticGraphInfo();
 
         // Test method only: get a predefined NowSound_TimeInfo instance to test P/Invoke serialization.
-        __declspec(dllexport) NowSoundTimeInfo NowSoundGraph_GetStaticTimeInfo();
+        NOWSOUND_EXPORT NowSoundTimeInfo NowSoundGraph_GetStaticTimeInfo();
 
         // Get the current state of the audio graph; intended to be efficiently pollable by the client.
         // This is the only method that may be called in any state whatoever.
-        __declspec(dllexport) NowSoundGraphState NowSoundGraph_State();
+        NOWSOUND_EXPORT NowSoundGraphState NowSoundGraph_State();
 
         // Get the number of log messages.
-        __declspec(dllexport) NowSoundLogInfo NowSoundGraph_LogInfo();
+        NOWSOUND_EXPORT NowSoundLogInfo NowSoundGraph_LogInfo();
 
         // Get the message with a particular (zero-based) index; must be between (inclusive) the indices last returned from NowSoundGraph_LogInfo().
         // Note that calls to this method must never be interleaved with calls to the NowSoundGraph_DropLogMessagesUpTo method; these
         // methods are not thread-safe with respect to each other.
-        __declspec(dllexport) void NowSoundGraph_GetLogMessage(int32_t logMessageIndex, LPWSTR wcharBuffer, int32_t bufferCapacity);
+        NOWSOUND_EXPORT void NowSoundGraph_GetLogMessage(int32_t logMessageIndex, LPWSTR wcharBuffer, int32_t bufferCapacity);
 
         // Drop this many log messages.
-        __declspec(dllexport) void NowSoundGraph_DropLogMessages(int32_t messageCountToDrop);
+        NOWSOUND_EXPORT void NowSoundGraph_DropLogMessages(int32_t messageCountToDrop);
 
         // Log the current JUCE audio processor graph connections.
-        __declspec(dllexport) void NowSoundGraph_LogConnections();
+        NOWSOUND_EXPORT void NowSoundGraph_LogConnections();
+
+        // Back the first audioBufferArenaCount audio buffers of the graph with a single locked, prefaulted (and
+        // ideally huge-page) memory arena, so that recording into them never page faults; 0 turns the arena off, as
+        // it is by default.  The arena's memory is all committed when the graph is initialized.
+        // Graph must be Uninitialized; the setting applies to every graph initialized afterwards.
+        NOWSOUND_EXPORT void NowSoundGraph_SetAudioBufferArenaCount(int32_t audioBufferArenaCount);
+
+        // Render all tracks without plugins in a single loop bank node, rather than two JUCE nodes per track; off by
+        // default.  Graph must be Uninitialized; the setting applies to every graph initialized afterwards.
+        NOWSOUND_EXPORT void NowSoundGraph_SetUseLoopBank(bool useLoopBank);
 
         // Initialize the audio graph subsystem such that device information can be queried.
         // Graph must be Uninitialized.  On completion, graph becomes Initialized.
-        __declspec(dllexport) void NowSoundGraph_InitializeInstance(
+        NOWSOUND_EXPORT void NowSoundGraph_InitializeInstance(
             // How many output bins in the (logarithmic) frequency histogram?
             int outputBinCount,
             // What central frequency to use for the histogram?
@@ -72,97 +83,115 @@ namespace NowSound
 
         // Get the info for the created graph.
         // Graph must be at least Created.
-        __declspec(dllexport) NowSoundGraphInfo NowSoundGraph_Info();
+        NOWSOUND_EXPORT NowSoundGraphInfo NowSoundGraph_Info();
 
         // Get the current pre-effects (raw) signal from the given input.
-        __declspec(dllexport) NowSoundSignalInfo NowSoundGraph_RawInputSignalInfo(AudioInputId audioInputId);
+        NOWSOUND_EXPORT NowSoundSignalInfo NowSoundGraph_RawInputSignalInfo(AudioInputId audioInputId);
 
         // Get the current info for the post-effects signal from the given input.
-        __declspec(dllexport) NowSoundSignalInfo NowSoundGraph_InputSignalInfo(AudioInputId audioInputId);
+        NOWSOUND_EXPORT NowSoundSignalInfo NowSoundGraph_InputSignalInfo(AudioInputId audioInputId);
 
         // Get the current info for the graph's final mixed output (channel 0 only, currently).
-        __declspec(dllexport) NowSoundSignalInfo NowSoundGraph_OutputSignalInfo();
+        NOWSOUND_EXPORT NowSoundSignalInfo NowSoundGraph_OutputSignalInfo();
 
         // Get the ID of the given device.
         // Graph must be at least Initialized.
-        // JUCETODO: __declspec(dllexport) void NowSoundGraph_InputDeviceId(int deviceIndex, LPWSTR wcharBuffer, int bufferCapacity);
+        // JUCETODO: NOWSOUND_EXPORT void NowSoundGraph_InputDeviceId(int deviceIndex, LPWSTR wcharBuffer, int bufferCapacity);
 
         // Get the name of the given device.
         // Graph must be at least Initialized.
-        // JUCETODO: __declspec(dllexport) void NowSoundGraph_InputDeviceName(int deviceIndex, LPWSTR wcharBuffer, int bufferCapacity);
+        // JUCETODO: NOWSOUND_EXPORT void NowSoundGraph_InputDeviceName(int deviceIndex, LPWSTR wcharBuffer, int bufferCapacity);
 
         // Initialize the given device, given its index (as passed to InputDeviceInfo); returns the AudioInputId of the
         // input device.  If the input device has multiple channels, multiple consecutive AudioInputIds will be allocated,
         // but only the first will be returned.
-        // JUCETODO: __declspec(dllexport) void NowSoundGraph_InitializeDeviceInputs(int deviceIndex);
+        // JUCETODO: NOWSOUND_EXPORT void NowSoundGraph_InitializeDeviceInputs(int deviceIndex);
 
         // Get the time info for the created graph.
         // Graph must be at least Created; time will not be running until the graph is Running.
-        __declspec(dllexport) NowSoundTimeInfo NowSoundGraph_TimeInfo();
+        NOWSOUND_EXPORT NowSoundTimeInfo NowSoundGraph_TimeInfo();
 
         // Set the BPM. Only functions when there are no tracks at all.
-        __declspec(dllexport) void NowSoundGraph_SetBeatsPerMinute(float bpm);
+        NOWSOUND_EXPORT void NowSoundGraph_SetBeatsPerMinute(float bpm);
 
         // Get the current input frequency histogram (post-effects); LPWSTR must actually reference a float buffer of the
         // same length as the outputBinCount argument passed to InitializeFFT, but must be typed as LPWSTR
         // and must have a capacity represented in two-byte wide characters (to match the P/Invoke style of
         // "pass in StringBuilder", known to work well).
-        __declspec(dllexport) void NowSoundGraph_GetInputFrequencies(AudioInputId audioInputId, void* floatBuffer, int32_t floatBufferCapacity);
+        // Returns the audio sample time at which the histogram's audio ended (0 if there is no histogram yet), so the
+        // caller can tell how fresh it is.
+        NOWSOUND_EXPORT int64_t NowSoundGraph_GetInputFrequencies(AudioInputId audioInputId, void* floatBuffer, int32_t floatBufferCapacity);
 
         // Create a new track and begin recording.
-        __declspec(dllexport) TrackId NowSoundGraph_CreateRecordingTrackAsync(AudioInputId audioInputId);
+        NOWSOUND_EXPORT TrackId NowSoundGraph_CreateRecordingTrackAsync(AudioInputId audioInputId);
 
         // Delete this Track; after this, calling any methods with this TrackID will cause contract failure.
-        void __declspec(dllexport) NowSoundGraph_DeleteTrack(TrackId trackId);
+        void NOWSOUND_EXPORT NowSoundGraph_DeleteTrack(TrackId trackId);
 
         // Call this regularly from the "message thread".
         // Terrible hack to work around message pump issues.
-        __declspec(dllexport) void NowSoundGraph_MessageTick();
+        NOWSOUND_EXPORT void NowSoundGraph_MessageTick();
 
         // Start recording to the given file (WAV format); if already recording, this is ignored.
-        __declspec(dllexport) void NowSoundGraph_StartRecording(LPWSTR fileName, int32_t fileNameLength);
+        NOWSOUND_EXPORT void NowSoundGraph_StartRecording(LPWSTR fileName, int32_t fileNameLength);
 
         // Stop recording and close the file; if not recording, this is ignored.
-        __declspec(dllexport) void NowSoundGraph_StopRecording();
+        NOWSOUND_EXPORT void NowSoundGraph_StopRecording();
+
+        // Get how long the audio callbacks, and each audio processor's part of them, have taken: the mean, 99th
+        // percentile and maximum times, and the callbacks' CPU load against their deadline.  processorTimingBuffer
+        // must actually reference a buffer of processorTimingBufferCapacity NowSoundProcessorTimingInfo structs,
+        // into which as many processors' timings as fit are written; the result's ProcessorCount says how many
+        // processors there are.
+        NOWSOUND_EXPORT NowSoundCallbackTimingInfo NowSoundGraph_GetProcessorTimings(void* processorTimingBuffer, int32_t processorTimingBufferCapacity);
+
+        // Forget all timings so far, so that NowSoundGraph_GetProcessorTimings reports only what happens from now on
+        // (for instance, to measure the steady state after adding some tracks).
+        NOWSOUND_EXPORT void NowSoundGraph_ResetProcessorTimings();
+
+        // Write the recent timeline -- callbacks which missed their deadline (with the processors that were slowest
+        // in each), track creations, graph rebuilds and FFT bursts -- to the given file, as Chrome trace-event JSON
+        // (viewable in chrome://tracing or Perfetto).
+        NOWSOUND_EXPORT void NowSoundGraph_WriteTimeline(LPWSTR fileName, int32_t fileNameLength);
 
         // Plugin searching requires setting paths to search.
         // TODO: make this use the idiom for passing in strings rather than StringBuilders.
-        __declspec(dllexport) void NowSoundGraph_AddPluginSearchPath(LPWSTR wcharBuffer, int32_t bufferCapacity);
+        NOWSOUND_EXPORT void NowSoundGraph_AddPluginSearchPath(LPWSTR wcharBuffer, int32_t bufferCapacity);
 
         // After setting one or more search paths, actually search.
         // TODO: make this asynchronous.
         // Returns true if no errors in searching, or false if there were errors (printed to debug log, hopefully).
-        __declspec(dllexport) bool NowSoundGraph_SearchPluginsSynchronously();
+        NOWSOUND_EXPORT bool NowSoundGraph_SearchPluginsSynchronously();
 
         // How many plugins?
-        __declspec(dllexport) int NowSoundGraph_PluginCount();
+        NOWSOUND_EXPORT int NowSoundGraph_PluginCount();
 
         // Get the name of the Nth plugin. Note that IDs are 1-based.
-        __declspec(dllexport) void NowSoundGraph_PluginName(PluginId pluginId, LPWSTR wcharBuffer, int32_t bufferCapacity);
+        NOWSOUND_EXPORT void NowSoundGraph_PluginName(PluginId pluginId, LPWSTR wcharBuffer, int32_t bufferCapacity);
 
         // Load programs for the given plugin from the given directory.
-        __declspec(dllexport) bool NowSoundGraph_LoadPluginPrograms(PluginId pluginId, LPWSTR pathnameBuffer);
+        NOWSOUND_EXPORT bool NowSoundGraph_LoadPluginPrograms(PluginId pluginId, LPWSTR pathnameBuffer);
 
         // Get the number of programs for the given plugin.  (Call this after loading.)
-        __declspec(dllexport) int NowSoundGraph_PluginProgramCount(PluginId pluginId);
+        NOWSOUND_EXPORT int NowSoundGraph_PluginProgramCount(PluginId pluginId);
 
         // Get the name of the specified plugin's program.  Note that IDs are 1-based.
-        __declspec(dllexport) void NowSoundGraph_PluginProgramName(PluginId pluginId, ProgramId programId, LPWSTR wcharBuffer, int32_t bufferCapacity);
+        NOWSOUND_EXPORT void NowSoundGraph_PluginProgramName(PluginId pluginId, ProgramId programId, LPWSTR wcharBuffer, int32_t bufferCapacity);
 
         // Add an instance of the given plugin on the given input.
-        __declspec(dllexport) PluginInstanceIndex NowSoundGraph_AddInputPluginInstance(AudioInputId audioInputId, PluginId pluginId, ProgramId programId, int32_t dryWet_0_100);
+        NOWSOUND_EXPORT PluginInstanceIndex NowSoundGraph_AddInputPluginInstance(AudioInputId audioInputId, PluginId pluginId, ProgramId programId, int32_t dryWet_0_100);
         // Get the number of plugin instances on this input.
-        __declspec(dllexport) int NowSoundGraph_GetInputPluginInstanceCount(AudioInputId audioInputId);
+        NOWSOUND_EXPORT int NowSoundGraph_GetInputPluginInstanceCount(AudioInputId audioInputId);
         // Get info about a plugin instance on this input.
-        __declspec(dllexport) NowSoundPluginInstanceInfo NowSoundGraph_GetInputPluginInstanceInfo(AudioInputId audioInputId, PluginInstanceIndex index);
+        NOWSOUND_EXPORT NowSoundPluginInstanceInfo NowSoundGraph_GetInputPluginInstanceInfo(AudioInputId audioInputId, PluginInstanceIndex index);
         // Set the dry/wet balance on the given plugin.
-        __declspec(dllexport) void NowSoundGraph_SetInputPluginInstanceDryWet(AudioInputId audioInputId, PluginInstanceIndex pluginInstanceIndex, int32_t dryWet_0_100);
+        NOWSOUND_EXPORT void NowSoundGraph_SetInputPluginInstanceDryWet(AudioInputId audioInputId, PluginInstanceIndex pluginInstanceIndex, int32_t dryWet_0_100);
         // Delete the given plugin instance; note that this will effectively renumber all subsequent instances.
-        __declspec(dllexport) void NowSoundGraph_DeleteInputPluginInstance(AudioInputId audioInputId, PluginInstanceIndex pluginInstanceIndex);
+        NOWSOUND_EXPORT void NowSoundGraph_DeleteInputPluginInstance(AudioInputId audioInputId, PluginInstanceIndex pluginInstanceIndex);
 
         // Tear down the whole graph.
         // Graph may be in any state other than InError. On completion, graph becomes Uninitialized.
-        __declspec(dllexport) void NowSoundGraph_ShutdownInstance();
+        NOWSOUND_EXPORT void NowSoundGraph_ShutdownInstance();
     }
 
     extern "C"
@@ -173,48 +202,52 @@ namespace NowSound
         // not concurrently.
 
         // Test method only: get a predefined NowSoundTrack_TrackTimeInfo instance to test P/Invoke serialization.
-        __declspec(dllexport) NowSoundTrackInfo NowSoundTrack_GetStaticTrackInfo();
+        NOWSOUND_EXPORT NowSoundTrackInfo NowSoundTrack_GetStaticTrackInfo();
 
         // In what state is this track?
-        __declspec(dllexport) NowSoundTrackState NowSoundTrack_State(TrackId trackId);
+        NOWSOUND_EXPORT NowSoundTrackState NowSoundTrack_State(TrackId trackId);
 
         // The current timing information for this Track.
-        __declspec(dllexport) NowSoundTrackInfo NowSoundTrack_Info(TrackId trackId);
+        NOWSOUND_EXPORT NowSoundTrackInfo NowSoundTrack_Info(TrackId trackId);
 
         // The current signal information for this Track (tracking the mono input channel).
-        __declspec(dllexport) NowSoundSignalInfo NowSoundTrack_SignalInfo(TrackId trackId);
+        NOWSOUND_EXPORT NowSoundSignalInfo NowSoundTrack_SignalInfo(TrackId trackId);
 
         // The user wishes the track to finish recording now, or at least when its quantized duration is reached.
         // Contractually requires State == NowSoundTrack_State.Recording.
-        __declspec(dllexport) void NowSoundTrack_FinishRecording(TrackId trackId);
+        NOWSOUND_EXPORT void NowSoundTrack_FinishRecording(TrackId trackId);
 
         // Get the current track frequency histogram (post-effects); LPWSTR must actually reference a float buffer of the
         // same length as the outputBinCount argument passed to InitializeFFT, but must be typed as LPWSTR
         // and must have a capacity represented in two-byte wide characters (to match the P/Invoke style of
         // "pass in StringBuilder", known to work well).
-        __declspec(dllexport) void NowSoundTrack_GetFrequencies(TrackId trackId, void* floatBuffer, int32_t floatBufferCapacity);
+        // Returns the audio sample time at which the histogram's audio ended (0 if there is no histogram yet).
+        NOWSOUND_EXPORT int64_t NowSoundTrack_GetFrequencies(TrackId trackId, void* floatBuffer, int32_t floatBufferCapacity);
 
         // True if this is muted.
         // 
         // Note that something can be in FinishRecording state but still be muted, if the user is fast!
         // Hence this is a separate flag, not represented as a NowSoundTrack_State.
-        __declspec(dllexport) bool NowSoundTrack_IsMuted(TrackId trackId);
-        __declspec(dllexport) void NowSoundTrack_SetIsMuted(TrackId trackId, bool isMuted);
+        NOWSOUND_EXPORT bool NowSoundTrack_IsMuted(TrackId trackId);
+        NOWSOUND_EXPORT void NowSoundTrack_SetIsMuted(TrackId trackId, bool isMuted);
 
-        __declspec(dllexport) float NowSoundTrack_Pan(TrackId trackId);
-        __declspec(dllexport) void NowSoundTrack_SetPan(TrackId trackId, float pan);
-        __declspec(dllexport) float NowSoundTrack_Volume(TrackId trackId);
-        __declspec(dllexport) void NowSoundTrack_SetVolume(TrackId trackId, float volume);
+        // Get and set the track's pan (0 = left, 1 = right; a balance, for stereo tracks) and volume.
+        // Setting is lock-free, and may be done at automation rates; the audio thread ramps smoothly to the
+        // latest setting, and the getters return the latest setting.
+        NOWSOUND_EXPORT float NowSoundTrack_Pan(TrackId trackId);
+        NOWSOUND_EXPORT void NowSoundTrack_SetPan(TrackId trackId, float pan);
+        NOWSOUND_EXPORT float NowSoundTrack_Volume(TrackId trackId);
+        NOWSOUND_EXPORT void NowSoundTrack_SetVolume(TrackId trackId, float volume);
 
         // Add an instance of the given plugin on the given track.
-        __declspec(dllexport) PluginInstanceIndex NowSoundTrack_AddPluginInstance(TrackId trackId, PluginId pluginId, ProgramId programId, int32_t dryWet_0_100);
+        NOWSOUND_EXPORT PluginInstanceIndex NowSoundTrack_AddPluginInstance(TrackId trackId, PluginId pluginId, ProgramId programId, int32_t dryWet_0_100);
         // Get the number of plugin instances on this track.
-        __declspec(dllexport) int NowSoundTrack_GetPluginInstanceCount(TrackId trackId);
+        NOWSOUND_EXPORT int NowSoundTrack_GetPluginInstanceCount(TrackId trackId);
         // Get info about a plugin instance on this track.
-        __declspec(dllexport) NowSoundPluginInstanceInfo NowSoundTrack_GetPluginInstanceInfo(TrackId trackId, PluginInstanceIndex index);
+        NOWSOUND_EXPORT NowSoundPluginInstanceInfo NowSoundTrack_GetPluginInstanceInfo(TrackId trackId, PluginInstanceIndex index);
         // Set the dry/wet balance on the given plugin. TODO: implement this!
-        __declspec(dllexport) void NowSoundTrack_SetPluginInstanceDryWet(TrackId trackId, PluginInstanceIndex PluginInstanceIndex, int32_t dryWet_0_100);
+        NOWSOUND_EXPORT void NowSoundTrack_SetPluginInstanceDryWet(TrackId trackId, PluginInstanceIndex PluginInstanceIndex, int32_t dryWet_0_100);
         // Delete the given plugin instance; note that this will effectively renumber all subsequent instances.
-        __declspec(dllexport) void NowSoundTrack_DeletePluginInstance(TrackId trackId, PluginInstanceIndex PluginInstanceIndex);
+        NOWSOUND_EXPORT void NowSoundTrack_DeletePluginInstance(TrackId trackId, PluginInstanceIndex PluginInstanceIndex);
     };
 }
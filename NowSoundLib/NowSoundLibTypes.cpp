@@ -97,4 +97,44 @@ namespace NowSound
         info.DryWet_0_100 = dryWet_0_100;
         return info;
     }
+
+    NowSoundProcessorTimingInfo CreateNowSoundProcessorTimingInfo(
+        NowSoundProcessorKind kind,
+        int32_t id,
+        int64_t blockCount,
+        float meanMicroseconds,
+        float p99Microseconds,
+        float maxMicroseconds)
+    {
+        NowSoundProcessorTimingInfo info;
+        info.BlockCount = blockCount;
+        info.Kind = (int32_t)kind;
+        info.Id = id;
+        info.MeanMicroseconds = meanMicroseconds;
+        info.P99Microseconds = p99Microseconds;
+        info.MaxMicroseconds = maxMicroseconds;
+        return info;
+    }
+
+    NowSoundCallbackTimingInfo CreateNowSoundCallbackTimingInfo(
+        int64_t callbackCount,
+        int32_t processorCount,
+        float deadlineMicroseconds,
+        float meanMicroseconds,
+        float p99Microseconds,
+        float maxMicroseconds,
+        float cpuLoad,
+        int64_t deadlineMissCount)
+    {
+        NowSoundCallbackTimingInfo info;
+        info.CallbackCount = callbackCount;
+        info.ProcessorCount = processorCount;
+        info.DeadlineMicroseconds = deadlineMicroseconds;
+        info.MeanMicroseconds = meanMicroseconds;
+        info.P99Microseconds = p99Microseconds;
+        info.MaxMicroseconds = maxMicroseconds;
+        info.CpuLoad = cpuLoad;
+        info.DeadlineMissCount = deadlineMissCount;
+        return info;
+    }
 }
@@ -204,6 +204,60 @@ namespace NowSound
             int32_t DryWet_0_100;
         } NowSoundPluginInstanceInfo;
 
+        // The kinds of audio processor whose timings NowSoundGraph_GetProcessorTimings reports.
+        // Note that since this is extern "C", this is not an enum class, so these identifiers begin with Processor.
+        enum NowSoundProcessorKind
+        {
+            ProcessorUndefined,
+            // An audio input, including its panning and volume; the Id is its AudioInputId.
+            ProcessorInput,
+            // The metering of an audio input's post-effects signal; the Id is its AudioInputId.
+            ProcessorInputMeasurement,
+            // A track, including its panning and volume; the Id is its TrackId.
+            ProcessorTrack,
+            // The metering of a track's post-effects signal; the Id is its TrackId.
+            ProcessorTrackMeasurement,
+            // The loop bank; its times include those of all the tracks (and track measurements) it renders.
+            ProcessorLoopBank,
+            // The metering of the final output mix.
+            ProcessorOutputMix,
+        };
+
+        // How long one audio processor's processBlock calls have taken, since it was created or the timings were
+        // last reset.
+        typedef struct NowSoundProcessorTimingInfo
+        {
+            // The number of blocks timed.
+            int64_t BlockCount;
+            // Which processor this is; a NowSoundProcessorKind.
+            int32_t Kind;
+            // The AudioInputId or TrackId of the processor, or 0 if the kind has none.
+            int32_t Id;
+            // The mean, 99th percentile and maximum time per block, in microseconds.
+            float MeanMicroseconds;
+            float P99Microseconds;
+            float MaxMicroseconds;
+        } NowSoundProcessorTimingInfo;
+
+        // How long the whole audio callbacks have taken, since the graph started or the timings were last reset.
+        typedef struct NowSoundCallbackTimingInfo
+        {
+            // The number of callbacks timed.
+            int64_t CallbackCount;
+            // The number of processors whose timings exist (which may be more than were asked for).
+            int32_t ProcessorCount;
+            // The time in which each callback must finish: the duration of one block of audio, in microseconds.
+            float DeadlineMicroseconds;
+            // The mean, 99th percentile and maximum time per callback, in microseconds.
+            float MeanMicroseconds;
+            float P99Microseconds;
+            float MaxMicroseconds;
+            // The mean callback time as a fraction of the deadline; the load the callback puts on its CPU.
+            float CpuLoad;
+            // The number of callbacks which overran the deadline (each of which may have been an audible dropout).
+            int64_t DeadlineMissCount;
+        } NowSoundCallbackTimingInfo;
+
         NowSoundGraphInfo CreateNowSoundGraphInfo(
             int32_t sampleRateHz,
             int32_t channelCount,
@@ -245,5 +299,23 @@ namespace NowSound
             PluginId pluginId,
             ProgramId programId,
             int32_t dryWet_0_100);
+
+        NowSoundProcessorTimingInfo CreateNowSoundProcessorTimingInfo(
+            NowSoundProcessorKind kind,
+            int32_t id,
+            int64_t blockCount,
+            float meanMicroseconds,
+            float p99Microseconds,
+            float maxMicroseconds);
+
+        NowSoundCallbackTimingInfo CreateNowSoundCallbackTimingInfo(
+            int64_t callbackCount,
+            int32_t processorCount,
+            float deadlineMicroseconds,
+            float meanMicroseconds,
+            float p99Microseconds,
+            float maxMicroseconds,
+            float cpuLoad,
+            int64_t deadlineMissCount);
     }
 }
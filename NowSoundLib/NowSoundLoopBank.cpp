@@ -0,0 +1,141 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#include "stdafx.h"
+
+#include "AudioKernels.h"
+#include "Check.h"
+#include "NowSoundLoopBank.h"
+
+using namespace NowSound;
+using namespace std;
+
+NowSoundLoopBankAudioProcessor::NowSoundLoopBankAudioProcessor(NowSoundGraph* graph, int inputCount, int capacity)
+    : BaseAudioProcessor(graph, L"LoopBank"),
+    _inputCount{ inputCount },
+    _tracks{ capacity },
+    _ownedTracks{},
+    _ownedOutputProcessors{},
+    _trackBuffer{ 2, graph->Info().SamplesPerQuantum },
+    _mixBuffer{ 2, graph->Info().SamplesPerQuantum },
+    _emptyMidiBuffer{},
+    _sampleRate{ (double)graph->Info().SampleRateHz },
+    _maximumBlockSize{ graph->Info().SamplesPerQuantum }
+{
+    Check(inputCount > 0);
+
+    // reserve up front, so adding tracks never reallocates
+    _ownedTracks.reserve(capacity);
+    _ownedOutputProcessors.reserve(capacity);
+}
+
+void NowSoundLoopBankAudioProcessor::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+    _sampleRate = sampleRate;
+    _maximumBlockSize = maximumExpectedSamplesPerBlock;
+    _trackBuffer.setSize(2, maximumExpectedSamplesPerBlock);
+    _mixBuffer.setSize(2, maximumExpectedSamplesPerBlock);
+}
+
+void NowSoundLoopBankAudioProcessor::PrepareTrack(NowSoundTrackAudioProcessor* track)
+{
+    // the same configuration NowSoundGraph::AddNodeToJuceGraph gives a recording track's nodes
+    track->setPlayConfigDetails(2, 2, _sampleRate, _maximumBlockSize);
+    track->OutputProcessor()->setPlayConfigDetails(2, 2, _sampleRate, _maximumBlockSize);
+    track->prepareToPlay(_sampleRate, _maximumBlockSize);
+    track->OutputProcessor()->prepareToPlay(_sampleRate, _maximumBlockSize);
+}
+
+void NowSoundLoopBankAudioProcessor::AddTrack(NowSoundTrackAudioProcessor* track)
+{
+    Check(!IsFull());
+
+    PrepareTrack(track);
+
+    _ownedTracks.emplace_back(track);
+    _ownedOutputProcessors.emplace_back(track->OutputProcessor());
+
+    // only now can the audio thread see it
+    Check(_tracks.TryAdd(track));
+}
+
+void NowSoundLoopBankAudioProcessor::ReleaseTrack(NowSoundTrackAudioProcessor* track)
+{
+    // once this returns, the audio thread is done with the track
+    _tracks.Remove(track);
+
+    for (size_t i = 0; i < _ownedTracks.size(); i++)
+    {
+        if (_ownedTracks[i].get() == track)
+        {
+            _ownedTracks[i].release();
+            _ownedOutputProcessors[i].release();
+            _ownedTracks.erase(_ownedTracks.begin() + i);
+            _ownedOutputProcessors.erase(_ownedOutputProcessors.begin() + i);
+            return;
+        }
+    }
+    Check(false);
+}
+
+void NowSoundLoopBankAudioProcessor::DeleteTrack(NowSoundTrackAudioProcessor* track)
+{
+    MeasurementAudioProcessor* outputProcessor = track->OutputProcessor();
+    ReleaseTrack(track);
+    delete track;
+    delete outputProcessor;
+}
+
+void NowSoundLoopBankAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, MidiBuffer& midiBuffer)
+{
+    ProcessBlockTimer timer{ this };
+
+    Check(audioBuffer.getNumChannels() == _inputCount * 2);
+
+    int numSamples = audioBuffer.getNumSamples();
+    Check(numSamples <= _trackBuffer.getNumSamples());
+
+    float* mix0 = _mixBuffer.getWritePointer(0);
+    float* mix1 = _mixBuffer.getWritePointer(1);
+    memset(mix0, 0, sizeof(float) * numSamples);
+    memset(mix1, 0, sizeof(float) * numSamples);
+
+    // a view of exactly this block's length onto the track buffer, as the tracks size their work by the buffer
+    AudioBuffer<float> trackBlock(_trackBuffer.getArrayOfWritePointers(), 2, numSamples);
+    float* track0 = trackBlock.getWritePointer(0);
+    float* track1 = trackBlock.getWritePointer(1);
+
+    _tracks.BeginRender();
+    int slotCount = _tracks.SlotCount();
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        NowSoundTrackAudioProcessor* track = _tracks.At(slot);
+        if (track == nullptr)
+        {
+            continue;
+        }
+
+        // tracks still recording take their input's post-effects signal; looping tracks overwrite the buffer
+        NowSoundTrackState state = track->State();
+        if (state == NowSoundTrackState::TrackRecording || state == NowSoundTrackState::TrackFinishRecording)
+        {
+            int inputChannel = ((int)track->InputId() - 1) * 2;
+            AudioKernels::Copy(track0, audioBuffer.getReadPointer(inputChannel), numSamples);
+            AudioKernels::Copy(track1, audioBuffer.getReadPointer(inputChannel + 1), numSamples);
+        }
+
+        track->processBlock(trackBlock, _emptyMidiBuffer);
+        track->OutputProcessor()->processBlock(trackBlock, _emptyMidiBuffer);
+
+        AudioKernels::Mix(mix0, track0, 1, numSamples);
+        AudioKernels::Mix(mix1, track1, 1, numSamples);
+    }
+    _tracks.EndRender();
+
+    AudioKernels::Copy(audioBuffer.getWritePointer(0), mix0, numSamples);
+    AudioKernels::Copy(audioBuffer.getWritePointer(1), mix1, numSamples);
+    for (int channel = 2; channel < audioBuffer.getNumChannels(); channel++)
+    {
+        memset(audioBuffer.getWritePointer(channel), 0, sizeof(float) * numSamples);
+    }
+}
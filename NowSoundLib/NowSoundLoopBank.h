@@ -0,0 +1,82 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <memory>
+#include <vector>
+
+#include "BaseAudioProcessor.h"
+#include "NowSoundGraph.h"
+#include "NowSoundTrack.h"
+#include "RenderList.h"
+
+namespace NowSound
+{
+    // Renders, pans, meters and sums many tracks in a single JUCE node.
+    //
+    // Added as two nodes per track, a hundred tracks means two hundred nodes, four hundred connections, a buffer
+    // copy at every connection, and a rebuild of JUCE's whole render sequence whenever any track comes or goes.
+    // The loop bank instead keeps plugin-free tracks in a flat RenderList and runs each one's processBlock, and its
+    // output MeasurementAudioProcessor's, directly on a shared scratch buffer, mixing the result into its output.
+    // Adding or removing a track touches only the list, not the JUCE graph.
+    //
+    // Its inputs are each audio input's post-effects stereo pair (input N on channels 2N-2 and 2N-1), which it
+    // feeds to tracks that are still recording; its output is the stereo sum of all its tracks.
+    //
+    // The bank owns the tracks it holds (and their output processors), as the JUCE graph would otherwise.
+    // Tracks with plugin chains need real JUCE connections, so they are released back to the graph.
+    class NowSoundLoopBankAudioProcessor : public BaseAudioProcessor
+    {
+    private:
+        // The number of audio inputs whose post-effects signals we receive.
+        const int _inputCount;
+
+        // The tracks rendered every block.
+        RenderList<NowSoundTrackAudioProcessor> _tracks;
+
+        // Ownership of the tracks in _tracks, and of their output processors.  Message thread only.
+        std::vector<std::unique_ptr<NowSoundTrackAudioProcessor>> _ownedTracks;
+        std::vector<std::unique_ptr<MeasurementAudioProcessor>> _ownedOutputProcessors;
+
+        // The stereo buffer each track renders into, and the stereo sum of all tracks; allocated by prepareToPlay.
+        juce::AudioBuffer<float> _trackBuffer;
+        juce::AudioBuffer<float> _mixBuffer;
+
+        // Always empty; passed to the tracks' processBlock.
+        juce::MidiBuffer _emptyMidiBuffer;
+
+        // The sample rate and block size from the last prepareToPlay, for preparing tracks added later.
+        double _sampleRate;
+        int _maximumBlockSize;
+
+        // Configure a track and its output processor to run standalone, with our block size.
+        void PrepareTrack(NowSoundTrackAudioProcessor* track);
+
+    public:
+        NowSoundLoopBankAudioProcessor(NowSoundGraph* graph, int inputCount, int capacity);
+
+        virtual void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+
+        virtual void processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
+
+        // Is the bank full?
+        bool IsFull() const { return _tracks.Count() == _tracks.Capacity(); }
+
+        // Does the bank hold this track?
+        bool Contains(const NowSoundTrackAudioProcessor* track) const { return _tracks.Contains(track); }
+
+        // Take ownership of a new track (which is not in the JUCE graph) and start rendering it.  The bank must not
+        // be full.
+        void AddTrack(NowSoundTrackAudioProcessor* track);
+
+        // Stop rendering the track, and release ownership of it and its output processor to the caller.
+        // Waits for any block in progress to finish.
+        void ReleaseTrack(NowSoundTrackAudioProcessor* track);
+
+        // Stop rendering the track, and destroy it and its output processor.
+        void DeleteTrack(NowSoundTrackAudioProcessor* track);
+    };
+}
@@ -0,0 +1,175 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "AudioKernels.h"
+#include "Check.h"
+#include "NowSoundOfflineRenderer.h"
+
+using namespace NowSound;
+using namespace std;
+
+WavFileGenerator::WavFileGenerator(const juce::File& file, int channel, int sampleRateHz, bool loop)
+    : _samples{},
+    _loop{ loop },
+    _position{ 0 }
+{
+    std::unique_ptr<FileInputStream> fileStream{ file.createInputStream() };
+    Check(fileStream != nullptr);
+
+    WavAudioFormat wavFormat;
+    std::unique_ptr<AudioFormatReader> reader{
+        wavFormat.createReaderFor(fileStream.release(), /*deleteStreamIfOpeningFails*/ true) };
+    Check(reader != nullptr);
+    Check((int)reader->sampleRate == sampleRateHz);
+    Check(channel >= 0 && channel < (int)reader->numChannels);
+
+    int length = (int)reader->lengthInSamples;
+    Check(length > 0);
+
+    AudioBuffer<float> allChannels{ (int)reader->numChannels, length };
+    reader->read(&allChannels, 0, length, 0, true, true);
+
+    _samples.setSize(1, length);
+    _samples.copyFrom(0, 0, allChannels, channel, 0, length);
+}
+
+void WavFileGenerator::Generate(float* dest, int sampleCount)
+{
+    const float* source = _samples.getReadPointer(0);
+    int length = _samples.getNumSamples();
+
+    int written = 0;
+    while (written < sampleCount)
+    {
+        if (_position == length)
+        {
+            if (!_loop)
+            {
+                memset(dest + written, 0, sizeof(float) * (sampleCount - written));
+                return;
+            }
+            _position = 0;
+        }
+
+        int count = std::min(sampleCount - written, length - _position);
+        AudioKernels::Copy(dest + written, source + _position, count);
+        written += count;
+        _position += count;
+    }
+}
+
+NowSoundOfflineRenderer::NowSoundOfflineRenderer(NowSoundGraph* graph)
+    : _graph{ graph },
+    _samplesPerQuantum{ graph->Info().SamplesPerQuantum },
+    _inputs{},
+    _blockBuffer{ graph->Info().ChannelCount, graph->Info().SamplesPerQuantum },
+    _midiBuffer{},
+    _wavWriter{},
+    _renderedSamples{ 0 }
+{
+    Check(graph->IsOffline());
+    Check(graph->State() == NowSoundGraphState::GraphRunning);
+
+    for (int i = 0; i < graph->Info().ChannelCount; i++)
+    {
+        _inputs.emplace_back(new SilenceGenerator());
+    }
+}
+
+NowSoundOfflineRenderer::~NowSoundOfflineRenderer()
+{
+    StopWritingWav();
+}
+
+void NowSoundOfflineRenderer::SetInput(int channel, std::unique_ptr<SignalGenerator>&& generator)
+{
+    Check(channel >= 0 && channel < (int)_inputs.size());
+    Check(generator != nullptr);
+
+    _inputs[channel] = std::move(generator);
+}
+
+void NowSoundOfflineRenderer::StartWritingWav(const juce::File& file)
+{
+    StopWritingWav();
+
+    // replace, rather than append to, any existing file
+    file.deleteFile();
+
+    if (auto fileStream = std::unique_ptr<FileOutputStream>(file.createOutputStream()))
+    {
+        WavAudioFormat wavFormat;
+        if (auto writer = wavFormat.createWriterFor(fileStream.get(), _graph->Info().SampleRateHz, 2, 32, {}, 0))
+        {
+            fileStream.release(); // (the writer now owns the stream)
+
+            // Offline there is no deadline to protect, so unlike MeasurementAudioProcessor::StartRecording we
+            // write synchronously, and every rendered sample reaches the file.
+            _wavWriter.reset(writer);
+        }
+    }
+
+    Check(_wavWriter != nullptr);
+}
+
+void NowSoundOfflineRenderer::StopWritingWav()
+{
+    // the writer flushes and closes the file when destroyed
+    _wavWriter.reset();
+}
+
+void NowSoundOfflineRenderer::RenderBlock(juce::AudioBuffer<float>* mixOutput, int mixOutputOffset)
+{
+    // first, what the message thread would do between device callbacks
+    _graph->MessageTick();
+
+    // then what the device would do: provide the input, and run the callback
+    GenerateInputs();
+    ProcessBlock(mixOutput, mixOutputOffset);
+}
+
+void NowSoundOfflineRenderer::GenerateInputs()
+{
+    for (int channel = 0; channel < (int)_inputs.size(); channel++)
+    {
+        _inputs[channel]->Generate(_blockBuffer.getWritePointer(channel), _samplesPerQuantum);
+    }
+}
+
+void NowSoundOfflineRenderer::ProcessBlock(juce::AudioBuffer<float>* mixOutput, int mixOutputOffset)
+{
+    // pull the output, timing it as the graph's player would time a device callback
+    int64_t startNanoseconds = TimingHistogram::Now();
+    _graph->JuceGraph().processBlock(_blockBuffer, _midiBuffer);
+    _graph->RecordCallback(startNanoseconds, TimingHistogram::Now(), _samplesPerQuantum);
+
+    if (mixOutput != nullptr)
+    {
+        Check(mixOutput->getNumChannels() >= 2);
+        Check(mixOutputOffset + _samplesPerQuantum <= mixOutput->getNumSamples());
+
+        mixOutput->copyFrom(0, mixOutputOffset, _blockBuffer, 0, 0, _samplesPerQuantum);
+        mixOutput->copyFrom(1, mixOutputOffset, _blockBuffer, 1, 0, _samplesPerQuantum);
+    }
+
+    if (_wavWriter != nullptr)
+    {
+        _wavWriter->writeFromAudioSampleBuffer(_blockBuffer, 0, _samplesPerQuantum);
+    }
+
+    _renderedSamples += _samplesPerQuantum;
+}
+
+void NowSoundOfflineRenderer::Render(int blockCount, juce::AudioBuffer<float>* mixOutput)
+{
+    Check(blockCount >= 0);
+
+    for (int i = 0; i < blockCount; i++)
+    {
+        RenderBlock(mixOutput, i * _samplesPerQuantum);
+    }
+}
@@ -0,0 +1,111 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <memory>
+#include <vector>
+
+#include "NowSoundGraph.h"
+#include "SignalGenerator.h"
+
+#include "JuceHeader.h"
+
+namespace NowSound
+{
+    // Plays a WAV file's channel as a signal, looping or followed by silence.
+    // The whole file is read into memory up front, so generating never touches the disk.
+    class WavFileGenerator : public SignalGenerator
+    {
+    private:
+        // The file's samples, for the one channel we play.
+        juce::AudioBuffer<float> _samples;
+
+        // Do we start over at the end, rather than going silent?
+        const bool _loop;
+
+        // The index of the next sample to play.
+        int _position;
+
+    public:
+        // Read the given channel of the given WAV file, whose sample rate must be sampleRateHz.
+        WavFileGenerator(const juce::File& file, int channel, int sampleRateHz, bool loop);
+
+        virtual void Generate(float* dest, int sampleCount) override;
+    };
+
+    // Drives a graph created by NowSoundGraph::InitializeOffline(), in place of an audio device.
+    //
+    // Each block, the renderer does what the message thread and the device would: it runs MessageTick() (so graph
+    // changes made since the last block take effect), fills the graph's input channels from the input generators,
+    // and pulls one block through the JUCE graph.  Nothing waits on a clock, so blocks render as fast as the
+    // machine allows, and since graph changes happen only between blocks, a run is repeatable.
+    //
+    // The rendered output mix can be copied into memory, written to a WAV file, or both.
+    //
+    // All methods must be called from the one thread which drives the graph.
+    class NowSoundOfflineRenderer
+    {
+    private:
+        // The graph we drive.
+        NowSoundGraph* _graph;
+
+        // The block size.
+        const int _samplesPerQuantum;
+
+        // The generator for each input channel.
+        std::vector<std::unique_ptr<SignalGenerator>> _inputs;
+
+        // The buffer the graph processes in place: input on the way in, output mix on the way out.
+        juce::AudioBuffer<float> _blockBuffer;
+
+        // Always empty.
+        juce::MidiBuffer _midiBuffer;
+
+        // The writer for the WAV file we are writing, if any.
+        std::unique_ptr<juce::AudioFormatWriter> _wavWriter;
+
+        // The number of samples rendered so far.
+        int64_t _renderedSamples;
+
+    public:
+        // The graph must be offline and running.  All inputs start out silent.
+        NowSoundOfflineRenderer(NowSoundGraph* graph);
+
+        // Flushes and closes any WAV file being written.
+        ~NowSoundOfflineRenderer();
+
+        // The block size.
+        int SamplesPerQuantum() const { return _samplesPerQuantum; }
+
+        // The number of samples rendered so far.
+        int64_t RenderedSamples() const { return _renderedSamples; }
+
+        // Feed the given input channel from the given generator from now on.
+        void SetInput(int channel, std::unique_ptr<SignalGenerator>&& generator);
+
+        // Start writing the output mix to the given WAV file (stereo 32-bit float), replacing any file already
+        // being written.
+        void StartWritingWav(const juce::File& file);
+
+        // Stop writing the output mix, flushing and closing the file; ignored if not writing.
+        void StopWritingWav();
+
+        // Render one block.  If mixOutput is non-null, the block's output mix is copied into its first two
+        // channels starting at mixOutputOffset.
+        void RenderBlock(juce::AudioBuffer<float>* mixOutput = nullptr, int mixOutputOffset = 0);
+
+        // The parts of RenderBlock() which the device would do, without the MessageTick(); for callers (such as
+        // benchmarks) which tick the graph themselves, to measure the callback alone.  GenerateInputs() fills the
+        // next block's input from the input generators, as the device's driver would; ProcessBlock() then runs the
+        // callback on it, so must follow exactly one GenerateInputs().
+        void GenerateInputs();
+        void ProcessBlock(juce::AudioBuffer<float>* mixOutput = nullptr, int mixOutputOffset = 0);
+
+        // Render the given number of blocks.  If mixOutput is non-null, it must hold at least
+        // blockCount * SamplesPerQuantum() samples, and receives the whole rendered output mix.
+        void Render(int blockCount, juce::AudioBuffer<float>* mixOutput = nullptr);
+    };
+}
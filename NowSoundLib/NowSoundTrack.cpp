@@ -10,7 +10,6 @@
 #include "BufferAllocator.h"
 #include "Check.h"
 #include "Clock.h"
-#include "GetBuffer.h"
 #include "MagicConstants.h"
 #include "NowSoundGraph.h"
 #include "NowSoundInput.h"
@@ -20,12 +19,8 @@
 #include "SliceStream.h"
 #include "NowSoundTime.h"
 
-using namespace concurrency;
 using namespace std;
 using namespace std::chrono;
-using namespace winrt;
-
-using namespace winrt::Windows::Foundation;
 
 namespace NowSound
 {
@@ -33,7 +28,7 @@ namespace NowSound
         NowSoundGraph* graph,
         TrackId trackId,
         AudioInputId inputId,
-        const BufferedSliceStream<AudioSample, float>& sourceStream,
+        const DenseSliceStream<AudioSample, float>& sourceStream,
         float initialVolume,
         float initialPan)
         : SpatialAudioProcessor(graph, MakeName(L"Track ", (int)trackId), initialVolume, initialPan),
@@ -41,21 +36,16 @@ namespace NowSound
         _audioInputId{ inputId },
         _state{ NowSoundTrackState::TrackRecording },
         // latency compensation effectively means the track started before it was constructed ;-)
-        _audioStream0(
+        _audioStream(
             Clock::Instance().Now() - Clock::Instance().TimeToSamples(MagicConstants::PreRecordingDuration),
-            1,
+            Clock::Instance().ChannelCount(),
             NowSoundGraph::Instance()->AudioAllocator(),
             /*maxBufferedDuration:*/ 0,
-            /*useContinuousLoopingMapper*/ false),
-        _audioStream1(
-            Clock::Instance().Now() - Clock::Instance().TimeToSamples(MagicConstants::PreRecordingDuration),
-            1,
-            NowSoundGraph::Instance()->AudioAllocator(),
-            /*maxBufferedDuration:*/ 0,
-            /*useContinuousLoopingMapper*/ false),
+            /*useExactLoopingMapper*/ true),
         // one beat is the shortest any track ever is (TODO: allow optionally relaxing quantization)
         _beatDuration{ 1 },
-        _lastSampleTime{ Clock::Instance().Now() }
+        _lastSampleTime{ Clock::Instance().Now() },
+        _playbackCursor{}
     {
         Check(_lastSampleTime.Value() >= 0);
 
@@ -112,12 +102,12 @@ namespace NowSound
     }
 
     // If we are recording, monitor the input; otherwise, monitor the track itself.
-    void NowSoundTrackAudioProcessor::GetFrequencies(void* floatBuffer, int floatBufferCapacity)
+    Time<AudioSample> NowSoundTrackAudioProcessor::GetFrequencies(void* floatBuffer, int floatBufferCapacity)
     {
         if (_state == NowSoundTrackState::TrackRecording
             || _state == NowSoundTrackState::TrackFinishRecording)
         {
-            NowSoundGraph::Instance()->Input(_audioInputId)->GetFrequencies(floatBuffer, floatBufferCapacity);
+            return NowSoundGraph::Instance()->Input(_audioInputId)->GetFrequencies(floatBuffer, floatBufferCapacity);
         }
         else
         {
@@ -134,45 +124,49 @@ namespace NowSound
         // TODO: determine whether we really need a time that only moves forward between Unity frames.
         // For now, let time be determined solely by audio graph, and let Unity observe time increasing 
         // during a single Unity frame.
-        Duration<AudioSample> sinceStart(Clock::Instance().Now() - _audioStream0.InitialTime());
+        Duration<AudioSample> sinceStart(Clock::Instance().Now() - _audioStream.InitialTime());
         Time<AudioSample> sinceStartTime(sinceStart.Value());
 
-        ContinuousDuration<Beat> beats = Clock::Instance().TimeToBeats(sinceStartTime);
-        int completeBeatsSinceStart = (int)beats.Value() % (int)BeatDuration().Value();
-        return (ContinuousDuration<Beat>)(completeBeatsSinceStart + (beats.Value() - (int)beats.Value()));
+        int64_t completeBeatsSinceStart = Clock::Instance().TimeToCompleteBeats(sinceStartTime) % BeatDuration().Value();
+        return (ContinuousDuration<Beat>)(
+            completeBeatsSinceStart + Clock::Instance().TimeToFractionalBeat(sinceStartTime).Value());
     }
 
     ContinuousDuration<AudioSample> NowSoundTrackAudioProcessor::ExactDuration() const
     {
-        return (int)BeatDuration().Value() * Clock::Instance().BeatDuration().Value();
+        return ExactRationalDuration().Value();
     }
 
-    Time<AudioSample> NowSoundTrackAudioProcessor::StartTime() const { return _audioStream0.InitialTime(); }
+    RationalDuration<AudioSample> NowSoundTrackAudioProcessor::ExactRationalDuration() const
+    {
+        return Clock::Instance().ExactBeatDuration() * BeatDuration().Value();
+    }
+
+    Time<AudioSample> NowSoundTrackAudioProcessor::StartTime() const { return _audioStream.InitialTime(); }
 
     ContinuousDuration<Beat> TrackBeats(Duration<AudioSample> localTime, Duration<Beat> beatDuration)
     {
-        ContinuousDuration<Beat> totalBeats = Clock::Instance().TimeToBeats(localTime.Value());
-        Duration<Beat> nonFractionalBeats((int)totalBeats.Value());
+        Duration<Beat> nonFractionalBeats(Clock::Instance().TimeToCompleteBeats(localTime.Value()));
 
         return (ContinuousDuration<Beat>)(
             // total (non-fractional) beats modulo the beat duration of the track
             (nonFractionalBeats.Value() % beatDuration.Value())
             // fractional beats of the track
-            + (totalBeats.Value() - nonFractionalBeats.Value()));
+            + Clock::Instance().TimeToFractionalBeat(localTime.Value()).Value());
     }
 
     NowSoundTrackInfo NowSoundTrackAudioProcessor::Info() 
     {
         Time<AudioSample> lastSampleTime = this->_lastSampleTime; // to prevent any drift from this being updated concurrently
-        Time<AudioSample> startTime = this->_audioStream0.InitialTime();
+        Time<AudioSample> startTime = this->_audioStream.InitialTime();
         Duration<AudioSample> localClockTime = Clock::Instance().Now() - startTime;
         return CreateNowSoundTrackInfo(
             _state == NowSoundTrackState::TrackLooping,
             startTime.Value(),
             Clock::Instance().TimeToBeats(startTime).Value(),
-            this->_audioStream0.DiscreteDuration().Value(),
+            this->_audioStream.DiscreteDuration().Value(),
             this->BeatDuration().Value(),
-            this->_state == NowSoundTrackState::TrackLooping ? _audioStream0.ExactDuration().Value() : 0,
+            this->_state == NowSoundTrackState::TrackLooping ? _audioStream.ExactDuration().Value() : 0,
             localClockTime.Value(),
             TrackBeats(localClockTime, this->_beatDuration).Value(),
             (lastSampleTime - startTime).Value(),
@@ -192,6 +186,8 @@ namespace NowSound
 
     void NowSoundTrackAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, MidiBuffer& midiBuffer)
     {
+        ProcessBlockTimer timer{ this };
+
         // temporary debugging code: see if processBlock is ever being called under Holofunk
         if (CheckLogThrottle()) {
             std::wstringstream wstr{};
@@ -199,9 +195,9 @@ namespace NowSound
             NowSoundGraph::Instance()->Log(wstr.str());
         }
         
-        // This should always take two channels.  Only channel 0 is used on input.  Both channels are used
-        // on output (only stereo supported for now).
-        Check(audioBuffer.getNumChannels() == 2);
+        // This should always take one channel per sliver of our stream.  All channels are recorded on input,
+        // and played back on output (only stereo supported for now, per the graph's channel count).
+        Check(audioBuffer.getNumChannels() == _audioStream.SliverCount());
 
         // Depending on the current state of this track, we either record, or we finish recording
         // and switch modes to looping, or we're straight looping.
@@ -214,8 +210,8 @@ namespace NowSound
         case NowSoundTrackState::TrackRecording:
         {
             // How many complete beats after we record this data?
-            Time<AudioSample> durationAsTime((_audioStream0.DiscreteDuration() + bufferDuration).Value());
-            Duration<Beat> completeBeats = (Duration<Beat>)((int)Clock::Instance().TimeToBeats(durationAsTime).Value());
+            Time<AudioSample> durationAsTime((_audioStream.DiscreteDuration() + bufferDuration).Value());
+            Duration<Beat> completeBeats = Clock::Instance().TimeToCompleteBeats(durationAsTime);
 
             // If it's more than our _beatDuration, bump our _beatDuration
             // TODO: implement other quantization policies here
@@ -239,10 +235,9 @@ namespace NowSound
             }
 
             // and actually record the full amount of available data.
-            // Getting data for channel 0 is always correct because the JUCE per-channel connections handle which
-            // input channel goes to which track.
-            _audioStream0.Append(bufferDuration, audioBuffer.getReadPointer(0));
-            _audioStream1.Append(bufferDuration, audioBuffer.getReadPointer(1));
+            // Taking all channels is always correct because the JUCE per-channel connections handle which
+            // input channel goes to which track channel.
+            _audioStream.AppendChannels(bufferDuration, audioBuffer.getArrayOfReadPointers());
 
             // and step on all output channels
             for (int i = 0; i < this->getTotalNumOutputChannels(); i++)
@@ -255,10 +250,10 @@ namespace NowSound
         case NowSoundTrackState::TrackFinishRecording:
         {
             // we now need to be sample-accurate.  If we get too many samples, here is where we truncate.
-            Duration<AudioSample> roundedUpDuration((long)std::ceil(ExactDuration().Value()));
+            Duration<AudioSample> roundedUpDuration(ExactRationalDuration().Ceiling());
 
             // we should not have advanced beyond roundedUpDuration yet, or something went wrong at end of recording
-            Duration<AudioSample> originalDiscreteDuration = _audioStream0.DiscreteDuration();
+            Duration<AudioSample> originalDiscreteDuration = _audioStream.DiscreteDuration();
             Check(originalDiscreteDuration <= roundedUpDuration);
 
             if (originalDiscreteDuration + bufferDuration >= roundedUpDuration)
@@ -279,20 +274,17 @@ namespace NowSound
                 // TODONEXT: actually remove input connections by polling! (NYI atm)
                 _justStoppedRecording = true;
 
-                // Getting data for channel 0 is always correct, because the JUCE per-channel connections handle
+                // Taking all channels is always correct, because the JUCE per-channel connections handle
                 // the input-channel-to-track routing.
-                _audioStream0.Append(captureDuration, audioBuffer.getReadPointer(0));
-                _audioStream1.Append(captureDuration, audioBuffer.getReadPointer(1));
+                _audioStream.AppendChannels(captureDuration, audioBuffer.getArrayOfReadPointers());
 
                 // now that we have done our final append, shut the stream at the current duration
-                _audioStream0.Shut(ExactDuration());
-                _audioStream1.Shut(ExactDuration());
+                _audioStream.Shut(ExactRationalDuration());
             }
             else
             {
                 // capture the full duration
-                _audioStream0.Append(bufferDuration, audioBuffer.getReadPointer(0));
-                _audioStream1.Append(bufferDuration, audioBuffer.getReadPointer(1));
+                _audioStream.AppendChannels(bufferDuration, audioBuffer.getArrayOfReadPointers());
             }
 
             // zero the output audio altogether.
@@ -310,19 +302,15 @@ namespace NowSound
         {
             while (bufferDuration > 0)
             {
-                Slice<AudioSample, float> slice0(
-                    _audioStream0.GetSliceContaining(Interval<AudioSample>(_lastSampleTime, bufferDuration)));
-                Slice<AudioSample, float> slice1(
-                    _audioStream1.GetSliceContaining(Interval<AudioSample>(_lastSampleTime, bufferDuration)));
-
-                Check(slice0.SliceDuration() == slice1.SliceDuration());
+                Slice<AudioSample, float> slice(
+                    _audioStream.GetSliceContaining(_playbackCursor, Interval<AudioSample>(_lastSampleTime, bufferDuration)));
 
-                slice0.CopyTo(audioBuffer.getWritePointer(0) + completedDuration.Value());
-                slice1.CopyTo(audioBuffer.getWritePointer(1) + completedDuration.Value());
+                // de-interleave straight into the output channels
+                slice.CopyToChannels(audioBuffer.getArrayOfWritePointers(), completedDuration.Value());
 
-                bufferDuration = bufferDuration - slice0.SliceDuration();
-                completedDuration = completedDuration + slice0.SliceDuration();
-                _lastSampleTime = _lastSampleTime + slice0.SliceDuration();
+                bufferDuration = bufferDuration - slice.SliceDuration();
+                completedDuration = completedDuration + slice.SliceDuration();
+                _lastSampleTime = _lastSampleTime + slice.SliceDuration();
             }
 
             // Now process the whole block to the output.
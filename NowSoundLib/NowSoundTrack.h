@@ -23,7 +23,8 @@
 namespace NowSound
 {
     // Represents a single looping track of recorded audio.
-    // Currently a Track is backed by a mono BufferedSliceStream, but emits stereo output based on current Pan value.
+    // A Track is backed by a single BufferedSliceStream holding all its channels interleaved (one sliver per sample
+    // frame), and emits stereo output based on current Pan value.
     class NowSoundTrackAudioProcessor : public SpatialAudioProcessor
     {
     private:
@@ -42,15 +43,18 @@ namespace NowSound
         // TODO: relax this to permit non-quantized looping.
         Duration<Beat> _beatDuration;
 
-        // The streams containing this Track's data, one per channel.
-        BufferedSliceStream<AudioSample, float> _audioStream0;
-        BufferedSliceStream<AudioSample, float> _audioStream1;
+        // The stream containing this Track's data; its SliverCount is the number of channels recorded.
+        BufferedSliceStream<AudioSample, float> _audioStream;
 
         // Last sample time is based on the Now when the track started looping, and advances strictly
         // based on what the Track has pushed during looping; this variable should be unused except
         // in Looping state.
         Time<AudioSample> _lastSampleTime;
 
+        // Where the last looping lookup into _audioStream left off; as looping is sequential, this saves
+        // searching the stream on every block.
+        PlaybackCursor<AudioSample> _playbackCursor;
+
         // did this just stop recording? if so, message thread will remove its input connection on next poll
         bool _justStoppedRecording;
 
@@ -60,7 +64,7 @@ namespace NowSound
             NowSoundGraph* graph,
             TrackId trackId,
             AudioInputId inputId,
-            const BufferedSliceStream<AudioSample, float>& sourceStream,
+            const DenseSliceStream<AudioSample, float>& sourceStream,
             float initialVolume,
             float initialPan);
 
@@ -74,7 +78,10 @@ namespace NowSound
         virtual NowSoundSignalInfo SignalInfo() override;
 
         // If we are recording, monitor the input; otherwise, monitor the track itself.
-        virtual void GetFrequencies(void* floatBuffer, int floatBufferCapacity) override;
+        virtual Time<AudioSample> GetFrequencies(void* floatBuffer, int floatBufferCapacity) override;
+
+        // The input this track records from.
+        AudioInputId InputId() const { return _audioInputId; }
 
     public: // Exported methods via NowSoundTrackAPI
 
@@ -95,6 +102,9 @@ namespace NowSound
         // Clock::Instance().BeatsPerMinute does not evenly divide Clock::Instance().SampleRateHz.
         ContinuousDuration<AudioSample> ExactDuration() const;
 
+        // Exactly how long is this track, in samples?  ExactDuration() is the nearest float to this.
+        RationalDuration<AudioSample> ExactRationalDuration() const;
+
         // The starting moment at which this Track was created.
         Time<AudioSample> StartTime() const;
 
@@ -3,6 +3,7 @@
 
 #include "stdafx.h"
 
+#include "AudioKernels.h"
 #include "Clock.h"
 #include "MagicConstants.h"
 #include "SpatialAudioProcessor.h"
@@ -13,8 +14,8 @@ using namespace std;
 SpatialAudioProcessor::SpatialAudioProcessor(NowSoundGraph* graph, const wstring& name, float initialVolume, float initialPan) 
     : BaseAudioProcessor(graph, name),
     _isMuted{ false },
-    _volume{ initialVolume },
-    _pan{ initialPan },
+    _volume{ initialVolume, RampShape::Exponential, (int)Clock::Instance().TimeToSamples(MagicConstants::ParameterRampDuration).Value() },
+    _pan{ initialPan, RampShape::Linear, (int)Clock::Instance().TimeToSamples(MagicConstants::ParameterRampDuration).Value() },
     _outputProcessor{ new MeasurementAudioProcessor(graph, MakeName(name, L" Output")) },
     _pluginInstances{},
     _pluginNodeIds{}
@@ -23,40 +24,27 @@ SpatialAudioProcessor::SpatialAudioProcessor(NowSoundGraph* graph, const wstring
 bool SpatialAudioProcessor::IsMuted() const { return _isMuted; }
 void SpatialAudioProcessor::IsMuted(bool isMuted) { _isMuted = isMuted; }
 
-float SpatialAudioProcessor::Pan() const { return _pan; }
+float SpatialAudioProcessor::Pan() const { return _pan.Target(); }
 void SpatialAudioProcessor::Pan(float pan)
 {
     Check(pan >= 0);
     Check(pan <= 1);
 
-    _pan = pan;
+    _pan.Set(pan);
 }
 
-float SpatialAudioProcessor::Volume() const { return _volume; }
+float SpatialAudioProcessor::Volume() const { return _volume.Target(); }
 void SpatialAudioProcessor::Volume(float volume)
 {
     Check(volume >= 0);
 
-    _volume = volume;
-}
-
-const double Pi = std::atan(1) * 4;
-
-float clamp(float value, float absLimit)
-{
-    Check(absLimit > 0);
-    if (value < 0)
-    {
-        return value < -absLimit ? -absLimit : value;
-    }
-    else
-    {
-        return value > absLimit ? absLimit : value;
-    }
+    _volume.Set(volume);
 }
 
 void SpatialAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, MidiBuffer& midiBuffer)
 {
+    ProcessBlockTimer timer{ this };
+
     Check(audioBuffer.getNumChannels() == 2);
     Check(getTotalNumOutputChannels() == 2);
     Check(getTotalNumInputChannels() == 1 || getTotalNumInputChannels() == 2);
@@ -66,43 +54,51 @@ void SpatialAudioProcessor::processBlock(AudioBuffer<float>& audioBuffer, MidiBu
     float* outputBufferChannel0 = audioBuffer.getWritePointer(0);
     float* outputBufferChannel1 = audioBuffer.getWritePointer(1);
 
-    // If only one input channel, then spatialize (and amplify) it.
+    // Advance the ramps even while muted, so unmuting picks up where the parameters are now.
+    float panStart, panEnd, volumeStart, volumeEnd;
+    _pan.Advance(numSamples, panStart, panEnd);
+    _volume.Advance(numSamples, volumeStart, volumeEnd);
+
+    // if we're muted, then mute
+    if (_isMuted)
+    {
+        memset(outputBufferChannel0, 0, sizeof(float) * numSamples);
+        memset(outputBufferChannel1, 0, sizeof(float) * numSamples);
+        return;
+    }
+
+    // The gains at the start and end of the block; the kernels ramp linearly between them.
+    float leftStart, rightStart, leftEnd, rightEnd;
     if (getTotalNumInputChannels() == 1)
     {
-        // Coefficients for panning the mono data into the audio buffer.
-        // Use cosine panner for volume preservation.
-        double angularPosition = _pan * Pi / 2;
-        double leftCoefficient = std::cos(angularPosition);
-        double rightCoefficient = std::sin(angularPosition);
-
-        // Pan each mono sample, if we're not muted.
-        for (int i = 0; i < numSamples; i++)
-        {
-            float value = _isMuted ? 0 : outputBufferChannel0[i];
-            outputBufferChannel0[i] = clamp((float)(leftCoefficient * _volume * value), 1.0f);
-            outputBufferChannel1[i] = clamp((float)(rightCoefficient * _volume * value), 1.0f);
-        }
+        // If only one input channel, then spatialize (and amplify) it, with a constant-power pan.
+        AudioKernels::PanGains(panStart, volumeStart, leftStart, rightStart);
+        AudioKernels::PanGains(panEnd, volumeEnd, leftEnd, rightEnd);
+        AudioKernels::PanRamp(
+            outputBufferChannel0,
+            outputBufferChannel0,
+            outputBufferChannel1,
+            leftStart,
+            leftEnd,
+            rightStart,
+            rightEnd,
+            1.0f,
+            numSamples);
     }
     else
     {
-        // Passing through stereo channels does no new spatialization.
-
-        // if we're muted, then mute
-        if (_isMuted)
-        {
-            memset(outputBufferChannel0, 0, sizeof(float) * numSamples);
-            memset(outputBufferChannel1, 0, sizeof(float) * numSamples);
-        }
-        else
-        {
-            // otherwise multiply by volume
-            for (int i = 0; i < numSamples; i++)
-            {
-                float value = _isMuted ? 0 : outputBufferChannel0[i];
-                outputBufferChannel0[i] = _volume * value;
-                outputBufferChannel1[i] = _volume * value;
-            }
-        }
+        // Stereo sources keep their own image; pan acts as a balance control.
+        AudioKernels::BalanceGains(panStart, volumeStart, leftStart, rightStart);
+        AudioKernels::BalanceGains(panEnd, volumeEnd, leftEnd, rightEnd);
+        AudioKernels::BalanceRamp(
+            outputBufferChannel0,
+            outputBufferChannel1,
+            leftStart,
+            leftEnd,
+            rightStart,
+            rightEnd,
+            1.0f,
+            numSamples);
     }
 }
 
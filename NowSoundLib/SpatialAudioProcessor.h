@@ -10,6 +10,7 @@
 #include "NowSoundGraph.h"
 #include "MeasurementAudioProcessor.h"
 #include "MeasurableAudio.h"
+#include "SmoothedParameter.h"
 
 namespace NowSound
 {
@@ -19,10 +20,12 @@ namespace NowSound
     class SpatialAudioProcessor : public BaseAudioProcessor, public MeasurableAudio
     {
         // current pan value; 0 = left, 0.5 = center, 1 = right
-        float _pan;
+        // linearly ramped on the audio thread, so changes don't click
+        SmoothedParameter _pan;
 
         // current volume; simple multiplier... use with caution, clipping can easily occur
-        float _volume;
+        // exponentially ramped on the audio thread, so changes don't click
+        SmoothedParameter _volume;
 
         // is this currently muted?
         // if so, output audio is zeroed
@@ -41,7 +44,8 @@ namespace NowSound
     public:
         SpatialAudioProcessor(NowSoundGraph* graph, const std::wstring& name, float initialVolume, float initialPan);
 
-        // Expect channel 0 to have mono audio data; update all channels with FX-applied output.
+        // With one input channel, expect channel 0 to have mono audio data, and pan it across both outputs; with two,
+        // apply pan as a balance control to the stereo pair.  Either way, apply volume.
         // Will clamp output values in the range (-1.0, 1.0); volumes above 1.0 are not recommended unless the whole loop is quiet
         // enough not to clip.
         virtual void processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
@@ -57,8 +61,8 @@ namespace NowSound
         // Get the output signal information of this processor (post-effects).
         virtual NowSoundSignalInfo SignalInfo() { return _outputProcessor->SignalInfo(); }
 
-        // Get the output frequency histogram, writing it into this (presumed) vector of floats.
-        virtual void GetFrequencies(void* floatBuffer, int floatBufferCapacity) { _outputProcessor->GetFrequencies(floatBuffer, floatBufferCapacity); }
+        // Get the output frequency histogram, writing it into this (presumed) vector of floats; return when it was measured.
+        virtual Time<AudioSample> GetFrequencies(void* floatBuffer, int floatBufferCapacity) { return _outputProcessor->GetFrequencies(floatBuffer, floatBufferCapacity); }
         
         // True if this is muted.
         // 
@@ -68,10 +72,13 @@ namespace NowSound
         void IsMuted(bool isMuted);
 
         // Get and set the pan value for this track. Values range from 0 (left) to 1 (right).
+        // Setting is lock-free and may be done at any rate; the audio thread ramps to the latest value.
+        // For stereo sources this is a balance: 0.5 passes both channels unchanged.
         float Pan() const;
         void Pan(float pan);
 
         // Get and set the volume of this track. 0 = mute; 1 = original input level. Use with caution; clipping can occur.
+        // Setting is lock-free and may be done at any rate; the audio thread ramps to the latest value.
         float Volume() const;
         void Volume(float volume);
 
@@ -0,0 +1,182 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "AnalysisWorkerPool.h"
+#include "Check.h"
+
+using namespace NowSound;
+using namespace std::chrono;
+
+AnalysisWorkerPool::AnalysisWorkerPool(
+    int workerCount,
+    microseconds pollInterval,
+    milliseconds idleTimeout,
+    TimelineRecorder* timeline)
+    : _pollInterval{ pollInterval },
+    _idleTimeout{ idleTimeout },
+    _mutex{},
+    _changed{},
+    _registrations{},
+    _stopping{ false },
+    _runCount{ 0 },
+    _discardCount{ 0 },
+    _timeline{ timeline },
+    _workers{}
+{
+    Check(workerCount > 0);
+    for (int i = 0; i < workerCount; i++)
+    {
+        _workers.push_back(std::thread([this]() { WorkerLoop(); }));
+    }
+}
+
+AnalysisWorkerPool::~AnalysisWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        Check(_registrations.empty());
+        _stopping = true;
+    }
+    _changed.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void AnalysisWorkerPool::Register(AnalysisJobSource* source)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _registrations.push_back(Registration{ source, false });
+}
+
+void AnalysisWorkerPool::Unregister(AnalysisJobSource* source)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // The registrations may be rearranged while we wait, so look the source up afresh each time.
+    auto find = [this, source]()
+    {
+        return std::find_if(
+            _registrations.begin(),
+            _registrations.end(),
+            [source](const Registration& registration) { return registration.Source == source; });
+    };
+    Check(find() != _registrations.end());
+
+    _changed.wait(lock, [&]() { return !find()->Claimed; });
+    _registrations.erase(find());
+}
+
+void AnalysisWorkerPool::WorkerLoop()
+{
+    // A claimed source, with the sort keys snapshotted (as LastPolled() may change under us).
+    struct Claim
+    {
+        AnalysisJobSource* Source;
+        int FftSize;
+        steady_clock::time_point LastPolled;
+        steady_clock::time_point GroupLastPolled;
+    };
+
+    // This worker's engines, one per FFT size; each is only ever used by this thread.
+    std::map<int, std::unique_ptr<FftEngine>> engines;
+    std::vector<Claim> claims;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping)
+    {
+        _changed.wait_for(lock, _pollInterval, [this]() { return _stopping; });
+        if (_stopping)
+        {
+            break;
+        }
+
+        claims.clear();
+        for (Registration& registration : _registrations)
+        {
+            if (!registration.Claimed && registration.Source->HasPendingJobs())
+            {
+                registration.Claimed = true;
+                // each claim's group starts out as recent as the claim itself; the ordering below raises it
+                steady_clock::time_point lastPolled = registration.Source->LastPolled();
+                claims.push_back(Claim{ registration.Source, registration.Source->FftSize(), lastPolled, lastPolled });
+            }
+        }
+
+        if (claims.empty())
+        {
+            continue;
+        }
+
+        lock.unlock();
+
+        // Order by size group (the group of the most recently polled source first), then by recency within the group.
+        for (Claim& claim : claims)
+        {
+            for (const Claim& other : claims)
+            {
+                if (other.FftSize == claim.FftSize && other.LastPolled > claim.GroupLastPolled)
+                {
+                    claim.GroupLastPolled = other.LastPolled;
+                }
+            }
+        }
+        std::sort(claims.begin(), claims.end(), [](const Claim& a, const Claim& b)
+        {
+            if (a.GroupLastPolled != b.GroupLastPolled) { return a.GroupLastPolled > b.GroupLastPolled; }
+            if (a.FftSize != b.FftSize) { return a.FftSize < b.FftSize; }
+            return a.LastPolled > b.LastPolled;
+        });
+
+        int64_t burstStartNanoseconds = TimingHistogram::Now();
+        int32_t burstRunCount = 0;
+        steady_clock::time_point now = steady_clock::now();
+        for (const Claim& claim : claims)
+        {
+            if (now - claim.LastPolled > _idleTimeout)
+            {
+                claim.Source->DiscardPendingJobs();
+                _discardCount++;
+            }
+            else
+            {
+                std::unique_ptr<FftEngine>& engine = engines[claim.FftSize];
+                if (engine == nullptr)
+                {
+                    engine.reset(new RealFftEngine(claim.FftSize));
+                }
+                claim.Source->RunPendingJobs(*engine);
+                _runCount++;
+                burstRunCount++;
+            }
+        }
+
+        if (_timeline != nullptr && burstRunCount > 0)
+        {
+            _timeline->Record(TimelineEvent::Create(
+                TimelineEventKind::FftBurst,
+                burstRunCount,
+                burstStartNanoseconds,
+                TimingHistogram::Now() - burstStartNanoseconds));
+        }
+
+        lock.lock();
+        for (Registration& registration : _registrations)
+        {
+            for (const Claim& claim : claims)
+            {
+                if (registration.Source == claim.Source)
+                {
+                    registration.Claimed = false;
+                }
+            }
+        }
+        _changed.notify_all();
+    }
+}
@@ -0,0 +1,129 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FftEngine.h"
+#include "TimelineRecorder.h"
+
+namespace NowSound
+{
+    // Something that queues up FFT work for the AnalysisWorkerPool -- in practice, a frequency tracker, whose audio
+    // thread queues a job per completed frame.
+    //
+    // The pool guarantees that at most one worker is calling into a given source at a time, so a source's queue
+    // only ever has one consumer.
+    class AnalysisJobSource
+    {
+    public:
+        virtual ~AnalysisJobSource() {}
+
+        // The FFT size this source's jobs need; the pool runs sources of the same size back to back, on one engine.
+        virtual int FftSize() const = 0;
+
+        // When did a reader (the UI) last poll this source's results?  Sources nobody has polled lately have their
+        // jobs discarded rather than run.
+        virtual std::chrono::steady_clock::time_point LastPolled() const = 0;
+
+        // Are any jobs queued?
+        virtual bool HasPendingJobs() const = 0;
+
+        // Run all queued jobs, using the given engine (whose Size() is FftSize()).
+        virtual void RunPendingJobs(FftEngine& engine) = 0;
+
+        // Drop all queued jobs without running them.
+        virtual void DiscardPendingJobs() = 0;
+    };
+
+    // A fixed set of threads which run the FFT jobs of all registered sources.
+    //
+    // Workers wake every pollInterval and look for sources with queued jobs; nothing ever signals them, so the
+    // audio threads which queue the jobs never make a system call on the pool's account.  Each worker claims the
+    // sources it found and runs them grouped by FFT size -- so several FFTs of the same size run together, with
+    // that size's tables hot in cache -- with groups and sources in order of how recently the UI polled them.
+    // Sources not polled within idleTimeout are assumed invisible, and their jobs are discarded instead.
+    //
+    // Registering and unregistering sources is done from non-audio threads, and takes the pool's lock.
+    //
+    // If given a timeline, each worker records an FftBurst there for every batch of sources it runs.
+    class AnalysisWorkerPool
+    {
+    private:
+        // A registered source.
+        struct Registration
+        {
+            // The source.
+            AnalysisJobSource* Source;
+
+            // Is some worker currently running this source?
+            bool Claimed;
+        };
+
+        // How often each worker looks for work.
+        const std::chrono::microseconds _pollInterval;
+
+        // How recently must a source have been polled for its jobs to be run?
+        const std::chrono::milliseconds _idleTimeout;
+
+        // Guards _registrations, the Claimed flags, and _stopping.
+        std::mutex _mutex;
+
+        // Signalled when workers should stop, and whenever a claim is released (for Unregister).
+        std::condition_variable _changed;
+
+        // All registered sources.
+        std::vector<Registration> _registrations;
+
+        // Are we shutting down?
+        bool _stopping;
+
+        // The number of jobs sources have had run, and had discarded, by all workers.
+        std::atomic<int64_t> _runCount;
+        std::atomic<int64_t> _discardCount;
+
+        // Where to record FftBursts, if anywhere.
+        TimelineRecorder* const _timeline;
+
+        // The worker threads.
+        std::vector<std::thread> _workers;
+
+        // The body of each worker thread.
+        void WorkerLoop();
+
+    public:
+        AnalysisWorkerPool(
+            int workerCount,
+            std::chrono::microseconds pollInterval,
+            std::chrono::milliseconds idleTimeout,
+            TimelineRecorder* timeline = nullptr);
+
+        AnalysisWorkerPool(const AnalysisWorkerPool&) = delete;
+        AnalysisWorkerPool& operator=(const AnalysisWorkerPool&) = delete;
+
+        // Stops and joins all workers.  All sources should have been unregistered.
+        ~AnalysisWorkerPool();
+
+        // Start running the given source's jobs.
+        void Register(AnalysisJobSource* source);
+
+        // Stop running the given source's jobs; waits for any worker currently running it to finish.
+        void Unregister(AnalysisJobSource* source);
+
+        // The number of times a source's jobs have been run.
+        int64_t RunCount() const { return _runCount; }
+
+        // The number of times a source's jobs have been discarded for lack of polling.
+        int64_t DiscardCount() const { return _discardCount; }
+    };
+}
@@ -0,0 +1,503 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "ThreadWorkCounters.h"
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+namespace NowSound
+{
+    // Inner loops over blocks of float samples.
+    //
+    // These use the widest vector instructions the compiler is targeting: AVX if enabled (/arch:AVX or -mavx),
+    // else SSE2 (always available on x64), else plain scalar code.  Each kernel uses aligned loads and stores when
+    // all of its pointers are aligned to the vector width -- which OwningBuf data and JUCE's channel buffers
+    // generally are -- and unaligned ones otherwise, so callers need not care.
+    //
+    // Each public kernel reports the bytes it reads and writes via NOWSOUND_KERNEL_TRAFFIC, which compiles to
+    // nothing unless a benchmark build defines NOWSOUND_COUNT_KERNEL_TRAFFIC.
+    namespace AudioKernels
+    {
+#if defined(__AVX__)
+        // Bytes per vector register.
+        const size_t VectorAlignment = 32;
+        // Floats per vector register.
+        const int64_t VectorWidth = 8;
+
+        typedef __m256 Vector;
+        inline Vector LoadAligned(const float* p) { return _mm256_load_ps(p); }
+        inline Vector LoadUnaligned(const float* p) { return _mm256_loadu_ps(p); }
+        inline void StoreAligned(float* p, Vector v) { _mm256_store_ps(p, v); }
+        inline void StoreUnaligned(float* p, Vector v) { _mm256_storeu_ps(p, v); }
+        inline Vector Splat(float f) { return _mm256_set1_ps(f); }
+        inline Vector Add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+        inline Vector Subtract(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+        inline Vector Multiply(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+        inline Vector Min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+        inline Vector Max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+        inline Vector Abs(Vector a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        inline Vector Sqrt(Vector a) { return _mm256_sqrt_ps(a); }
+        inline Vector Reverse(Vector a) { Vector r = _mm256_permute_ps(a, 0x1B); return _mm256_permute2f128_ps(r, r, 1); }
+        inline Vector LaneIndices() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        const size_t VectorAlignment = 16;
+        const int64_t VectorWidth = 4;
+
+        typedef __m128 Vector;
+        inline Vector LoadAligned(const float* p) { return _mm_load_ps(p); }
+        inline Vector LoadUnaligned(const float* p) { return _mm_loadu_ps(p); }
+        inline void StoreAligned(float* p, Vector v) { _mm_store_ps(p, v); }
+        inline void StoreUnaligned(float* p, Vector v) { _mm_storeu_ps(p, v); }
+        inline Vector Splat(float f) { return _mm_set1_ps(f); }
+        inline Vector Add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+        inline Vector Subtract(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+        inline Vector Multiply(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+        inline Vector Min(Vector a, Vector b) { return _mm_min_ps(a, b); }
+        inline Vector Max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+        inline Vector Abs(Vector a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        inline Vector Sqrt(Vector a) { return _mm_sqrt_ps(a); }
+        inline Vector Reverse(Vector a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)); }
+        inline Vector LaneIndices() { return _mm_setr_ps(0, 1, 2, 3); }
+#else
+        // No vector instructions; a "vector" is one float.
+        const size_t VectorAlignment = sizeof(float);
+        const int64_t VectorWidth = 1;
+
+        typedef float Vector;
+        inline Vector LoadAligned(const float* p) { return *p; }
+        inline Vector LoadUnaligned(const float* p) { return *p; }
+        inline void StoreAligned(float* p, Vector v) { *p = v; }
+        inline void StoreUnaligned(float* p, Vector v) { *p = v; }
+        inline Vector Splat(float f) { return f; }
+        inline Vector Add(Vector a, Vector b) { return a + b; }
+        inline Vector Subtract(Vector a, Vector b) { return a - b; }
+        inline Vector Multiply(Vector a, Vector b) { return a * b; }
+        inline Vector Min(Vector a, Vector b) { return a < b ? a : b; }
+        inline Vector Max(Vector a, Vector b) { return a > b ? a : b; }
+        inline Vector Abs(Vector a) { return std::fabs(a); }
+        inline Vector Sqrt(Vector a) { return std::sqrt(a); }
+        inline Vector Reverse(Vector a) { return a; }
+        inline Vector LaneIndices() { return 0; }
+#endif
+
+        // Is p aligned to a multiple of the vector width?
+        inline bool IsVectorAligned(const void* p) { return ((uintptr_t)p % VectorAlignment) == 0; }
+
+        // Load a vector, aligned or not.
+        template<bool Aligned>
+        inline Vector Load(const float* p) { return Aligned ? LoadAligned(p) : LoadUnaligned(p); }
+
+        // Store a vector, aligned or not.
+        template<bool Aligned>
+        inline void Store(float* p, Vector v) { if (Aligned) { StoreAligned(p, v); } else { StoreUnaligned(p, v); } }
+
+        inline float Clamp(float value, float limit) { return value < -limit ? -limit : (value > limit ? limit : value); }
+
+        // Copy count floats from source to destination.  The ranges must not overlap.
+        // memcpy already uses the widest aligned moves available, so this is only here for symmetry with the rest.
+        inline void Copy(float* destination, const float* source, int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(2 * count * sizeof(float));
+            std::memcpy(destination, source, count * sizeof(float));
+        }
+
+        // destination[i] = source[i] * gain.  destination may equal source.
+        template<bool Aligned>
+        inline void ScaleImpl(float* destination, const float* source, float gain, int64_t count)
+        {
+            Vector gainVector = Splat(gain);
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Store<Aligned>(destination + i, Multiply(Load<Aligned>(source + i), gainVector));
+            }
+            for (; i < count; i++)
+            {
+                destination[i] = source[i] * gain;
+            }
+        }
+
+        inline void Scale(float* destination, const float* source, float gain, int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(2 * count * sizeof(float));
+            if (IsVectorAligned(destination) && IsVectorAligned(source))
+            {
+                ScaleImpl<true>(destination, source, gain, count);
+            }
+            else
+            {
+                ScaleImpl<false>(destination, source, gain, count);
+            }
+        }
+
+        // destination[i] += source[i] * gain.
+        template<bool Aligned>
+        inline void MixImpl(float* destination, const float* source, float gain, int64_t count)
+        {
+            Vector gainVector = Splat(gain);
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Store<Aligned>(destination + i, Add(Load<Aligned>(destination + i), Multiply(Load<Aligned>(source + i), gainVector)));
+            }
+            for (; i < count; i++)
+            {
+                destination[i] += source[i] * gain;
+            }
+        }
+
+        inline void Mix(float* destination, const float* source, float gain, int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(3 * count * sizeof(float));
+            if (IsVectorAligned(destination) && IsVectorAligned(source))
+            {
+                MixImpl<true>(destination, source, gain, count);
+            }
+            else
+            {
+                MixImpl<false>(destination, source, gain, count);
+            }
+        }
+
+        // Interleave sampleCount samples from each of channelCount separate channels into destination, which will hold
+        // channelCount * sampleCount values.  Reading starts at channels[c][channelOffset].
+        template<typename T>
+        inline void Interleave(const T* const* channels, int channelCount, int64_t channelOffset, T* destination, int64_t sampleCount)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(2 * channelCount * sampleCount * sizeof(T));
+            if (channelCount == 2)
+            {
+                // the overwhelmingly common case, unrolled
+                const T* left = channels[0] + channelOffset;
+                const T* right = channels[1] + channelOffset;
+                for (int64_t i = 0; i < sampleCount; i++)
+                {
+                    destination[i * 2] = left[i];
+                    destination[i * 2 + 1] = right[i];
+                }
+                return;
+            }
+
+            for (int c = 0; c < channelCount; c++)
+            {
+                const T* channel = channels[c] + channelOffset;
+                T* dest = destination + c;
+                for (int64_t i = 0; i < sampleCount; i++)
+                {
+                    dest[i * channelCount] = channel[i];
+                }
+            }
+        }
+
+        // De-interleave sampleCount samples of channelCount interleaved values from source into separate channels.
+        // Writing starts at channels[c][channelOffset].
+        template<typename T>
+        inline void Deinterleave(const T* source, int channelCount, T* const* channels, int64_t channelOffset, int64_t sampleCount)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(2 * channelCount * sampleCount * sizeof(T));
+            if (channelCount == 2)
+            {
+                T* left = channels[0] + channelOffset;
+                T* right = channels[1] + channelOffset;
+                for (int64_t i = 0; i < sampleCount; i++)
+                {
+                    left[i] = source[i * 2];
+                    right[i] = source[i * 2 + 1];
+                }
+                return;
+            }
+
+            for (int c = 0; c < channelCount; c++)
+            {
+                T* channel = channels[c] + channelOffset;
+                const T* src = source + c;
+                for (int64_t i = 0; i < sampleCount; i++)
+                {
+                    channel[i] = src[i * channelCount];
+                }
+            }
+        }
+
+        // The minimum, maximum and sum of a block of values.
+        struct BlockSummary
+        {
+            float Min;
+            float Max;
+            double Sum;
+        };
+
+        // Reduce a vector's lanes to a BlockSummary, folding in the scalar tail values already accumulated.
+        inline BlockSummary Reduce(Vector min, Vector max, Vector sum, float tailMin, float tailMax, float tailSum)
+        {
+            float mins[VectorWidth];
+            float maxes[VectorWidth];
+            float sums[VectorWidth];
+            StoreUnaligned(mins, min);
+            StoreUnaligned(maxes, max);
+            StoreUnaligned(sums, sum);
+            BlockSummary summary{ tailMin, tailMax, tailSum };
+            for (int i = 0; i < VectorWidth; i++)
+            {
+                summary.Min = mins[i] < summary.Min ? mins[i] : summary.Min;
+                summary.Max = maxes[i] > summary.Max ? maxes[i] : summary.Max;
+                summary.Sum += sums[i];
+            }
+            return summary;
+        }
+
+        // Summarize count (> 0) values, or their absolute values.
+        // The sum is accumulated in float lanes, so it may differ from a sequential sum in the last few bits.
+        template<bool Absolute>
+        inline BlockSummary SummarizeImpl(const float* data, int64_t count)
+        {
+            float first = Absolute ? std::fabs(data[0]) : data[0];
+            Vector min = Splat(first);
+            Vector max = min;
+            Vector sum = Splat(0);
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Vector value = LoadUnaligned(data + i);
+                if (Absolute)
+                {
+                    value = Abs(value);
+                }
+                min = Min(min, value);
+                max = Max(max, value);
+                sum = Add(sum, value);
+            }
+            float tailMin = first, tailMax = first, tailSum = 0;
+            for (; i < count; i++)
+            {
+                float value = Absolute ? std::fabs(data[i]) : data[i];
+                tailMin = value < tailMin ? value : tailMin;
+                tailMax = value > tailMax ? value : tailMax;
+                tailSum += value;
+            }
+            return Reduce(min, max, sum, tailMin, tailMax, tailSum);
+        }
+
+        inline BlockSummary Summarize(const float* data, int64_t count, bool absoluteValue)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(count * sizeof(float));
+            return absoluteValue ? SummarizeImpl<true>(data, count) : SummarizeImpl<false>(data, count);
+        }
+
+        // Summarize the per-sample stereo magnitude |left| / 2 + |right| / 2 of count (> 0) samples.
+        inline BlockSummary SummarizeStereoMagnitude(const float* left, const float* right, int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(2 * count * sizeof(float));
+            Vector half = Splat(0.5f);
+            float first = std::fabs(left[0]) / 2 + std::fabs(right[0]) / 2;
+            Vector min = Splat(first);
+            Vector max = min;
+            Vector sum = Splat(0);
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Vector value = Add(
+                    Multiply(Abs(LoadUnaligned(left + i)), half),
+                    Multiply(Abs(LoadUnaligned(right + i)), half));
+                min = Min(min, value);
+                max = Max(max, value);
+                sum = Add(sum, value);
+            }
+            float tailMin = first, tailMax = first, tailSum = 0;
+            for (; i < count; i++)
+            {
+                float value = std::fabs(left[i]) / 2 + std::fabs(right[i]) / 2;
+                tailMin = value < tailMin ? value : tailMin;
+                tailMax = value > tailMax ? value : tailMax;
+                tailSum += value;
+            }
+            return Reduce(min, max, sum, tailMin, tailMax, tailSum);
+        }
+
+        // Pan a mono source into left and right, clamping the results to [-limit, limit].  Each gain ramps linearly
+        // from its start value at the first sample toward its end value, which it would reach at sample count; so
+        // a following block ramping onward from the end values continues the ramp seamlessly.  left may equal source.
+        template<bool Aligned>
+        inline void PanRampImpl(
+            const float* source,
+            float* left,
+            float* right,
+            float leftStart,
+            float leftEnd,
+            float rightStart,
+            float rightEnd,
+            float limit,
+            int64_t count)
+        {
+            float leftStep = count == 0 ? 0 : (leftEnd - leftStart) / count;
+            float rightStep = count == 0 ? 0 : (rightEnd - rightStart) / count;
+            // the gains for the current vector's lanes, advanced by a vector's worth of steps each time around
+            Vector leftGain = Add(Splat(leftStart), Multiply(Splat(leftStep), LaneIndices()));
+            Vector rightGain = Add(Splat(rightStart), Multiply(Splat(rightStep), LaneIndices()));
+            Vector leftVectorStep = Splat(leftStep * VectorWidth);
+            Vector rightVectorStep = Splat(rightStep * VectorWidth);
+            Vector upper = Splat(limit);
+            Vector lower = Splat(-limit);
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Vector value = Load<Aligned>(source + i);
+                Store<Aligned>(left + i, Max(lower, Min(upper, Multiply(value, leftGain))));
+                Store<Aligned>(right + i, Max(lower, Min(upper, Multiply(value, rightGain))));
+                leftGain = Add(leftGain, leftVectorStep);
+                rightGain = Add(rightGain, rightVectorStep);
+            }
+            for (; i < count; i++)
+            {
+                float value = source[i];
+                left[i] = Clamp(value * (leftStart + leftStep * i), limit);
+                right[i] = Clamp(value * (rightStart + rightStep * i), limit);
+            }
+        }
+
+        inline void PanRamp(
+            const float* source,
+            float* left,
+            float* right,
+            float leftStart,
+            float leftEnd,
+            float rightStart,
+            float rightEnd,
+            float limit,
+            int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(3 * count * sizeof(float));
+            if (IsVectorAligned(source) && IsVectorAligned(left) && IsVectorAligned(right))
+            {
+                PanRampImpl<true>(source, left, right, leftStart, leftEnd, rightStart, rightEnd, limit, count);
+            }
+            else
+            {
+                PanRampImpl<false>(source, left, right, leftStart, leftEnd, rightStart, rightEnd, limit, count);
+            }
+        }
+
+        // Pan a mono source into left and right with constant gains, clamping the results to [-limit, limit].
+        // left may equal source.
+        inline void Pan(const float* source, float* left, float* right, float leftGain, float rightGain, float limit, int64_t count)
+        {
+            PanRamp(source, left, right, leftGain, leftGain, rightGain, rightGain, limit, count);
+        }
+
+        // Scale a stereo pair in place, clamping the results to [-limit, limit]; the gains ramp as in PanRamp.
+        template<bool Aligned>
+        inline void BalanceRampImpl(
+            float* left,
+            float* right,
+            float leftStart,
+            float leftEnd,
+            float rightStart,
+            float rightEnd,
+            float limit,
+            int64_t count)
+        {
+            float leftStep = count == 0 ? 0 : (leftEnd - leftStart) / count;
+            float rightStep = count == 0 ? 0 : (rightEnd - rightStart) / count;
+            // the gains for the current vector's lanes, advanced by a vector's worth of steps each time around
+            Vector leftGain = Add(Splat(leftStart), Multiply(Splat(leftStep), LaneIndices()));
+            Vector rightGain = Add(Splat(rightStart), Multiply(Splat(rightStep), LaneIndices()));
+            Vector leftVectorStep = Splat(leftStep * VectorWidth);
+            Vector rightVectorStep = Splat(rightStep * VectorWidth);
+            Vector upper = Splat(limit);
+            Vector lower = Splat(-limit);
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Store<Aligned>(left + i, Max(lower, Min(upper, Multiply(Load<Aligned>(left + i), leftGain))));
+                Store<Aligned>(right + i, Max(lower, Min(upper, Multiply(Load<Aligned>(right + i), rightGain))));
+                leftGain = Add(leftGain, leftVectorStep);
+                rightGain = Add(rightGain, rightVectorStep);
+            }
+            for (; i < count; i++)
+            {
+                left[i] = Clamp(left[i] * (leftStart + leftStep * i), limit);
+                right[i] = Clamp(right[i] * (rightStart + rightStep * i), limit);
+            }
+        }
+
+        inline void BalanceRamp(
+            float* left,
+            float* right,
+            float leftStart,
+            float leftEnd,
+            float rightStart,
+            float rightEnd,
+            float limit,
+            int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(4 * count * sizeof(float));
+            if (IsVectorAligned(left) && IsVectorAligned(right))
+            {
+                BalanceRampImpl<true>(left, right, leftStart, leftEnd, rightStart, rightEnd, limit, count);
+            }
+            else
+            {
+                BalanceRampImpl<false>(left, right, leftStart, leftEnd, rightStart, rightEnd, limit, count);
+            }
+        }
+
+        // Scale a stereo pair in place by constant gains, clamping the results to [-limit, limit].
+        inline void Balance(float* left, float* right, float leftGain, float rightGain, float limit, int64_t count)
+        {
+            BalanceRamp(left, right, leftGain, leftGain, rightGain, rightGain, limit, count);
+        }
+
+        // The gains for Pan(): a constant-power (sine/cosine) pan law, so a mono source keeps the same loudness
+        // wherever it is placed.  pan is 0 (left) to 1 (right); both gains include volume.
+        inline void PanGains(float pan, float volume, float& leftGain, float& rightGain)
+        {
+            const float HalfPi = 1.5707963267948966f;
+            leftGain = std::cos(pan * HalfPi) * volume;
+            rightGain = std::sin(pan * HalfPi) * volume;
+        }
+
+        // The gains for Balance(): at center both channels pass unchanged, and moving toward one side attenuates
+        // the other channel along a quarter cosine, reaching silence at the extreme.  Unlike PanGains, this never
+        // moves one channel's content into the other, so a stereo source keeps its image.
+        inline void BalanceGains(float pan, float volume, float& leftGain, float& rightGain)
+        {
+            const float Pi = 3.1415926535897931f;
+            leftGain = (pan <= 0.5f ? 1 : std::cos((pan - 0.5f) * Pi)) * volume;
+            rightGain = (pan >= 0.5f ? 1 : std::sin(pan * Pi)) * volume;
+        }
+
+        // magnitudes[i] = |real[i] + imaginary[i] * i|.  Always unaligned, as FFT bin counts are rarely a multiple
+        // of the vector width anyway.
+        inline void Magnitude(const float* real, const float* imaginary, float* magnitudes, int64_t count)
+        {
+            NOWSOUND_KERNEL_TRAFFIC(3 * count * sizeof(float));
+            int64_t vectorCount = count - (count % VectorWidth);
+            int64_t i = 0;
+            for (; i < vectorCount; i += VectorWidth)
+            {
+                Vector re = LoadUnaligned(real + i);
+                Vector im = LoadUnaligned(imaginary + i);
+                StoreUnaligned(magnitudes + i, Sqrt(Add(Multiply(re, re), Multiply(im, im))));
+            }
+            for (; i < count; i++)
+            {
+                magnitudes[i] = std::sqrt(real[i] * real[i] + imaginary[i] * imaginary[i]);
+            }
+        }
+    }
+}
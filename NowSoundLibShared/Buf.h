@@ -4,33 +4,76 @@
 #pragma once
 
 #include "stdafx.h"
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
 #include "Check.h"
 
 namespace NowSound
 {
-    // Buffer of data; owns the data contained within it.
+    // Deleter for storage allocated with the aligned form of operator new[].  Storage borrowed from elsewhere (such as
+    // a BufferAllocator's arena, which releases all its storage at once) is left alone.
+    template<typename T, size_t Alignment>
+    struct AlignedArrayDeleter
+    {
+        // Is the storage borrowed, and hence not ours to delete?
+        bool IsBorrowed;
+
+        AlignedArrayDeleter(bool isBorrowed = false) : IsBorrowed{ isBorrowed } {}
+
+        void operator()(T* data) const
+        {
+            if (!IsBorrowed)
+            {
+                ::operator delete[](data, std::align_val_t(Alignment));
+            }
+        }
+    };
+
+    // Buffer of data; owns the data contained within it, unless the data is borrowed (see IsBorrowed()).
+    // The data is aligned to a cache line, which is also wide enough for any SIMD load or store we use.
+    // T must be plain data, as the storage is never constructed or destructed, only reused.
     template<typename T>
     class OwningBuf
     {
+    public:
+        // Alignment in bytes of the start of every OwningBuf's data.
+        static const size_t Alignment = 64;
+
+    private:
+        static_assert(std::is_trivial<T>::value, "OwningBuf holds plain data only");
+
         int _id;
-        std::unique_ptr<T> _data;
+        std::unique_ptr<T[], AlignedArrayDeleter<T, Alignment>> _data;
         int _length;
 
+        // Allocate uninitialized, aligned storage for length T values.
+        static T* AllocateAligned(int length)
+        {
+            Check(length > 0);
+            return (T*)::operator new[](length * sizeof(T), std::align_val_t(Alignment));
+        }
+
     public:
         OwningBuf() = delete;
 
-        // Create a new OwningBuf with a newly allocated T[length] backing store.
+        // Create a new OwningBuf with a newly allocated, aligned T[length] backing store.
         OwningBuf(int id, int length)
-            : _id(id), _data(std::unique_ptr<T>(new T[length])), _length(length)
+            : _id(id), _data(AllocateAligned(length)), _length(length)
         {
             Check(length > 0);
         }
 
-        // Create an OwningBuf which takes ownership of rawBuffer (which had better have the given length).
-        OwningBuf(int id, int length, T* rawBuffer)
-            : _id(id), _data(std::unique_ptr<T>(rawBuffer)), _length(length)
+        // Create an OwningBuf which takes ownership of rawBuffer (which had better have the given length, and
+        // have come from Release() on another OwningBuf).  If isBorrowed, rawBuffer belongs to something else which
+        // outlives this OwningBuf (such as an arena), and dropping this OwningBuf leaves it alone.
+        OwningBuf(int id, int length, T* rawBuffer, bool isBorrowed = false)
+            : _id(id), _data(rawBuffer, AlignedArrayDeleter<T, Alignment>(isBorrowed)), _length(length)
         {
             Check(length > 0);
+            Check(((uintptr_t)rawBuffer % Alignment) == 0);
         }
 
         // Move constructor.
@@ -49,6 +92,16 @@ namespace NowSound
         T* Data() const { return _data.get(); }
         // Count of T values in the actual data; NOT a count of slivers (those are a Slice-level concept).
         int Length() const { return _length; }
+        // Is the data borrowed rather than owned, so that dropping this buffer does not release it?
+        bool IsBorrowed() const { return _data.get_deleter().IsBorrowed; }
+
+        // Release ownership of the data to the caller, leaving this buffer empty.
+        // The caller must later hand the data back to an OwningBuf to release it.
+        T* Release()
+        {
+            _length = 0;
+            return _data.release();
+        }
 
         bool operator==(const OwningBuf<T>& other) const
         {
@@ -5,82 +5,403 @@
 
 #include "stdafx.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "Buf.h"
+#include "MemoryArena.h"
 
 namespace NowSound
 {
     // Allocate T[] of a predetermined size, and support returning such T[] to a free list.
+    //
+    // This allocator is safe to use concurrently from any number of threads, and takes no locks:
+    // the audio thread allocates from it (when appending to a recording stream) at the same time as
+    // the UI thread frees into it (when deleting a track).
+    //
+    // Every buffer this allocator ever creates gets a permanent slot, indexed by (buffer ID - 1).  A slot
+    // owns its buffer's storage whenever that buffer is on the free list.  The free list itself is a
+    // lock-free LIFO stack of slot indices, whose head is tagged with a counter to avoid ABA races.
+    //
+    // If CheckFrees is true, Free() verifies in O(1), via the slot's state flag, that the buffer is really ours
+    // and is not already free.  This defaults to on in debug builds and off in release builds, where freeing a
+    // buffer is then just a push.
+    //
+    // Allocating when the free list is empty falls back to the heap, which the audio thread must avoid.  So the
+    // allocator can run a background refill thread, which tops the free list back up whenever it falls below a
+    // low watermark; the audio thread then only hits the heap if it drains the free list faster than that.
+    //
+    // Optionally, the allocator can carve its first buffers out of a single MemoryArena (huge-page-backed,
+    // prefaulted and locked), rather than from the heap.  Arena buffers cycle between the free list and their
+    // holders like any others, and are only released when the allocator is.  They are handed out as borrowed
+    // OwningBufs, so a holder which drops one rather than calling Free() does no harm beyond losing that buffer
+    // for the allocator's lifetime.
     template<typename T>
     class BufferAllocator
     {
     private:
-        int _latestBufferId = 1; // 0 = empty buf
+        // The slot for a single buffer.
+        struct Slot
+        {
+            // The storage of this slot's buffer.  This is an owning pointer only while IsFree is true;
+            // ~BufferAllocator releases it in that case.
+            T* Data;
+
+            // Is this slot's buffer currently on the free list?
+            std::atomic<bool> IsFree;
+
+            // The slot index (plus one) of the next slot on the free list; 0 if this is the last.
+            std::atomic<uint32_t> Next;
+
+            Slot() : Data{ nullptr }, IsFree{ false }, Next{ 0 } {}
+        };
+
+        // Slots are allocated in segments, so that slot addresses are stable without ever reallocating.
+        static const int SegmentSize = 1024;
+
+        // With this many segments we can track over a million buffers, which at a second per buffer
+        // is far more audio than any machine will hold in memory.
+        static const int MaxSegmentCount = 1024;
+
+        // The segments of the slot table; each entry is null until some slot within it is needed.
+        // Entries are owning pointers, released in ~BufferAllocator.
+        std::atomic<Slot*> _segments[MaxSegmentCount];
+
+        // The free list head: the low 32 bits are the slot index plus one (0 = empty list); the high 32 bits are
+        // a tag incremented on every pop, so a stale head can never be successfully swapped back in.
+        std::atomic<uint64_t> _freeListHead;
+
+        // The most recently assigned buffer ID; 0 = empty buf.
+        std::atomic<int> _latestBufferId;
+
+        // Total number of buffers we have ever allocated.
+        std::atomic<int> _totalBufferCount;
+
+        // Number of buffers currently on the free list.
+        std::atomic<int> _freeBufferCount;
+
+        // Number of times Allocate() found the free list empty and had to allocate from the heap.
+        std::atomic<int> _forcedAllocationCount;
+
+        // The arena from which the first _arenaBufferCount buffers are carved; null if not using an arena.
+        std::unique_ptr<MemoryArena> _arena;
+
+        // Number of buffers the arena holds.
+        int _arenaBufferCount;
+
+        // Distance in bytes between successive buffers in the arena; a multiple of OwningBuf<T>::Alignment.
+        size_t _arenaStride;
+
+        // Number of buffers carved from the arena so far (may overshoot _arenaBufferCount once the arena is full).
+        std::atomic<int> _arenaBuffersCarved;
+
+        // The background refill thread, if running.
+        std::thread _refillThread;
+
+        // Mutex and condition used only to wake the refill thread for shutdown; never touched by Allocate or Free.
+        std::mutex _refillMutex;
+        std::condition_variable _refillCondition;
+
+        // Set (under _refillMutex) to tell the refill thread to exit.
+        bool _stopRefilling;
 
     public:
+#ifdef _DEBUG
+        static const bool DefaultCheckFrees = true;
+#else
+        static const bool DefaultCheckFrees = false;
+#endif
+
         // The number of T in a buffer from this allocator.
         const int BufferLength;
 
+        // Does Free() check that buffers are ours and not already free?
+        const bool CheckFrees;
+
     private:
-        // Free list; we recycle from here if possible.
-        // This allocator owns all these buffers.
-        std::vector<OwningBuf<T>> _freeList;
+        // Get the slot for the given buffer ID; the slot's segment must already exist.
+        Slot& SlotFor(int bufferId)
+        {
+            int slotIndex = bufferId - 1;
+            Slot* segment = _segments[slotIndex / SegmentSize].load(std::memory_order_acquire);
+            Check(segment != nullptr);
+            return segment[slotIndex % SegmentSize];
+        }
 
-        // Total number of buffers we have ever allocated.
-        int _totalBufferCount;
+        // Ensure the segment holding the given buffer ID's slot exists.
+        // If two threads race to create the same segment, the loser discards its copy.
+        void EnsureSegment(int bufferId)
+        {
+            int segmentIndex = (bufferId - 1) / SegmentSize;
+            Check(segmentIndex < MaxSegmentCount);
+
+            if (_segments[segmentIndex].load(std::memory_order_acquire) == nullptr)
+            {
+                std::unique_ptr<Slot[]> newSegment{ new Slot[SegmentSize] };
+                Slot* expected = nullptr;
+                if (_segments[segmentIndex].compare_exchange_strong(expected, newSegment.get(), std::memory_order_acq_rel))
+                {
+                    // the segment table owns it now
+                    newSegment.release();
+                }
+            }
+        }
+
+        // Create a brand new buffer, not from the free list.
+        OwningBuf<T> NewBuffer()
+        {
+            int id = ++_latestBufferId;
+            EnsureSegment(id);
+            _totalBufferCount++;
+
+            if (_arena != nullptr)
+            {
+                int arenaIndex = _arenaBuffersCarved++;
+                if (arenaIndex < _arenaBufferCount)
+                {
+                    T* data = (T*)(_arena->Base() + arenaIndex * _arenaStride);
+                    SlotFor(id).Data = data;
+                    return OwningBuf<T>(id, BufferLength, data, /*isBorrowed*/true);
+                }
+            }
+
+            OwningBuf<T> result(id, BufferLength);
+            SlotFor(id).Data = result.Data();
+            return result;
+        }
+
+        // Push the slot for the given buffer ID onto the free list.
+        void Push(int bufferId)
+        {
+            Slot& slot = SlotFor(bufferId);
+            uint64_t oldHead = _freeListHead.load(std::memory_order_relaxed);
+            uint64_t newHead;
+            do
+            {
+                slot.Next.store((uint32_t)oldHead, std::memory_order_relaxed);
+                newHead = (oldHead & 0xFFFFFFFF00000000ull) | (uint32_t)bufferId;
+            }
+            while (!_freeListHead.compare_exchange_weak(oldHead, newHead, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Pop a buffer ID from the free list; return 0 if the free list is empty.
+        int Pop()
+        {
+            uint64_t oldHead = _freeListHead.load(std::memory_order_acquire);
+            uint64_t newHead;
+            do
+            {
+                uint32_t bufferId = (uint32_t)oldHead;
+                if (bufferId == 0)
+                {
+                    return 0;
+                }
+
+                uint32_t next = SlotFor(bufferId).Next.load(std::memory_order_relaxed);
+                uint64_t tag = (oldHead >> 32) + 1;
+                newHead = (tag << 32) | next;
+            }
+            while (!_freeListHead.compare_exchange_weak(oldHead, newHead, std::memory_order_acq_rel, std::memory_order_acquire));
+
+            return (int)(uint32_t)oldHead;
+        }
 
     public:
-        // bufferLength is the number of values in each buffer; initialNumberOfBuffers is the number of buffers to pre-allocate
-        BufferAllocator(int bufferLength, int initialNumberOfBuffers)
-            : BufferLength(bufferLength)
+        // bufferLength is the number of values in each buffer; initialNumberOfBuffers is the number of buffers to pre-allocate;
+        // checkFrees determines whether Free() validates its argument; arenaBufferCount, if nonzero, is the number of buffers
+        // to carve out of a MemoryArena before falling back to the heap.
+        BufferAllocator(int bufferLength, int initialNumberOfBuffers, bool checkFrees = DefaultCheckFrees, int arenaBufferCount = 0)
+            : _freeListHead{ 0 },
+            _latestBufferId{ 0 },
+            _totalBufferCount{ 0 },
+            _freeBufferCount{ 0 },
+            _forcedAllocationCount{ 0 },
+            _arena{ nullptr },
+            _arenaBufferCount{ arenaBufferCount },
+            _arenaStride{ 0 },
+            _arenaBuffersCarved{ 0 },
+            _refillThread{},
+            _refillMutex{},
+            _refillCondition{},
+            _stopRefilling{ false },
+            BufferLength(bufferLength),
+            CheckFrees(checkFrees)
         {
             Check(bufferLength > 0);
             Check(initialNumberOfBuffers > 0);
+            Check(arenaBufferCount >= 0);
 
-            // Prepopulate the free list as a way of preallocating.
-            for (int i = 0; i < initialNumberOfBuffers; i++)
+            if (arenaBufferCount > 0)
             {
-                OwningBuf<T> buf(_latestBufferId++, bufferLength);
-                _freeList.push_back(std::move(buf));
+                const size_t alignment = OwningBuf<T>::Alignment;
+                _arenaStride = (bufferLength * sizeof(T) + alignment - 1) / alignment * alignment;
+                _arena = std::unique_ptr<MemoryArena>(new MemoryArena(_arenaStride * arenaBufferCount));
+            }
+
+            for (int i = 0; i < MaxSegmentCount; i++)
+            {
+                _segments[i].store(nullptr, std::memory_order_relaxed);
+            }
+
+            // Prepopulate the free list as a way of preallocating; this includes the whole arena, if any.
+            for (int i = 0; i < initialNumberOfBuffers || i < arenaBufferCount; i++)
+            {
+                Free(NewBuffer());
             }
-            _totalBufferCount = initialNumberOfBuffers;
         }
 
         // no copying this
         BufferAllocator(const BufferAllocator&) = delete;
 
+        // Release all heap buffers on the free list, the slot table, and the arena.
+        // Buffers which are still allocated are owned by their holders, who must not free them after this.
+        ~BufferAllocator()
+        {
+            StopRefillThread();
+
+            for (int i = 0; i < MaxSegmentCount; i++)
+            {
+                std::unique_ptr<Slot[]> segment{ _segments[i].load(std::memory_order_acquire) };
+                if (segment == nullptr)
+                {
+                    continue;
+                }
+
+                for (int j = 0; j < SegmentSize; j++)
+                {
+                    if (segment[j].IsFree.load(std::memory_order_acquire)
+                        && (_arena == nullptr || !_arena->Contains(segment[j].Data)))
+                    {
+                        // reconstitute the OwningBuf just so it releases the storage
+                        OwningBuf<T> dropped(i * SegmentSize + j + 1, BufferLength, segment[j].Data);
+                    }
+                }
+            }
+        }
+
         // Number of bytes reserved by this allocator; will increase if free list runs out, and includes free space.
-        long TotalReservedSpace() { return _totalBufferCount * BufferLength * sizeof(T); }
+        long TotalReservedSpace() const { return (long)_totalBufferCount.load() * BufferLength * sizeof(T); }
 
         // Number of bytes held in buffers on the free list.
-        long TotalFreeListSpace() { return _freeList.Count * BufferLength * sizeof(T); }
+        long TotalFreeListSpace() const { return (long)_freeBufferCount.load() * BufferLength * sizeof(T); }
 
-        // Allocate a new Buf<T>; this is an owning Buf<T>.
-        // TODO: needs thread safety or contractual thread affinity
-        OwningBuf<T> Allocate()
+        // The arena backing this allocator, or null if none.
+        const MemoryArena* Arena() const { return _arena.get(); }
+
+        // Number of buffers currently on the free list.
+        int FreeBufferCount() const { return _freeBufferCount.load(); }
+
+        // Number of times Allocate() has had to allocate from the heap because the free list was empty.
+        int ForcedAllocationCount() const { return _forcedAllocationCount.load(); }
+
+        // If fewer than lowWatermark buffers are free, allocate new buffers onto the free list until targetFreeCount are free.
+        // Returns the number of buffers added.  Safe to call concurrently with Allocate() and Free(), but it does hit
+        // the heap, so call it from anywhere but the audio thread.
+        int Refill(int lowWatermark, int targetFreeCount)
         {
-            if (_freeList.size() == 0)
+            Check(lowWatermark <= targetFreeCount);
+
+            int added = 0;
+            if (_freeBufferCount.load() < lowWatermark)
             {
-                _totalBufferCount++;
-                OwningBuf<T> result(_latestBufferId++, BufferLength);
-                return result;
+                while (_freeBufferCount.load() < targetFreeCount)
+                {
+                    Free(NewBuffer());
+                    added++;
+                }
             }
-            else
+            return added;
+        }
+
+        // Start a background thread which calls Refill(lowWatermark, targetFreeCount) every refillInterval.
+        // Must not already be running.
+        void StartRefillThread(int lowWatermark, int targetFreeCount, std::chrono::milliseconds refillInterval)
+        {
+            Check(!_refillThread.joinable());
+            Check(lowWatermark <= targetFreeCount);
+
+            _stopRefilling = false;
+            _refillThread = std::thread([this, lowWatermark, targetFreeCount, refillInterval]()
+            {
+                std::unique_lock<std::mutex> lock(_refillMutex);
+                while (!_stopRefilling)
+                {
+                    lock.unlock();
+                    Refill(lowWatermark, targetFreeCount);
+                    lock.lock();
+
+                    _refillCondition.wait_for(lock, refillInterval, [this]() { return _stopRefilling; });
+                }
+            });
+        }
+
+        // Stop the background refill thread, if running, and wait for it to exit.
+        void StopRefillThread()
+        {
+            if (!_refillThread.joinable())
+            {
+                return;
+            }
+
             {
-                OwningBuf<T> ret(std::move(_freeList[_freeList.size() - 1]));
-                _freeList.erase(_freeList.end() - 1);
-                return ret;
+                std::lock_guard<std::mutex> guard(_refillMutex);
+                _stopRefilling = true;
             }
+            _refillCondition.notify_one();
+            _refillThread.join();
+        }
+
+        // Allocate a new Buf<T>; this is an owning Buf<T>.
+        // Safe to call from any thread; lock-free unless the free list is empty, in which case this allocates from the heap.
+        OwningBuf<T> Allocate()
+        {
+            int bufferId = Pop();
+            if (bufferId == 0)
+            {
+                _forcedAllocationCount++;
+                return NewBuffer();
+            }
+
+            _freeBufferCount--;
+
+            Slot& slot = SlotFor(bufferId);
+            slot.IsFree.store(false, std::memory_order_relaxed);
+            return OwningBuf<T>(bufferId, BufferLength, slot.Data, _arena != nullptr && _arena->Contains(slot.Data));
         }
 
         // Free the given buffer back to the pool.
+        // Safe to call from any thread; lock-free, and O(1) whether or not CheckFrees is set.
         virtual void Free(OwningBuf<T>&& buffer)
         {
-            // must not already be on free list or we have a bug
-            for (const OwningBuf<T>& t : _freeList)
+            int bufferId = buffer.Id();
+
+            if (CheckFrees)
+            {
+                // must be one of ours
+                Check(bufferId > 0 && bufferId <= _latestBufferId.load());
+                Check(buffer.Length() == BufferLength);
+                Check(buffer.Data() == SlotFor(bufferId).Data);
+            }
+
+            // the slot owns the storage from here on
+            buffer.Release();
+
+            Slot& slot = SlotFor(bufferId);
+            if (CheckFrees)
+            {
+                // must not already be on free list or we have a bug; the exchange catches even racing double frees
+                Check(!slot.IsFree.exchange(true, std::memory_order_relaxed));
+            }
+            else
             {
-                Check(!(buffer == t)); // TODO: Buf<T>::operator!=
+                slot.IsFree.store(true, std::memory_order_relaxed);
             }
-            _freeList.push_back(std::move(buffer));
+
+            _freeBufferCount++;
+            Push(bufferId);
         }
     };
 }
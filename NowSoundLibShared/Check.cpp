@@ -1,5 +1,3 @@
-#pragma once
-
 // NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
 // Licensed under the MIT license
 
@@ -13,7 +11,7 @@ namespace NowSound
     {
         if (!condition)
         {
-            DebugBreak();
+            Platform::DebugBreak();
             std::abort();
         }
     }
@@ -4,9 +4,10 @@
 // Licensed under the MIT license
 
 #include "stdafx.h"
+#include "Platform.h"
 
 namespace NowSound
 {
     // Unconditional check that runs whether in debug mode or not.
-    void __declspec(dllexport) Check(bool condition);
+    void NOWSOUND_EXPORT Check(bool condition);
 }
\ No newline at end of file
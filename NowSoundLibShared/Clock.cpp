@@ -7,9 +7,6 @@
 using namespace NowSound;
 using namespace std;
 using namespace std::chrono;
-using namespace winrt;
-
-using namespace winrt::Windows::Foundation;
 
 std::unique_ptr<NowSound::Clock> NowSound::Clock::s_instance;
 
@@ -31,7 +28,8 @@ NowSound::Clock::Clock(int sampleRateHz, int channelCount, float beatsPerMinute,
     _beatsPerMinute(beatsPerMinute),
     _beatsPerMeasure(beatsPerMeasure),
     _now(0),
-    _beatDuration(0)
+    _beatDuration(0),
+    _exactBeatDuration(0, 1)
 {
     Check(!IsInitialized()); // No Clock yet
     CalculateBeatDuration();
@@ -39,7 +37,15 @@ NowSound::Clock::Clock(int sampleRateHz, int channelCount, float beatsPerMinute,
 
 void NowSound::Clock::CalculateBeatDuration()
 {
-    _beatDuration = (ContinuousDuration<AudioSample>)(((float)SampleRateHz() * 60) / _beatsPerMinute);
+    Check(_beatsPerMinute > 0);
+
+    // A float BPM is exactly some integer over a power of two, so the beat duration (sampleRate * 60 / BPM)
+    // is exactly rational as well.
+    RationalDuration<Beat> exactBeatsPerMinute(_beatsPerMinute);
+    _exactBeatDuration = RationalDuration<AudioSample>(
+        (int64_t)SampleRateHz() * 60 * exactBeatsPerMinute.Denominator(),
+        exactBeatsPerMinute.Numerator());
+    _beatDuration = (ContinuousDuration<AudioSample>)_exactBeatDuration.Value();
 }
 
 void NowSound::Clock::BeatsPerMinute(float value)
@@ -65,6 +65,9 @@ namespace NowSound
         // This will be a non-integer value if the BPM does not exactly divide the sample rate.
         ContinuousDuration<AudioSample> _beatDuration;
 
+        // The exact duration of a beat, in samples; _beatDuration is the nearest float to this.
+        RationalDuration<AudioSample> _exactBeatDuration;
+
         // Calculate the _beatDuration based on _beatsPerMinute.
         // TODO: this doesn't seem like a good way to do this -- why not do this at construction?
         void CalculateBeatDuration();
@@ -93,28 +96,45 @@ namespace NowSound
 
         ContinuousDuration<AudioSample> BeatDuration() const { return _beatDuration; }
 
+        // The exact duration of a beat; use this for anything that must stay sample-accurate over long sessions.
+        RationalDuration<AudioSample> ExactBeatDuration() const { return _exactBeatDuration; }
+
         int BeatsPerMeasure() { return _beatsPerMeasure; }
 
         Time<AudioSample> Now() { return _now; }
 
         Duration<AudioSample> TimeToSamples(ContinuousDuration<Second> seconds) { return (int64_t)(SampleRateHz() * seconds.Value()); }
 
-        // Approximately how many beats?
+        // Approximately how many beats?  As the result is a duration, time must not be negative.
         ContinuousDuration<Beat> TimeToBeats(Time<AudioSample> time) const
         {
-            return ContinuousDuration<Beat>(
-                (float)time.Value() /
-                Clock::Instance().BeatDuration().Value());
+            Check(time.Value() >= 0);
+            int64_t completeBeats;
+            int64_t remainder;
+            _exactBeatDuration.Divide(time.Value(), completeBeats, remainder);
+            return ContinuousDuration<Beat>((float)(completeBeats + (double)remainder / _exactBeatDuration.Numerator()));
+        }
+
+        // Exactly how many complete beats?  Times before zero count down from beat -1.
+        int64_t TimeToCompleteBeats(Time<AudioSample> time) const
+        {
+            int64_t completeBeats;
+            int64_t remainder;
+            _exactBeatDuration.Divide(time.Value(), completeBeats, remainder);
+            return completeBeats;
         }
 
         // empirically seen some Beats values come too close to this
         const double Epsilon = 0.0001; 
         
         // What fraction of a beat?
+        // This is computed exactly before rounding, so it stays accurate however many beats have passed.
         ContinuousDuration<Beat> TimeToFractionalBeat(Time<AudioSample> time) const
         {
-            float beatValue = TimeToBeats(time).Value();
-            return ContinuousDuration<Beat>(beatValue - std::floor(beatValue));
+            int64_t completeBeats;
+            int64_t remainder;
+            _exactBeatDuration.Divide(time.Value(), completeBeats, remainder);
+            return ContinuousDuration<Beat>((float)((double)remainder / _exactBeatDuration.Numerator()));
         }
     };
 }
@@ -0,0 +1,331 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#include "stdafx.h"
+
+#include <cmath>
+
+#include "AudioKernels.h"
+#include "Check.h"
+#include "FftEngine.h"
+
+using namespace NowSound;
+using namespace NowSound::AudioKernels;
+
+// Compute the twiddle W(n)^j = exp(-2 * pi * i * j / n) in double precision, rounding only the result.
+static void Twiddle(int j, int n, float& real, float& imaginary)
+{
+    double angle = -2 * RosettaFFT::PI * j / n;
+    real = (float)std::cos(angle);
+    imaginary = (float)std::sin(angle);
+}
+
+RealFftEngine::RealFftEngine(int size)
+    : _size{ size },
+    _halfSize{ size / 2 },
+    _bitReversal(size / 2),
+    _twiddles{},
+    _splitCosines(size / 2),
+    _splitSines(size / 2),
+    _real(size / 2),
+    _imaginary(size / 2)
+{
+    Check(size >= 4);
+    Check((size & (size - 1)) == 0);
+
+    int stageCount = 0;
+    while ((1 << stageCount) < _halfSize)
+    {
+        stageCount++;
+    }
+
+    for (int m = 0; m < _halfSize; m++)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < stageCount; bit++)
+        {
+            reversed |= ((m >> bit) & 1) << (stageCount - 1 - bit);
+        }
+        _bitReversal[m] = reversed;
+    }
+
+    // Lay out the twiddles in the order Transform() will consume them.
+    int h = 1;
+    int remainingStages = stageCount;
+    while (remainingStages > 0)
+    {
+        int passOffset = (int)_twiddles.size();
+        bool radixFour = remainingStages >= 2;
+        _twiddles.resize(passOffset + (radixFour ? 4 : 2) * h);
+        for (int j = 0; j < h; j++)
+        {
+            Twiddle(j, 2 * h, _twiddles[passOffset + j], _twiddles[passOffset + h + j]);
+            if (radixFour)
+            {
+                Twiddle(j, 4 * h, _twiddles[passOffset + 2 * h + j], _twiddles[passOffset + 3 * h + j]);
+            }
+        }
+        h *= radixFour ? 4 : 2;
+        remainingStages -= radixFour ? 2 : 1;
+    }
+
+    for (int k = 0; k < _halfSize; k++)
+    {
+        double angle = 2 * RosettaFFT::PI * k / _size;
+        _splitCosines[k] = (float)std::cos(angle);
+        _splitSines[k] = (float)std::sin(angle);
+    }
+}
+
+int RealFftEngine::RadixFourPass(int h, int twiddleOffset)
+{
+    const float* w1r = _twiddles.data() + twiddleOffset;
+    const float* w1i = w1r + h;
+    const float* w2r = w1r + 2 * h;
+    const float* w2i = w1r + 3 * h;
+
+    for (int block = 0; block < _halfSize; block += 4 * h)
+    {
+        float* ar = _real.data() + block;
+        float* ai = _imaginary.data() + block;
+        float* br = ar + h;
+        float* bi = ai + h;
+        float* cr = ar + 2 * h;
+        float* ci = ai + 2 * h;
+        float* dr = ar + 3 * h;
+        float* di = ai + 3 * h;
+
+        int j = 0;
+        if (h >= VectorWidth)
+        {
+            for (; j < h; j += (int)VectorWidth)
+            {
+                Vector vw1r = LoadUnaligned(w1r + j), vw1i = LoadUnaligned(w1i + j);
+                Vector vw2r = LoadUnaligned(w2r + j), vw2i = LoadUnaligned(w2i + j);
+                Vector var = LoadUnaligned(ar + j), vai = LoadUnaligned(ai + j);
+                Vector vbr = LoadUnaligned(br + j), vbi = LoadUnaligned(bi + j);
+                Vector vcr = LoadUnaligned(cr + j), vci = LoadUnaligned(ci + j);
+                Vector vdr = LoadUnaligned(dr + j), vdi = LoadUnaligned(di + j);
+
+                // first stage: (a, b) and (c, d), both twiddled by W(2h)^j
+                Vector tr = Subtract(Multiply(vw1r, vbr), Multiply(vw1i, vbi));
+                Vector ti = Add(Multiply(vw1r, vbi), Multiply(vw1i, vbr));
+                Vector a1r = Add(var, tr), a1i = Add(vai, ti);
+                Vector b1r = Subtract(var, tr), b1i = Subtract(vai, ti);
+                tr = Subtract(Multiply(vw1r, vdr), Multiply(vw1i, vdi));
+                ti = Add(Multiply(vw1r, vdi), Multiply(vw1i, vdr));
+                Vector c1r = Add(vcr, tr), c1i = Add(vci, ti);
+                Vector d1r = Subtract(vcr, tr), d1i = Subtract(vci, ti);
+
+                // second stage: (a, c) twiddled by W(4h)^j, (b, d) by W(4h)^(j+h) = -i * W(4h)^j
+                tr = Subtract(Multiply(vw2r, c1r), Multiply(vw2i, c1i));
+                ti = Add(Multiply(vw2r, c1i), Multiply(vw2i, c1r));
+                StoreUnaligned(ar + j, Add(a1r, tr));
+                StoreUnaligned(ai + j, Add(a1i, ti));
+                StoreUnaligned(cr + j, Subtract(a1r, tr));
+                StoreUnaligned(ci + j, Subtract(a1i, ti));
+                tr = Subtract(Multiply(vw2r, d1r), Multiply(vw2i, d1i));
+                ti = Add(Multiply(vw2r, d1i), Multiply(vw2i, d1r));
+                // multiplying (tr, ti) by -i gives (ti, -tr)
+                StoreUnaligned(br + j, Add(b1r, ti));
+                StoreUnaligned(bi + j, Subtract(b1i, tr));
+                StoreUnaligned(dr + j, Subtract(b1r, ti));
+                StoreUnaligned(di + j, Add(b1i, tr));
+            }
+        }
+
+        for (; j < h; j++)
+        {
+            float tr = w1r[j] * br[j] - w1i[j] * bi[j];
+            float ti = w1r[j] * bi[j] + w1i[j] * br[j];
+            float a1r = ar[j] + tr, a1i = ai[j] + ti;
+            float b1r = ar[j] - tr, b1i = ai[j] - ti;
+            tr = w1r[j] * dr[j] - w1i[j] * di[j];
+            ti = w1r[j] * di[j] + w1i[j] * dr[j];
+            float c1r = cr[j] + tr, c1i = ci[j] + ti;
+            float d1r = cr[j] - tr, d1i = ci[j] - ti;
+
+            tr = w2r[j] * c1r - w2i[j] * c1i;
+            ti = w2r[j] * c1i + w2i[j] * c1r;
+            ar[j] = a1r + tr;
+            ai[j] = a1i + ti;
+            cr[j] = a1r - tr;
+            ci[j] = a1i - ti;
+            tr = w2r[j] * d1r - w2i[j] * d1i;
+            ti = w2r[j] * d1i + w2i[j] * d1r;
+            br[j] = b1r + ti;
+            bi[j] = b1i - tr;
+            dr[j] = b1r - ti;
+            di[j] = b1i + tr;
+        }
+    }
+
+    return twiddleOffset + 4 * h;
+}
+
+void RealFftEngine::RadixTwoPass(int h, int twiddleOffset)
+{
+    const float* wr = _twiddles.data() + twiddleOffset;
+    const float* wi = wr + h;
+
+    for (int block = 0; block < _halfSize; block += 2 * h)
+    {
+        float* ar = _real.data() + block;
+        float* ai = _imaginary.data() + block;
+        float* br = ar + h;
+        float* bi = ai + h;
+
+        int j = 0;
+        if (h >= VectorWidth)
+        {
+            for (; j < h; j += (int)VectorWidth)
+            {
+                Vector vwr = LoadUnaligned(wr + j), vwi = LoadUnaligned(wi + j);
+                Vector var = LoadUnaligned(ar + j), vai = LoadUnaligned(ai + j);
+                Vector vbr = LoadUnaligned(br + j), vbi = LoadUnaligned(bi + j);
+                Vector tr = Subtract(Multiply(vwr, vbr), Multiply(vwi, vbi));
+                Vector ti = Add(Multiply(vwr, vbi), Multiply(vwi, vbr));
+                StoreUnaligned(ar + j, Add(var, tr));
+                StoreUnaligned(ai + j, Add(vai, ti));
+                StoreUnaligned(br + j, Subtract(var, tr));
+                StoreUnaligned(bi + j, Subtract(vai, ti));
+            }
+        }
+
+        for (; j < h; j++)
+        {
+            float tr = wr[j] * br[j] - wi[j] * bi[j];
+            float ti = wr[j] * bi[j] + wi[j] * br[j];
+            br[j] = ar[j] - tr;
+            bi[j] = ai[j] - ti;
+            ar[j] += tr;
+            ai[j] += ti;
+        }
+    }
+}
+
+void RealFftEngine::Transform(const float* input, float* real, float* imaginary)
+{
+    // Load even samples as real parts and odd samples as imaginary parts, in bit-reversed order.
+    int h = 1;
+    int twiddleOffset = 0;
+    if (_halfSize >= 4)
+    {
+        // The first radix-4 pass has only trivial twiddles (1 and -i), so do it as we load, without multiplying.
+        for (int m = 0; m < _halfSize; m += 4)
+        {
+            const float* a = input + _bitReversal[m] * 2;
+            const float* b = input + _bitReversal[m + 1] * 2;
+            const float* c = input + _bitReversal[m + 2] * 2;
+            const float* d = input + _bitReversal[m + 3] * 2;
+            float a1r = a[0] + b[0], a1i = a[1] + b[1];
+            float b1r = a[0] - b[0], b1i = a[1] - b[1];
+            float c1r = c[0] + d[0], c1i = c[1] + d[1];
+            float d1r = c[0] - d[0], d1i = c[1] - d[1];
+            _real[m] = a1r + c1r;
+            _imaginary[m] = a1i + c1i;
+            _real[m + 1] = b1r + d1i;
+            _imaginary[m + 1] = b1i - d1r;
+            _real[m + 2] = a1r - c1r;
+            _imaginary[m + 2] = a1i - c1i;
+            _real[m + 3] = b1r - d1i;
+            _imaginary[m + 3] = b1i + d1r;
+        }
+        h = 4;
+        twiddleOffset = 4;
+    }
+    else
+    {
+        for (int m = 0; m < _halfSize; m++)
+        {
+            int source = _bitReversal[m] * 2;
+            _real[m] = input[source];
+            _imaginary[m] = input[source + 1];
+        }
+    }
+
+    // Run the remaining passes in the same order the constructor tabulated them.
+    while (h < _halfSize)
+    {
+        if (h * 2 < _halfSize)
+        {
+            twiddleOffset = RadixFourPass(h, twiddleOffset);
+            h *= 4;
+        }
+        else
+        {
+            RadixTwoPass(h, twiddleOffset);
+            h *= 2;
+        }
+    }
+
+    // Split the complex transform Z of the packed samples into the transform X of the real samples:
+    // X[k] = E[k] + W(N)^k * O[k], where E[k] = (Z[k] + conj(Z[M-k])) / 2 and O[k] = -i * (Z[k] - conj(Z[M-k])) / 2.
+    real[0] = _real[0] + _imaginary[0];
+    imaginary[0] = 0;
+    real[_halfSize] = _real[0] - _imaginary[0];
+    imaginary[_halfSize] = 0;
+    Vector half = Splat(0.5f);
+    int k = 1;
+    // vectorize across k, loading Z[M-k] a vector at a time in reverse; W(N)^k = cosine - i * sine
+    for (; k + VectorWidth <= _halfSize; k += (int)VectorWidth)
+    {
+        int mirror = _halfSize - k - (int)VectorWidth + 1;
+        Vector zr = LoadUnaligned(_real.data() + k);
+        Vector zi = LoadUnaligned(_imaginary.data() + k);
+        Vector mirrorReal = Reverse(LoadUnaligned(_real.data() + mirror));
+        Vector mirrorImaginary = Reverse(LoadUnaligned(_imaginary.data() + mirror));
+
+        Vector evenReal = Multiply(Add(zr, mirrorReal), half);
+        Vector evenImaginary = Multiply(Subtract(zi, mirrorImaginary), half);
+        Vector oddReal = Multiply(Add(zi, mirrorImaginary), half);
+        Vector oddImaginary = Multiply(Subtract(mirrorReal, zr), half);
+
+        Vector wr = LoadUnaligned(_splitCosines.data() + k);
+        Vector sine = LoadUnaligned(_splitSines.data() + k);
+        StoreUnaligned(real + k, Add(evenReal, Add(Multiply(wr, oddReal), Multiply(sine, oddImaginary))));
+        StoreUnaligned(imaginary + k, Subtract(Add(evenImaginary, Multiply(wr, oddImaginary)), Multiply(sine, oddReal)));
+    }
+    for (; k < _halfSize; k++)
+    {
+        float zr = _real[k];
+        float zi = _imaginary[k];
+        float cr = _real[_halfSize - k];
+        float ci = -_imaginary[_halfSize - k];
+
+        float evenReal = (zr + cr) * 0.5f;
+        float evenImaginary = (zi + ci) * 0.5f;
+        float oddReal = (zi - ci) * 0.5f;
+        float oddImaginary = (cr - zr) * 0.5f;
+
+        // W(N)^k = cos - i sin
+        float wr = _splitCosines[k];
+        float wi = -_splitSines[k];
+        real[k] = evenReal + wr * oddReal - wi * oddImaginary;
+        imaginary[k] = evenImaginary + wr * oddImaginary + wi * oddReal;
+    }
+}
+
+ReferenceFftEngine::ReferenceFftEngine(int size)
+    : _size{ size },
+    _data(size)
+{
+    Check(size >= 4);
+    Check((size & (size - 1)) == 0);
+}
+
+void ReferenceFftEngine::Transform(const float* input, float* real, float* imaginary)
+{
+    for (int i = 0; i < _size; i++)
+    {
+        _data[i] = RosettaFFT::Complex(input[i], 0);
+    }
+
+    RosettaFFT::optimized_fft(_data);
+
+    for (int k = 0; k <= _size / 2; k++)
+    {
+        real[k] = (float)_data[k].real();
+        imaginary[k] = (float)_data[k].imag();
+    }
+}
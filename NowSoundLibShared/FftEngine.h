@@ -0,0 +1,96 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <vector>
+
+#include "rosetta_fft.h"
+
+namespace NowSound
+{
+    // Computes the discrete Fourier transform of fixed-size blocks of real (not complex) audio.
+    //
+    // An engine is planned for one transform size at construction, and may keep scratch state, so each
+    // thread that transforms needs its own engine.
+    class FftEngine
+    {
+    public:
+        virtual ~FftEngine() {}
+
+        // The number of real input samples per transform.
+        virtual int Size() const = 0;
+
+        // Transform Size() real samples into the Size() / 2 + 1 non-redundant complex bins (DC through Nyquist),
+        // stored as separate real and imaginary arrays.  The remaining bins are the complex conjugates of these.
+        virtual void Transform(const float* input, float* real, float* imaginary) = 0;
+    };
+
+    // The fast engine: a single-precision real-input FFT.
+    //
+    // A real transform of size N is done as a complex transform of size N/2 (packing even samples into the real
+    // parts and odd samples into the imaginary parts), followed by an O(N) pass to split the result back apart.
+    // The complex transform is an iterative decimation-in-time FFT over separate real and imaginary arrays, with
+    // its radix-2 stages fused in pairs into radix-4 passes so the data is swept half as many times.  The
+    // bit-reversal permutation and every stage's twiddles are tabulated once, at construction, and the wider
+    // passes use AudioKernels vectors (AVX or SSE2, whichever we are compiled for).
+    class RealFftEngine : public FftEngine
+    {
+    private:
+        // The real transform size; a power of two, at least 4.
+        const int _size;
+
+        // The complex transform size, _size / 2.
+        const int _halfSize;
+
+        // For each complex input index, the bit-reversed index of the complex value it is loaded from.
+        std::vector<int> _bitReversal;
+
+        // The twiddle tables for every pass, concatenated in pass order.
+        // A radix-4 pass with base half-size h holds W(2h)^j then W(4h)^j, as real and imaginary arrays, for j < h.
+        // A trailing radix-2 pass (if the number of stages is odd) holds W(2h)^j.
+        std::vector<float> _twiddles;
+
+        // cos and sin of 2 * pi * k / _size, for k < _halfSize, used when splitting the complex result.
+        std::vector<float> _splitCosines;
+        std::vector<float> _splitSines;
+
+        // The complex working arrays, each _halfSize long.
+        std::vector<float> _real;
+        std::vector<float> _imaginary;
+
+        // Two radix-2 stages, of half-size h and 2h, in one pass.  Returns the next pass's twiddle offset.
+        int RadixFourPass(int h, int twiddleOffset);
+
+        // One radix-2 stage of half-size h.
+        void RadixTwoPass(int h, int twiddleOffset);
+
+    public:
+        RealFftEngine(int size);
+
+        virtual int Size() const override { return _size; }
+
+        virtual void Transform(const float* input, float* real, float* imaginary) override;
+    };
+
+    // The slow engine: RosettaFFT::optimized_fft run as a full complex transform in double precision.
+    // Kept as the accuracy reference for RealFftEngine.
+    class ReferenceFftEngine : public FftEngine
+    {
+    private:
+        // The transform size.
+        const int _size;
+
+        // The complex working array.
+        RosettaFFT::CArray _data;
+
+    public:
+        ReferenceFftEngine(int size);
+
+        virtual int Size() const override { return _size; }
+
+        virtual void Transform(const float* input, float* real, float* imaginary) override;
+    };
+}
@@ -12,11 +12,11 @@ Histogram::Histogram(int capacity)
     : _capacity{ capacity },
     _size{ 0 },
     _index{ 0 },
-    _min{ 0 },
-    _max{ 0 },
-    _total{ 0 },
-    _minMaxKnown{ false },
-    _values{ new float[capacity] }
+    _total{},
+    _average{ 0 },
+    _values{ new float[capacity] },
+    _minQueue{ capacity },
+    _maxQueue{ capacity }
 {
     Check(capacity > 0);
 }
@@ -36,76 +36,167 @@ void Histogram::AddAll(const float* data, int count, bool absoluteValue)
 
 void Histogram::AddImpl(float value)
 {
-    if (_size == 0)
+    if (_size == _capacity)
     {
-        _values.get()[0] = value;
-        _size = _index = 1;
-        _min = _max = _total = value;
-        _minMaxKnown = true;
+        // evict the oldest value, which is the one about to be overwritten
+        _total.Subtract(_values[_index]);
+        if (_minQueue.Front() == _index)
+        {
+            _minQueue.PopFront();
+        }
+        if (_maxQueue.Front() == _index)
+        {
+            _maxQueue.PopFront();
+        }
     }
     else
     {
-        bool atCapacity = _size == _capacity;
+        _size++;
+    }
 
-        if (atCapacity)
-        {
-            _index = _index % _size;
+    _values[_index] = value;
+    _total.Add(value);
 
-            float oldValue = _values.get()[_index];
-            _total -= oldValue;
+    // Anything no smaller than the new value can never be the minimum again; likewise for the maximum.
+    while (!_minQueue.IsEmpty() && _values[_minQueue.Back()] >= value)
+    {
+        _minQueue.PopBack();
+    }
+    _minQueue.PushBack(_index);
+    while (!_maxQueue.IsEmpty() && _values[_maxQueue.Back()] <= value)
+    {
+        _maxQueue.PopBack();
+    }
+    _maxQueue.PushBack(_index);
 
-            _minMaxKnown = _minMaxKnown && (oldValue > _min && oldValue < _max);
-        }
-        else
-        {
-            _size++;
-        }
+    _index++;
+    if (_index == _capacity)
+    {
+        _index = 0;
+    }
 
-        _values.get()[_index] = value;
-        _total += value;
-        // Update _min or _max if applicable.  Note that this doesn't change _minMaxKnown.
-        if (value < _min)
-        {
-            _min = value;
-        }
-        else if (value > _max)
-        {
-            _max = value;
-        }
+    _average = (float)(_total.Value() / _size);
+}
 
-        _index++;
+float Histogram::Min()
+{
+    return _size == 0 ? 0 : _values[_minQueue.Front()];
+}
+
+float Histogram::Max()
+{
+    return _size == 0 ? 0 : _values[_maxQueue.Front()];
+}
+
+float Histogram::Average()
+{
+    return _average;
+}
+
+BlockHistogram::BlockHistogram(int sampleCapacity, int blockCapacity)
+    : _sampleCapacity{ sampleCapacity },
+    _blockCapacity{ blockCapacity },
+    _blockMins{ new float[blockCapacity] },
+    _blockMaxes{ new float[blockCapacity] },
+    _blockSums{ new double[blockCapacity] },
+    _blockSampleCounts{ new int[blockCapacity] },
+    _oldest{ 0 },
+    _blockCount{ 0 },
+    _sampleCount{ 0 },
+    _total{},
+    _minQueue{ blockCapacity },
+    _maxQueue{ blockCapacity }
+{
+    Check(sampleCapacity > 0);
+    Check(blockCapacity > 0);
+}
+
+void BlockHistogram::AddBlock(const float* data, int count, bool absoluteValue)
+{
+    if (count > 0)
+    {
+        AddSummary(AudioKernels::Summarize(data, count, absoluteValue), count);
     }
+}
 
-    _average = _total / _size;
+void BlockHistogram::AddStereoMagnitudeBlock(const float* left, const float* right, int count)
+{
+    if (count > 0)
+    {
+        AddSummary(AudioKernels::SummarizeStereoMagnitude(left, right, count), count);
+    }
 }
 
-void Histogram::EnsureMinMaxKnown()
+void BlockHistogram::EvictOldest()
 {
-    if (!_minMaxKnown && _size > 0)
+    Check(_blockCount > 0);
+
+    _total.Subtract(_blockSums[_oldest]);
+    _sampleCount -= _blockSampleCounts[_oldest];
+    if (_minQueue.Front() == _oldest)
     {
-        _min = _max = _values.get()[0];
-        for (int i = 1; i < _size; i++)
-        {
-            _min = std::min<float>(_min, _values.get()[i]);
-            _max = std::max<float>(_max, _values.get()[i]);
-        }
-        _minMaxKnown = true;
+        _minQueue.PopFront();
+    }
+    if (_maxQueue.Front() == _oldest)
+    {
+        _maxQueue.PopFront();
+    }
+
+    _blockCount--;
+    _oldest++;
+    if (_oldest == _blockCapacity)
+    {
+        _oldest = 0;
     }
 }
 
-float Histogram::Min()
+void BlockHistogram::AddSummary(const AudioKernels::BlockSummary& summary, int count)
+{
+    Check(count > 0);
+
+    if (_blockCount == _blockCapacity)
+    {
+        EvictOldest();
+    }
+
+    int position = (_oldest + _blockCount) % _blockCapacity;
+    _blockMins[position] = summary.Min;
+    _blockMaxes[position] = summary.Max;
+    _blockSums[position] = summary.Sum;
+    _blockSampleCounts[position] = count;
+    _blockCount++;
+    _sampleCount += count;
+    _total.Add(summary.Sum);
+
+    while (!_minQueue.IsEmpty() && _blockMins[_minQueue.Back()] >= summary.Min)
+    {
+        _minQueue.PopBack();
+    }
+    _minQueue.PushBack(position);
+    while (!_maxQueue.IsEmpty() && _blockMaxes[_maxQueue.Back()] <= summary.Max)
+    {
+        _maxQueue.PopBack();
+    }
+    _maxQueue.PushBack(position);
+
+    // keep within the sample capacity, but always keep the newest block
+    while (_sampleCount > _sampleCapacity && _blockCount > 1)
+    {
+        EvictOldest();
+    }
+}
+
+float BlockHistogram::Min()
 {
-    EnsureMinMaxKnown();
-    return _min;
+    return _blockCount == 0 ? 0 : _blockMins[_minQueue.Front()];
 }
 
-float Histogram::Max()
+float BlockHistogram::Max()
 {
-    EnsureMinMaxKnown();
-    return _max;
+    return _blockCount == 0 ? 0 : _blockMaxes[_maxQueue.Front()];
 }
 
-float Histogram::Average()
+float BlockHistogram::Average()
 {
-    return _average;
+    return _blockCount == 0 ? 0 : (float)(_total.Value() / _sampleCount);
 }
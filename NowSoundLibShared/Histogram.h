@@ -5,13 +5,74 @@
 
 #include "stdint.h"
 
-#include <deque>
+#include <cmath>
+#include <memory>
+
+#include "AudioKernels.h"
 
-// Simple histogram structure for tracking statistics over a bounded set of float values.
-// Average() is always available with O(1) performance.  Max() and Min() are calculated lazily on demand.
-// THIS TYPE IS NOT THREAD SAFE, BY DESIGN. Owners are responsible for synchronization.
 namespace NowSound
 {
+    // A fixed-capacity double-ended queue of positions in a ring of values, used by the histograms to track
+    // sliding-window min and max.  The values at the positions in each queue are kept monotonic (increasing for
+    // a min queue, decreasing for a max queue), so the front of each queue is the current extreme; each value
+    // enters and leaves each queue at most once.
+    class PositionQueue
+    {
+    private:
+        std::unique_ptr<int[]> _positions;
+        int _capacity;
+        int _head;
+        int _count;
+
+    public:
+        PositionQueue(int capacity) : _positions{ new int[capacity] }, _capacity{ capacity }, _head{ 0 }, _count{ 0 }
+        { }
+
+        bool IsEmpty() const { return _count == 0; }
+        int Front() const { return _positions[_head]; }
+        int Back() const { return _positions[(_head + _count - 1) % _capacity]; }
+        void PopFront() { _head = (_head + 1) % _capacity; _count--; }
+        void PopBack() { _count--; }
+        void PushBack(int position) { _positions[(_head + _count) % _capacity] = position; _count++; }
+    };
+
+    // A running total of doubles which values are added to and subtracted from forever, compensated (Neumaier's
+    // variant of Kahan summation) so that rounding error does not accumulate: the error stays bounded by a few
+    // ulps of the largest running total, no matter how many values have come and gone.  O(1) per value.
+    class CompensatedSum
+    {
+    private:
+        double _sum;
+
+        // The low-order bits lost from _sum so far.
+        double _compensation;
+
+    public:
+        CompensatedSum() : _sum{ 0 }, _compensation{ 0 }
+        { }
+
+        void Add(double value)
+        {
+            double sum = _sum + value;
+            if (std::abs(_sum) >= std::abs(value))
+            {
+                _compensation += (_sum - sum) + value;
+            }
+            else
+            {
+                _compensation += (value - sum) + _sum;
+            }
+            _sum = sum;
+        }
+
+        void Subtract(double value) { Add(-value); }
+
+        double Value() const { return _sum + _compensation; }
+    };
+
+    // Simple histogram structure for tracking statistics over a bounded set of float values.
+    // Average(), Min() and Max() are all available with O(1) performance, and so is Add().
+    // THIS TYPE IS NOT THREAD SAFE, BY DESIGN. Owners are responsible for synchronization.
     class Histogram
     {
     private:
@@ -24,24 +85,21 @@ namespace NowSound
         // The index at which to insert the next element.
         int _index;
 
-        // The possibly stale values of _min and _max (if !_minMaxKnown).
-        float _min;
-        float _max;
-
-        // The always accurate total of all values.
-        float _total;
+        // The total of all values, compensated so that rounding error cannot accumulate over hours of adding and
+        // removing values.
+        CompensatedSum _total;
 
         // The always accurate average of all values.
         float _average;
 
-        // If _max and _min are known to be accurate with respect to _valuesInInsertionOrder, then this is true.
-        bool _minMaxKnown;
+        // The values, in a ring; the oldest is at _index once _size reaches _capacity.
+        std::unique_ptr<float[]> _values;
 
-        // This deque simply tracks the values in the order they entered the histogram.
-        std::unique_ptr<float> _values;
+        // Positions of the values that are the minimum of some suffix of the window, oldest first.
+        PositionQueue _minQueue;
 
-        // Recalculate min/max if necessary.
-        void EnsureMinMaxKnown();
+        // Positions of the values that are the maximum of some suffix of the window, oldest first.
+        PositionQueue _maxQueue;
 
         // Add implementation (no locking).
         void AddImpl(float value);
@@ -64,4 +122,71 @@ namespace NowSound
         // Add new values to this histogram.
         void AddAll(const float* data, int count, bool absoluteValue);
     };
+
+    // Like Histogram, but for metering audio a block at a time: each block added is reduced (with vector kernels)
+    // to its min, max and sum, and only those block summaries are kept in the window.  So adding costs a little
+    // more than one pass over the block, and nothing per sample.
+    //
+    // The window holds the most recent blocks totalling at most sampleCapacity samples (but always at least the
+    // latest block).  When all blocks are the same size and that size divides sampleCapacity, Min() and Max() are
+    // exactly those of a Histogram of sampleCapacity fed the same samples one at a time, and Average() is too, up
+    // to float rounding in the block sums.
+    // THIS TYPE IS NOT THREAD SAFE, BY DESIGN. Owners are responsible for synchronization.
+    class BlockHistogram
+    {
+    private:
+        // The maximum number of samples the window covers.
+        int _sampleCapacity;
+
+        // The maximum number of block summaries; if blocks are small enough to exceed this, the window shrinks.
+        int _blockCapacity;
+
+        // The per-block summaries, in a ring.
+        std::unique_ptr<float[]> _blockMins;
+        std::unique_ptr<float[]> _blockMaxes;
+        std::unique_ptr<double[]> _blockSums;
+        std::unique_ptr<int[]> _blockSampleCounts;
+
+        // Ring position of the oldest block in the window.
+        int _oldest;
+
+        // The number of blocks in the window.
+        int _blockCount;
+
+        // The number of samples in the window.
+        int _sampleCount;
+
+        // The total of all samples in the window, compensated to prevent drift.
+        CompensatedSum _total;
+
+        // Positions of the blocks whose min is the minimum of some suffix of the window, oldest first.
+        PositionQueue _minQueue;
+
+        // Positions of the blocks whose max is the maximum of some suffix of the window, oldest first.
+        PositionQueue _maxQueue;
+
+        // Drop the oldest block from the window.
+        void EvictOldest();
+
+    public:
+        BlockHistogram(int sampleCapacity, int blockCapacity);
+
+        // The minimum value in the window.
+        float Min();
+
+        // The maximum value in the window.
+        float Max();
+
+        // The average value in the window.
+        float Average();
+
+        // Add a block of count values (or of their absolute values).
+        void AddBlock(const float* data, int count, bool absoluteValue);
+
+        // Add a block of count stereo samples, as the per-sample magnitudes |left| / 2 + |right| / 2.
+        void AddStereoMagnitudeBlock(const float* left, const float* right, int count);
+
+        // Add an already-computed summary of a block of count values.
+        void AddSummary(const AudioKernels::BlockSummary& summary, int count);
+    };
 }
@@ -4,88 +4,105 @@
 // Licensed under the MIT license
 
 #include "stdafx.h"
+
+#include <algorithm>
+#include <variant>
+
 #include "NowSoundTime.h"
 
 namespace NowSound
 {
-    // Class which provides an interface to the Stream functions that mappers need.
+    // The parts of a stream that mappers need, captured by value.
+    //
+    // Mapping happens for every slice played, so mappers get this snapshot rather than calling back into the stream.
     template<typename TTime>
-    class IStream
+    class StreamExtent
     {
+    private:
+        Time<TTime> _initialTime;
+        Duration<TTime> _discreteDuration;
+        RationalDuration<TTime> _exactDuration;
+        bool _isShut;
+
     public:
+        StreamExtent(Time<TTime> initialTime, Duration<TTime> discreteDuration, RationalDuration<TTime> exactDuration, bool isShut)
+            : _initialTime{ initialTime }, _discreteDuration{ discreteDuration }, _exactDuration{ exactDuration }, _isShut{ isShut }
+        { }
+
         // Time at which this stream began.
-        virtual Time<TTime> InitialTime() const = 0;
+        Time<TTime> InitialTime() const { return _initialTime; }
         // Discrete duration of stream.
-        virtual Duration<TTime> DiscreteDuration() const = 0;
-        // Continuous duration of stream; cannot be called until IsShut().
-        virtual ContinuousDuration<TTime> ExactDuration() const = 0;
+        Duration<TTime> DiscreteDuration() const { return _discreteDuration; }
+        // Exact duration of stream; only meaningful if IsShut().
+        RationalDuration<TTime> ExactRationalDuration() const { return _exactDuration; }
         // Interval of stream.
         Interval<TTime> DiscreteInterval() const { return Interval<TTime>(InitialTime(), DiscreteDuration()); }
         // Is the stream shut (that is, no longer accepting appends, and has begun looping)?
-        virtual bool IsShut() const = 0;
+        bool IsShut() const { return _isShut; }
     };
 
-    // Handle converting time intervals from absolute time (relative to start of app) to relative time
+    // Mappers handle converting time intervals from absolute time (relative to start of app) to relative time
     // (relative to start of loop).
     //
     // IntervalMappers are fundamentally how looping is implemented, by mapping current time modulo the
     // loop duration.  They are also able to handle delaying, by mapping current time backwards within a rolling
     // stream.
-    template<typename TTime>
-    class IntervalMapper
-    {
-        // Map an input Interval into a subset Interval.
-        //
-        // This may return an Interval of shorter duration than the input; this is typically because
-        // the input interval wrapped around some underlying structure.  In this case, the function
-        // should be called again, with input.SubsliceStartingAt(returnedSubInterval.Duration) --
-        // in other words, slice off the portion that was mapped, and request the next portion.
-        // 
-        // The returned interval will have an initial time that is within the bounds of the stream
-        // it is mapping to.
-        // </remarks>
-    public:
-        virtual Interval<TTime> MapNextSubInterval(const IStream<TTime>* stream, Interval<TTime> input) const = 0;
-    };
+    //
+    // Each mapper has a method:
+    //
+    //     Interval<TTime> MapNextSubInterval(const StreamExtent<TTime>& stream, Interval<TTime> input) const;
+    //
+    // which maps an input Interval into a subset Interval.
+    //
+    // This may return an Interval of shorter duration than the input; this is typically because
+    // the input interval wrapped around some underlying structure.  In this case, the function
+    // should be called again, with input.SubsliceStartingAt(returnedSubInterval.Duration) --
+    // in other words, slice off the portion that was mapped, and request the next portion.
+    // 
+    // The returned interval will have an initial time that is within the bounds of the stream
+    // it is mapping to.
+    //
+    // The mappers are plain classes, gathered into the IntervalMapper variant below, rather than implementations
+    // of a virtual interface; so choosing the mapper is a predictable branch rather than an indirect call.
 
     // Identity mapping.
     template<typename TTime>
-    class IdentityIntervalMapper : public IntervalMapper<TTime>
+    class IdentityIntervalMapper
     {
     public:
         IdentityIntervalMapper()
         {
         }
 
-        virtual Interval<TTime> MapNextSubInterval(const IStream<TTime>* stream, Interval<TTime> input) const
+        Interval<TTime> MapNextSubInterval(const StreamExtent<TTime>& stream, Interval<TTime> input) const
         {
-            return input.Intersect(stream->DiscreteInterval());
+            return input.Intersect(stream.DiscreteInterval());
         }
     };
 
     // Simple mapper that maps all later times back into the duration of the loop, without taking fractional samples into account.
     template<typename TTime>
-    class SimpleLoopingIntervalMapper : public IntervalMapper<TTime>
+    class SimpleLoopingIntervalMapper
     {
     public:
         SimpleLoopingIntervalMapper()
         {
         }
 
-        virtual Interval<TTime> MapNextSubInterval(const IStream<TTime>* stream, Interval<TTime> input) const
+        Interval<TTime> MapNextSubInterval(const StreamExtent<TTime>& stream, Interval<TTime> input) const
         {
-            Check(input.InitialTime() >= stream->InitialTime());
+            Check(input.InitialTime() >= stream.InitialTime());
             // Should only use this mapper on shut streams with a fixed ContinuousDuration.
-            Check(stream->IsShut());
+            Check(stream.IsShut());
 
-            Duration<TTime> inputDelayDuration = input.InitialTime() - stream->InitialTime();
+            Duration<TTime> inputDelayDuration = input.InitialTime() - stream.InitialTime();
             // now we want to take that modulo the *discrete* duration
-            inputDelayDuration = inputDelayDuration.Value() % stream->DiscreteDuration().Value();
+            inputDelayDuration = inputDelayDuration.Value() % stream.DiscreteDuration().Value();
 #undef min // whose bright idea was it to put a min macro in the Windows SDK???
             Duration<TTime> mappedDuration = std::min(
                 input.IntervalDuration().Value(),
-                (stream->DiscreteDuration() - inputDelayDuration).Value());
-            Interval<TTime> ret(stream->InitialTime() + inputDelayDuration, mappedDuration);
+                (stream.DiscreteDuration() - inputDelayDuration).Value());
+            Interval<TTime> ret(stream.InitialTime() + inputDelayDuration, mappedDuration);
 
             // Spam.Audio.WriteLine("SimpleLoopingIntervalMapper.MapNextSubInterval: stream " + stream + ", input " + input + ", ret " + ret);
 
@@ -97,16 +114,16 @@ namespace NowSound
     // for arbitrary durations.  (This may not matter as much as I think but it was a nice problem to get precise about...
     // without this, a one second loop at 48Khz would drift by 1/10 second after 160 minutes, which just seems wrong in principle.)
     template<typename TTime>
-    class ExactLoopingIntervalMapper : public IntervalMapper<TTime>
+    class ExactLoopingIntervalMapper
     {
     public:
         ExactLoopingIntervalMapper()
         {
         }
 
-        virtual Interval<TTime> MapNextSubInterval(const IStream<TTime>* stream, Interval<TTime> input) const
+        Interval<TTime> MapNextSubInterval(const StreamExtent<TTime>& stream, Interval<TTime> input) const
         {
-            Check(stream->IsShut());
+            Check(stream.IsShut());
 
             // for example reference
             /*
@@ -140,22 +157,57 @@ namespace NowSound
             */
 
             // First thing we do is, subtract our initial time from the initial time of the input.
-            Duration<TTime> loopRelativeInitialTime = input.InitialTime() - stream->InitialTime();
-            float exactDuration = stream->ExactDuration().Value();
+            Duration<TTime> loopRelativeInitialTime = input.InitialTime() - stream.InitialTime();
+            RationalDuration<TTime> exactDuration = stream.ExactRationalDuration();
 
             // Now, we need to figure out how many multiples of the stream's CONTINUOUS length this is.
             // In other words, we want adjustedInitialTime modulo the real-valued length of this stream.
             // This is critical to avoid iterated roundoff error with streams that are a multiple of a
-            // fractional duration in length.
-            float loopMult = loopRelativeInitialTime.Value() / exactDuration;
-            int loopIndex = (int)loopMult;
-
-            Duration<TTime> adjustedLoopRelativeInitialTime =
-                (int)(loopRelativeInitialTime.Value() - (loopIndex * exactDuration));
+            // fractional duration in length.  It is done in exact integer arithmetic, since floating point
+            // loses sample accuracy here after a few minutes.
+            // loopRemainder / Denominator is how far (in fractional samples) we are into loop number loopIndex.
+            int64_t loopIndex;
+            int64_t loopRemainder;
+            exactDuration.Divide(loopRelativeInitialTime.Value(), loopIndex, loopRemainder);
+
+            // floor of the offset into the loop
+            Duration<TTime> adjustedLoopRelativeInitialTime = loopRemainder / exactDuration.Denominator();
+
+            // ceiling of the time remaining in the loop
+            int64_t remainingInLoop = exactDuration.Numerator() - loopRemainder;
+            int64_t duration = (remainingInLoop + exactDuration.Denominator() - 1) / exactDuration.Denominator();
+            duration = std::min(duration, input.IntervalDuration().Value());
+
+            return Interval<TTime>(stream.InitialTime() + adjustedLoopRelativeInitialTime, duration);
+        }
+    };
 
-            int duration = (int)std::ceil((loopIndex + 1) * exactDuration - loopRelativeInitialTime.Value());
+    // Any of the mappers.
+    template<typename TTime>
+    using IntervalMapper = std::variant<
+        IdentityIntervalMapper<TTime>,
+        SimpleLoopingIntervalMapper<TTime>,
+        ExactLoopingIntervalMapper<TTime>>;
 
-            return Interval<TTime>(stream->InitialTime() + adjustedLoopRelativeInitialTime, duration);
+    // Map with whichever mapper this is.
+    template<typename TTime>
+    inline Interval<TTime> MapNextSubInterval(
+        const IntervalMapper<TTime>& mapper,
+        const StreamExtent<TTime>& stream,
+        Interval<TTime> input)
+    {
+        // Test the alternatives directly, rather than std::visit-ing, to guarantee plain branches.
+        if (const ExactLoopingIntervalMapper<TTime>* exact = std::get_if<ExactLoopingIntervalMapper<TTime>>(&mapper))
+        {
+            return exact->MapNextSubInterval(stream, input);
         }
-    };
+        else if (const SimpleLoopingIntervalMapper<TTime>* simple = std::get_if<SimpleLoopingIntervalMapper<TTime>>(&mapper))
+        {
+            return simple->MapNextSubInterval(stream, input);
+        }
+        else
+        {
+            return std::get<IdentityIntervalMapper<TTime>>(mapper).MapNextSubInterval(stream, input);
+        }
+    }
 }
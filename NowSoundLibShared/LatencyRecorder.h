@@ -0,0 +1,83 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // Every duration from a benchmark run, kept exactly so that percentiles are exact.
+    //
+    // Storage is allocated up front and recording never allocates, so recording does not disturb what is being
+    // measured; durations past the capacity are dropped.  Summarizing sorts a copy, so do it after the run.
+    class LatencyRecorder
+    {
+    private:
+        // The recorded durations, in microseconds.
+        std::vector<double> _microseconds;
+
+        // The number of durations the storage can hold.
+        const int _capacity;
+
+    public:
+        LatencyRecorder(int capacity) : _microseconds{}, _capacity{ capacity }
+        {
+            Check(capacity > 0);
+            _microseconds.reserve(capacity);
+        }
+
+        // The number of durations recorded.
+        int Count() const { return (int)_microseconds.size(); }
+
+        // Forget all recorded durations.
+        void Clear() { _microseconds.clear(); }
+
+        // Record a duration, unless full.
+        void Record(double microseconds)
+        {
+            if ((int)_microseconds.size() < _capacity)
+            {
+                _microseconds.push_back(microseconds);
+            }
+        }
+
+        // The given percentile (from 0 to 100) of the recorded durations, by the nearest-rank method; 0 if none.
+        double Percentile(double percentile) const
+        {
+            Check(percentile >= 0 && percentile <= 100);
+            if (_microseconds.empty())
+            {
+                return 0;
+            }
+
+            std::vector<double> sorted{ _microseconds };
+            std::sort(sorted.begin(), sorted.end());
+            int rank = (int)std::ceil(percentile / 100 * sorted.size());
+            return sorted[rank == 0 ? 0 : rank - 1];
+        }
+
+        // The longest recorded duration; 0 if none.
+        double Max() const
+        {
+            return _microseconds.empty() ? 0 : *std::max_element(_microseconds.begin(), _microseconds.end());
+        }
+
+        // The mean recorded duration; 0 if none.
+        double Mean() const
+        {
+            double sum = 0;
+            for (double value : _microseconds)
+            {
+                sum += value;
+            }
+            return _microseconds.empty() ? 0 : sum / _microseconds.size();
+        }
+    };
+}
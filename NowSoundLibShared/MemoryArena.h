@@ -0,0 +1,173 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // One large region of memory, reserved up front, intended to hold audio buffers for the life of the process.
+    //
+    // The region is backed by huge pages where the OS will give them to us, which keeps TLB pressure down once
+    // many minutes of loops are in memory.  Either way, every page of the region is touched on construction and
+    // then locked into RAM, so that the audio thread never takes a page fault on first use of a buffer.
+    //
+    // Neither huge pages nor locking are guaranteed (both usually need extra privileges or raised limits);
+    // UsesHugePages() and IsLocked() report what we actually got.  Prefaulting always happens.
+    class MemoryArena
+    {
+    private:
+        // Base of the region.
+        uint8_t* _base;
+
+        // Size of the region in bytes; a multiple of the page size used.
+        size_t _size;
+
+        // Did we get huge pages?
+        bool _usesHugePages;
+
+        // Is the region locked into RAM?
+        bool _isLocked;
+
+        static size_t RoundUp(size_t value, size_t multiple)
+        {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        // Size of a normal page.
+        static size_t PageSize()
+        {
+#ifdef _WIN32
+            SYSTEM_INFO systemInfo;
+            GetSystemInfo(&systemInfo);
+            return systemInfo.dwPageSize;
+#else
+            return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+        }
+
+    public:
+        // The huge page size we ask for; 2MB on both x64 Windows and Linux.
+        static const size_t HugePageSize = 2 * 1024 * 1024;
+
+        // Reserve, prefault and (if possible) lock a region of at least the given size.
+        MemoryArena(size_t size)
+            : _base{ nullptr }, _size{ 0 }, _usesHugePages{ false }, _isLocked{ false }
+        {
+            Check(size > 0);
+
+#ifdef _WIN32
+            // Large pages are always locked on Windows, but require SeLockMemoryPrivilege.
+            size_t largePageMinimum = GetLargePageMinimum();
+            if (largePageMinimum > 0)
+            {
+                size_t hugeSize = RoundUp(size, largePageMinimum);
+                _base = (uint8_t*)VirtualAlloc(nullptr, hugeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                if (_base != nullptr)
+                {
+                    _size = hugeSize;
+                    _usesHugePages = true;
+                    _isLocked = true;
+                }
+            }
+
+            if (_base == nullptr)
+            {
+                _size = RoundUp(size, PageSize());
+                _base = (uint8_t*)VirtualAlloc(nullptr, _size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+                Check(_base != nullptr);
+            }
+#else
+            // Explicit huge pages only work if the administrator has reserved some (vm.nr_hugepages).
+            size_t hugeSize = RoundUp(size, HugePageSize);
+            void* mapped = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mapped != MAP_FAILED)
+            {
+                _base = (uint8_t*)mapped;
+                _size = hugeSize;
+                _usesHugePages = true;
+            }
+            else
+            {
+                // Otherwise ask for transparent huge pages, which the kernel may or may not grant.
+                // Aligning the size to the huge page size gives it the best chance.
+                _size = hugeSize;
+                mapped = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                Check(mapped != MAP_FAILED);
+                _base = (uint8_t*)mapped;
+#ifdef MADV_HUGEPAGE
+                madvise(_base, _size, MADV_HUGEPAGE);
+#endif
+            }
+#endif
+
+            // Touch every page now, so nobody pays for the faults later.
+            size_t pageSize = _usesHugePages ? HugePageSize : PageSize();
+            for (size_t offset = 0; offset < _size; offset += pageSize)
+            {
+                _base[offset] = 0;
+            }
+
+            if (!_isLocked)
+            {
+#ifdef _WIN32
+                _isLocked = VirtualLock(_base, _size) != 0;
+#else
+                _isLocked = mlock(_base, _size) == 0;
+#endif
+            }
+        }
+
+        // no copying this
+        MemoryArena(const MemoryArena&) = delete;
+
+        ~MemoryArena()
+        {
+#ifdef _WIN32
+            if (_isLocked && !_usesHugePages)
+            {
+                VirtualUnlock(_base, _size);
+            }
+            VirtualFree(_base, 0, MEM_RELEASE);
+#else
+            if (_isLocked)
+            {
+                munlock(_base, _size);
+            }
+            munmap(_base, _size);
+#endif
+        }
+
+        // Base of the region.
+        uint8_t* Base() const { return _base; }
+
+        // Size of the region in bytes; may be larger than requested.
+        size_t Size() const { return _size; }
+
+        // Is the region backed by (explicitly allocated) huge pages?
+        bool UsesHugePages() const { return _usesHugePages; }
+
+        // Is the region locked into RAM?
+        bool IsLocked() const { return _isLocked; }
+
+        // Is the given pointer within this region?
+        bool Contains(const void* pointer) const
+        {
+            const uint8_t* bytePointer = (const uint8_t*)pointer;
+            return bytePointer >= _base && bytePointer < _base + _size;
+        }
+    };
+}
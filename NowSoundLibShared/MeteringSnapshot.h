@@ -0,0 +1,111 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // A fixed number of floats, published by one writer thread and copied out by any number of reader threads.
+    //
+    // This is a seqlock: the writer bumps a sequence number to odd, writes the values, and bumps it back to even.
+    // Readers copy the values and retry if the sequence number was odd or changed underneath them.  So the writer
+    // never waits for anything -- which is the point, as the writer is the audio thread and the readers are UI
+    // polls -- and readers always get a consistent snapshot of a single Publish() call.  Each publication can carry
+    // an integer stamp (e.g. the sample time it describes), which is read consistently along with the values.
+    //
+    // The values are stored as relaxed atomics, so the racing copies are well-defined; on every platform we care
+    // about, these compile down to plain loads and stores.
+    class MeteringSnapshot
+    {
+    private:
+        // Number of floats in a snapshot.
+        const int _capacity;
+
+        // The published values.
+        std::unique_ptr<std::atomic<float>[]> _values;
+
+        // The stamp of the published values.
+        std::atomic<int64_t> _stamp;
+
+        // The sequence number; odd while a Publish() is in progress.
+        std::atomic<uint32_t> _sequence;
+
+    public:
+        MeteringSnapshot(int capacity)
+            : _capacity{ capacity },
+            _values{ new std::atomic<float>[capacity] },
+            _stamp{ 0 },
+            _sequence{ 0 }
+        {
+            Check(capacity > 0);
+            for (int i = 0; i < capacity; i++)
+            {
+                _values[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        MeteringSnapshot(const MeteringSnapshot&) = delete;
+        MeteringSnapshot& operator=(const MeteringSnapshot&) = delete;
+
+        // Number of floats in a snapshot.
+        int Capacity() const { return _capacity; }
+
+        // Publish new values, with the given stamp.  Only one thread may ever call this; it never blocks.
+        void Publish(const float* values, int count, int64_t stamp = 0)
+        {
+            Check(count == _capacity);
+
+            uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+            _sequence.store(sequence + 1, std::memory_order_relaxed);
+            // keep the value stores below from being seen before the odd sequence number
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (int i = 0; i < count; i++)
+            {
+                _values[i].store(values[i], std::memory_order_relaxed);
+            }
+            _stamp.store(stamp, std::memory_order_relaxed);
+
+            _sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        // Copy out the most recently published values, and return their stamp (0 if nothing was published yet).
+        // Safe from any thread; retries (without blocking the writer) if a Publish() overlaps the copy.
+        int64_t Read(float* values, int count) const
+        {
+            Check(count == _capacity);
+
+            while (true)
+            {
+                uint32_t before = _sequence.load(std::memory_order_acquire);
+                if ((before & 1) == 0)
+                {
+                    for (int i = 0; i < count; i++)
+                    {
+                        values[i] = _values[i].load(std::memory_order_relaxed);
+                    }
+                    int64_t stamp = _stamp.load(std::memory_order_relaxed);
+
+                    // keep the value loads above from being seen after the second sequence load
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (_sequence.load(std::memory_order_relaxed) == before)
+                    {
+                        return stamp;
+                    }
+                }
+
+                // a Publish() is in flight; let the writer finish
+                std::this_thread::yield();
+            }
+        }
+    };
+}
@@ -12,6 +12,8 @@
 #include "math.h"
 #include "stdint.h" // for int64_t
 
+#include <algorithm> // for std::min and std::max
+
 #include "Check.h"
 
 namespace NowSound
@@ -56,12 +58,12 @@ namespace NowSound
 
         static Time<TTime> Min(const Time<TTime>& first, const Time<TTime>& second)
         {
-            return Time<TTime>(__min(first.Value(), second.Value()));
+            return Time<TTime>(std::min(first.Value(), second.Value()));
         }
 
         static Time<TTime> Max(const Time<TTime>& first, const Time<TTime>& second)
         {
-            return Time<TTime>(__max(first.Value(), second.Value()));
+            return Time<TTime>(std::max(first.Value(), second.Value()));
         }
 
         Time<TTime>& operator=(const Time<TTime>& other)
@@ -99,8 +101,6 @@ namespace NowSound
         {
             return _value >= second.Value();
         }
-
-        double Seconds() const { return ((double)_value.Value()) / Clock::SampleRateHz; }
     };
 
     // A distance between two Times.
@@ -120,7 +120,7 @@ namespace NowSound
 
         static Duration<TTime> Min(Duration<TTime> first, Duration<TTime> second)
         {
-            return new Duration<TTime>(Math.Min(first, second));
+            return Duration<TTime>(std::min(first.Value(), second.Value()));
         }
 
         Duration<TTime>& operator=(const Duration<TTime>& other)
@@ -317,4 +317,168 @@ namespace NowSound
             return new ContinuousDuration<TTime>(value * _value);
         }
     };
+
+    // An exact, non-negative duration of Numerator() / Denominator() TTime units.
+    //
+    // Loop lengths are naturally rational -- a loop of B beats at M BPM is B * sampleRate * 60 / M samples --
+    // so keeping them as 64-bit ratios lets loop boundaries be computed exactly at any time, however far
+    // into a session.  A float loop length stops being sample-accurate once times pass 2^24 samples (about
+    // six minutes at 48Khz).
+    template<typename TTime>
+    class RationalDuration
+    {
+    private:
+        int64_t _numerator;
+        int64_t _denominator;
+
+        static int64_t Gcd(int64_t a, int64_t b)
+        {
+            while (b != 0)
+            {
+                int64_t t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+
+        void Reduce()
+        {
+            int64_t gcd = Gcd(_numerator, _denominator);
+            if (gcd > 1)
+            {
+                _numerator /= gcd;
+                _denominator /= gcd;
+            }
+        }
+
+    public:
+        RationalDuration(int64_t numerator, int64_t denominator) : _numerator(numerator), _denominator(denominator)
+        {
+            Check(numerator >= 0);
+            Check(denominator > 0);
+            Reduce();
+        }
+
+        // The exact value of the given float.  Every finite float is an integer times a power of two,
+        // so this loses nothing (except for the very smallest values, which keep only as much precision as fits).
+        RationalDuration(float value) : _numerator(0), _denominator(1)
+        {
+            Check(value >= 0);
+            int exponent;
+            double mantissa = frexp((double)value, &exponent);
+            // mantissa is in [0.5, 1) and has 24 significant bits
+            _numerator = (int64_t)ldexp(mantissa, 24);
+            exponent -= 24;
+            while (exponent < -62)
+            {
+                _numerator >>= 1;
+                exponent++;
+            }
+            if (exponent >= 0)
+            {
+                Check(exponent < 39); // the result must fit in 63 bits
+                _numerator <<= exponent;
+            }
+            else
+            {
+                _denominator = (int64_t)1 << -exponent;
+            }
+            Reduce();
+        }
+
+        RationalDuration(ContinuousDuration<TTime> value) : RationalDuration(value.Value())
+        {
+        }
+
+        int64_t Numerator() const { return _numerator; }
+        int64_t Denominator() const { return _denominator; }
+
+        // The nearest float; only approximate.
+        float Value() const { return (float)((double)_numerator / _denominator); }
+
+        // The smallest integer duration no shorter than this.
+        Duration<TTime> Ceiling() const { return (_numerator + _denominator - 1) / _denominator; }
+
+        // This duration repeated count times.
+        RationalDuration<TTime> operator *(int64_t count) const
+        {
+            int64_t gcd = Gcd(count, _denominator);
+            int64_t reducedCount = count / gcd;
+            Check(reducedCount == 0 || _numerator <= INT64_MAX / reducedCount);
+            return RationalDuration<TTime>(_numerator * reducedCount, _denominator / gcd);
+        }
+
+        // Divide value by this duration, exactly: value = (quotient + remainder / Numerator()) * this,
+        // with 0 <= remainder < Numerator().  That is, quotient is how many whole copies of this fit into value,
+        // and remainder / Denominator() is how much of value is left over.  Negative values round the quotient
+        // down (towards minus infinity), so the remainder stays non-negative and beats keep their length across 0.
+        void Divide(int64_t value, int64_t& quotient, int64_t& remainder) const
+        {
+            Check(_numerator > 0);
+            if (value >= 0)
+            {
+                MultiplyDivide(value, _denominator, _numerator, quotient, remainder);
+                return;
+            }
+
+            Check(value > INT64_MIN);
+            MultiplyDivide(-value, _denominator, _numerator, quotient, remainder);
+            quotient = -quotient;
+            if (remainder > 0)
+            {
+                quotient--;
+                remainder = _numerator - remainder;
+            }
+        }
+
+        // Compute a * b / c, exactly, as quotient and remainder; a and b must be non-negative and c positive.
+        // The product a * b need not fit in 64 bits, but the quotient must.
+        static void MultiplyDivide(int64_t a, int64_t b, int64_t c, int64_t& quotient, int64_t& remainder)
+        {
+            Check(a >= 0 && b >= 0 && c > 0);
+            if (a == 0 || b <= INT64_MAX / a)
+            {
+                // the common case
+                quotient = (a * b) / c;
+                remainder = (a * b) % c;
+                return;
+            }
+
+            // Form the 128-bit product from 32-bit halves.
+            const uint64_t lowMask = 0xFFFFFFFF;
+            uint64_t aLow = (uint64_t)a & lowMask, aHigh = (uint64_t)a >> 32;
+            uint64_t bLow = (uint64_t)b & lowMask, bHigh = (uint64_t)b >> 32;
+            uint64_t lowLow = aLow * bLow;
+            uint64_t lowHigh = aLow * bHigh;
+            uint64_t highLow = aHigh * bLow;
+            uint64_t middle = (lowLow >> 32) + (lowHigh & lowMask) + (highLow & lowMask);
+            uint64_t productLow = (lowLow & lowMask) | (middle << 32);
+            uint64_t productHigh = aHigh * bHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+
+            // Then long-divide it a bit at a time.  Since c < 2^63, the running remainder always fits.
+            uint64_t divisor = (uint64_t)c;
+            uint64_t runningRemainder = 0;
+            uint64_t runningQuotient = 0;
+            for (int bit = 127; bit >= 0; bit--)
+            {
+                uint64_t nextBit = bit >= 64 ? (productHigh >> (bit - 64)) & 1 : (productLow >> bit) & 1;
+                runningRemainder = (runningRemainder << 1) | nextBit;
+                if (runningRemainder >= divisor)
+                {
+                    runningRemainder -= divisor;
+                    Check(bit < 63); // the quotient must fit
+                    runningQuotient |= (uint64_t)1 << bit;
+                }
+            }
+
+            quotient = (int64_t)runningQuotient;
+            remainder = (int64_t)runningRemainder;
+        }
+
+        bool operator ==(const RationalDuration<TTime>& other) const
+        {
+            return _numerator == other._numerator && _denominator == other._denominator;
+        }
+    };
 }
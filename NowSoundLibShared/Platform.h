@@ -0,0 +1,142 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+// The few things NowSound needs from the platform which differ between Windows (MSVC) and POSIX (GCC or Clang):
+// exporting functions from the library, the wide strings of the exported API, stopping in the debugger, and
+// compiler intrinsics.
+// Everything else in NowSound is standard C++ (or JUCE), so nothing else should need to know which platform it
+// is on.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+
+#include <intrin.h>
+
+// Export a function from the NowSound library.
+#define NOWSOUND_EXPORT __declspec(dllexport)
+
+namespace NowSound
+{
+    namespace Platform
+    {
+        // A character of the exported API's strings: UTF-16, as wchar_t is on Windows.
+        typedef wchar_t WideChar;
+    }
+}
+
+#else
+
+#include <cstdio>
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define NOWSOUND_HAS_BACKTRACE 1
+#endif
+
+// Export a function from the NowSound library.
+#define NOWSOUND_EXPORT __attribute__((visibility("default")))
+
+namespace NowSound
+{
+    namespace Platform
+    {
+        // A character of the exported API's strings.  These are UTF-16 everywhere, as .NET marshals them (LPWStr);
+        // wchar_t is UTF-32 here, so they are char16_t, converted to and from wchar_t strings at the API boundary.
+        typedef char16_t WideChar;
+    }
+}
+
+// The exported API's strings, under the name Windows gives them.
+typedef NowSound::Platform::WideChar* LPWSTR;
+
+#endif
+
+namespace NowSound
+{
+    namespace Platform
+    {
+        // Copy up to count characters of source into dest, an exported API string buffer with room for capacity
+        // WideChars (counting the terminating null); what does not fit is truncated, never splitting a surrogate
+        // pair.  dest is always null-terminated.
+        inline void CopyWideString(WideChar* dest, size_t capacity, const wchar_t* source, size_t count)
+        {
+            if (capacity == 0)
+            {
+                return;
+            }
+
+            size_t written = 0;
+            for (size_t i = 0; i < count && source[i] != 0; i++)
+            {
+                uint32_t c = (uint32_t)source[i];
+                if (sizeof(wchar_t) > sizeof(WideChar) && c > 0xFFFF)
+                {
+                    if (written + 2 > capacity - 1)
+                    {
+                        break;
+                    }
+                    c -= 0x10000;
+                    dest[written++] = (WideChar)(0xD800 + (c >> 10));
+                    dest[written++] = (WideChar)(0xDC00 + (c & 0x3FF));
+                }
+                else
+                {
+                    if (written + 1 > capacity - 1)
+                    {
+                        break;
+                    }
+                    dest[written++] = (WideChar)c;
+                }
+            }
+            dest[written] = 0;
+        }
+
+        // The wchar_t string for up to count characters of an exported API string, stopping early at a null.
+        inline std::wstring ToWideString(const WideChar* source, size_t count = SIZE_MAX)
+        {
+            std::wstring result;
+            for (size_t i = 0; i < count && source[i] != 0; i++)
+            {
+                uint32_t c = (uint32_t)source[i];
+                if (sizeof(wchar_t) > sizeof(WideChar) && c >= 0xD800 && c < 0xDC00
+                    && i + 1 < count && source[i + 1] >= 0xDC00 && source[i + 1] < 0xE000)
+                {
+                    // a surrogate pair, which UTF-32 holds as one character
+                    c = 0x10000 + ((c - 0xD800) << 10) + ((uint32_t)source[i + 1] - 0xDC00);
+                    i++;
+                }
+                result.push_back((wchar_t)c);
+            }
+            return result;
+        }
+
+        // The index of the highest set bit of value, which must be nonzero.
+        inline int HighestSetBit(uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return (int)index;
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+
+        // Break into the debugger (on Windows); on POSIX, where there may be none attached, print a backtrace to
+        // stderr so a failed Check() at least says where it failed.
+        inline void DebugBreak()
+        {
+#ifdef _WIN32
+            __debugbreak();
+#elif defined(NOWSOUND_HAS_BACKTRACE)
+            void* frames[64];
+            int frameCount = backtrace(frames, 64);
+            backtrace_symbols_fd(frames, frameCount, fileno(stderr));
+#endif
+        }
+    }
+}
@@ -0,0 +1,142 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // A fixed-capacity list of items which the audio thread visits every block, while one other thread (the
+    // message thread) adds and removes them.
+    //
+    // The list is a flat array of slots, so visiting it is a linear scan with no allocation or locking.  Adding
+    // fills the first empty slot.  Removing empties the item's slot and then waits until the audio thread is no
+    // longer in a render which might have seen the item, so once Remove() returns, the caller may destroy it.
+    //
+    // The audio thread brackets each visit with BeginRender() and EndRender(), and skips empty slots.
+    template<typename T>
+    class RenderList
+    {
+    private:
+        // The number of slots.
+        const int _capacity;
+
+        // The slots; nullptr when empty.
+        std::unique_ptr<std::atomic<T*>[]> _slots;
+
+        // One more than the highest slot ever filled; the audio thread need look no further.
+        std::atomic<int> _slotCount;
+
+        // The number of filled slots.  Message thread only.
+        int _count;
+
+        // Incremented at the start and end of every render; odd while the audio thread is rendering.
+        std::atomic<uint64_t> _renderEpoch;
+
+    public:
+        RenderList(int capacity)
+            : _capacity{ capacity },
+            _slots{ new std::atomic<T*>[capacity] },
+            _slotCount{ 0 },
+            _count{ 0 },
+            _renderEpoch{ 0 }
+        {
+            Check(capacity > 0);
+            for (int i = 0; i < capacity; i++)
+            {
+                _slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        RenderList(const RenderList&) = delete;
+        RenderList& operator=(const RenderList&) = delete;
+
+        // The number of slots.
+        int Capacity() const { return _capacity; }
+
+        // The number of items in the list.  Message thread only.
+        int Count() const { return _count; }
+
+        // Is the item in the list?  Message thread only.
+        bool Contains(const T* item) const
+        {
+            int slotCount = _slotCount.load(std::memory_order_relaxed);
+            for (int i = 0; i < slotCount; i++)
+            {
+                if (_slots[i].load(std::memory_order_relaxed) == item)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Add the item; returns false, doing nothing, if the list is full.  Message thread only.
+        bool TryAdd(T* item)
+        {
+            Check(item != nullptr);
+
+            for (int i = 0; i < _capacity; i++)
+            {
+                if (_slots[i].load(std::memory_order_relaxed) == nullptr)
+                {
+                    _slots[i].store(item, std::memory_order_release);
+                    if (i >= _slotCount.load(std::memory_order_relaxed))
+                    {
+                        _slotCount.store(i + 1, std::memory_order_release);
+                    }
+                    _count++;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Remove the item, which must be in the list, and wait until the audio thread cannot be using it.
+        // Message thread only.
+        void Remove(T* item)
+        {
+            int slotCount = _slotCount.load(std::memory_order_relaxed);
+            int i = 0;
+            while (i < slotCount && _slots[i].load(std::memory_order_relaxed) != item)
+            {
+                i++;
+            }
+            Check(i < slotCount);
+
+            _slots[i].store(nullptr, std::memory_order_seq_cst);
+            _count--;
+
+            // If a render is in progress, it may have loaded the item before we emptied its slot; wait for it to
+            // finish.  Any render starting after this point will see the empty slot.
+            uint64_t epoch = _renderEpoch.load(std::memory_order_seq_cst);
+            if ((epoch & 1) != 0)
+            {
+                while (_renderEpoch.load(std::memory_order_seq_cst) == epoch)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        // Audio thread: start a render.
+        void BeginRender() { _renderEpoch.fetch_add(1, std::memory_order_seq_cst); }
+
+        // Audio thread: end a render.
+        void EndRender() { _renderEpoch.fetch_add(1, std::memory_order_release); }
+
+        // Audio thread, between BeginRender() and EndRender(): the number of slots to scan.
+        int SlotCount() const { return _slotCount.load(std::memory_order_acquire); }
+
+        // Audio thread, between BeginRender() and EndRender(): the item in the given slot, or nullptr.
+        T* At(int slot) const { return _slots[slot].load(std::memory_order_seq_cst); }
+    };
+}
@@ -0,0 +1,147 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // A source of mono samples, generated a block at a time; used to feed the inputs of an offline graph.
+    //
+    // Generators are deterministic, so two offline runs with the same generators render the same audio.
+    class SignalGenerator
+    {
+    public:
+        virtual ~SignalGenerator() {}
+
+        // Write the next sampleCount samples to dest.
+        virtual void Generate(float* dest, int sampleCount) = 0;
+    };
+
+    // Silence.
+    class SilenceGenerator : public SignalGenerator
+    {
+    public:
+        virtual void Generate(float* dest, int sampleCount) override
+        {
+            for (int i = 0; i < sampleCount; i++)
+            {
+                dest[i] = 0;
+            }
+        }
+    };
+
+    // A sine wave, continuous across blocks.
+    class SineGenerator : public SignalGenerator
+    {
+    private:
+        // The phase advance per sample, in radians.
+        const double _phaseIncrement;
+
+        // The peak amplitude.
+        const float _amplitude;
+
+        // The phase of the next sample, in radians; kept in [0, 2pi) so it never loses precision.
+        double _phase;
+
+    public:
+        SineGenerator(int sampleRateHz, double frequencyHz, float amplitude)
+            : _phaseIncrement{ 2 * 3.14159265358979323846 * frequencyHz / sampleRateHz },
+            _amplitude{ amplitude },
+            _phase{ 0 }
+        {
+            Check(sampleRateHz > 0);
+        }
+
+        virtual void Generate(float* dest, int sampleCount) override
+        {
+            const double twoPi = 2 * 3.14159265358979323846;
+            for (int i = 0; i < sampleCount; i++)
+            {
+                dest[i] = _amplitude * (float)std::sin(_phase);
+                _phase += _phaseIncrement;
+                if (_phase >= twoPi)
+                {
+                    _phase -= twoPi;
+                }
+            }
+        }
+    };
+
+    // Uniform white noise in [-amplitude, amplitude), from a seeded xorshift generator.
+    class NoiseGenerator : public SignalGenerator
+    {
+    private:
+        // The peak amplitude.
+        const float _amplitude;
+
+        // The xorshift state; never zero.
+        uint32_t _state;
+
+    public:
+        NoiseGenerator(uint32_t seed, float amplitude)
+            : _amplitude{ amplitude },
+            _state{ seed == 0 ? 1 : seed }
+        {
+        }
+
+        virtual void Generate(float* dest, int sampleCount) override
+        {
+            for (int i = 0; i < sampleCount; i++)
+            {
+                _state ^= _state << 13;
+                _state ^= _state >> 17;
+                _state ^= _state << 5;
+                // top 24 bits, which a float holds exactly, scaled to [-1, 1)
+                dest[i] = _amplitude * ((float)(_state >> 8) / (float)(1 << 23) - 1.0f);
+            }
+        }
+    };
+
+    // A single-sample click of the given amplitude every periodSamples samples, starting with the first; handy for
+    // measuring latency and loop alignment.
+    class ImpulseGenerator : public SignalGenerator
+    {
+    private:
+        // The number of samples from one click to the next.
+        const int _periodSamples;
+
+        // The click's amplitude.
+        const float _amplitude;
+
+        // The number of samples until the next click.
+        int _untilNext;
+
+    public:
+        ImpulseGenerator(int periodSamples, float amplitude)
+            : _periodSamples{ periodSamples },
+            _amplitude{ amplitude },
+            _untilNext{ 0 }
+        {
+            Check(periodSamples > 0);
+        }
+
+        virtual void Generate(float* dest, int sampleCount) override
+        {
+            for (int i = 0; i < sampleCount; i++)
+            {
+                if (_untilNext == 0)
+                {
+                    dest[i] = _amplitude;
+                    _untilNext = _periodSamples;
+                }
+                else
+                {
+                    dest[i] = 0;
+                }
+                _untilNext--;
+            }
+        }
+    };
+}
@@ -7,6 +7,7 @@
 
 #include "stdafx.h"
 
+#include "AudioKernels.h"
 #include "BufferAllocator.h"
 #include "NowSoundTime.h"
 
@@ -147,6 +148,30 @@ namespace NowSound
             ArrayCopy(_buffer.Data(), _offset.Value() * _sliverCount, dest, 0, _duration.Value() * _sliverCount);
         }
 
+        // Copy this slice's data out to separate per-sliver-index destinations (e.g. one per audio channel), starting at
+        // channels[i][channelOffset]; channels must hold SliverCount() pointers.
+        void CopyToChannels(TValue* const* channels, int64_t channelOffset) const
+        {
+            AudioKernels::Deinterleave(
+                _buffer.Data() + _offset.Value() * _sliverCount,
+                _sliverCount,
+                channels,
+                channelOffset,
+                _duration.Value());
+        }
+
+        // Copy data from separate per-sliver-index sources (e.g. one per audio channel), starting at
+        // channels[i][channelOffset], replacing all data in this slice; channels must hold SliverCount() pointers.
+        void CopyFromChannels(const TValue* const* channels, int64_t channelOffset)
+        {
+            AudioKernels::Interleave(
+                channels,
+                _sliverCount,
+                channelOffset,
+                _buffer.Data() + _offset.Value() * _sliverCount,
+                _duration.Value());
+        }
+
         // Copy data from the source, replacing all data in this slice.
         void CopyFrom(const TValue* source)
         {
@@ -176,7 +201,7 @@ namespace NowSound
         // Equality comparison.
         bool Equals(const Slice<TTime, TValue>& other) const
         {
-            return Buffer.Equals(other.Buffer) && Offset == other.Offset && _duration == other.SliceDuration();
+            return _buffer.Data() == other._buffer.Data() && _offset == other._offset && _duration == other.SliceDuration();
         }
     };
 
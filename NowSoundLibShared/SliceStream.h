@@ -28,7 +28,7 @@ namespace NowSound
     // TValue entries in the stream's backing store; such a contiguous group is called a sliver.  
     // A Stream with duration 1 has exactly one sliver of data. 
     template<typename TTime, typename TValue>
-    class SliceStream : public IStream<TTime>
+    class SliceStream
     {
         // The initial time of this Stream.
         // 
@@ -39,11 +39,11 @@ namespace NowSound
     protected:
         Time<TTime> _initialTime;
 
-        // The floating-point duration of this stream in terms of samples; only valid once shut.
+        // The exact duration of this stream in terms of samples; only valid once shut.
         // 
         // This allows streams to have lengths measured in fractional samples, which prevents roundoff error from
         // causing clock drift when using unevenly divisible BPM values and looping for long periods.
-        ContinuousDuration<TTime> _continuousDuration;
+        RationalDuration<TTime> _continuousDuration;
 
         // As with Slice<typeparam name="TValue"></typeparam>, this defines the number of T values in an
         // individual slice.
@@ -52,7 +52,7 @@ namespace NowSound
         // Is this stream shut?
         bool _isShut;
 
-        SliceStream(Time<TTime> initialTime, int sliverCount, ContinuousDuration<AudioSample> continuousDuration, bool isShut)
+        SliceStream(Time<TTime> initialTime, int sliverCount, RationalDuration<TTime> continuousDuration, bool isShut)
             : _initialTime{ initialTime }, _sliverCount{ sliverCount }, _continuousDuration{ continuousDuration }, _isShut{ isShut }
         {
         }
@@ -66,7 +66,10 @@ namespace NowSound
         // The floating-point-accurate duration of this stream; only valid once shut.
         // This may have a fractional part if the BPM of the stream can't be evenly divided into
         // the sample rate.
-        virtual ContinuousDuration<TTime> ExactDuration() const { return _continuousDuration; }
+        virtual ContinuousDuration<TTime> ExactDuration() const { return _continuousDuration.Value(); }
+
+        // The exact duration of this stream; only valid once shut.
+        virtual RationalDuration<TTime> ExactRationalDuration() const { return _continuousDuration; }
 
         // The number of T values in each sliver of this slice.
         // SliceDuration.Value() is the number of slivers in the slice;
@@ -77,7 +80,7 @@ namespace NowSound
         // 
         // finalDuration is the possibly fractional duration to be associated with the stream;
         // must be strictly equal to, or less than one sample smaller than, the discrete duration.
-        virtual void Shut(ContinuousDuration<TTime> finalDuration)
+        virtual void Shut(RationalDuration<TTime> finalDuration)
         {
             Check(!IsShut());
             _isShut = true;
@@ -99,20 +102,19 @@ namespace NowSound
         Duration<TTime> _discreteDuration;
 
         // The mapper that converts absolute time into relative time for this stream.
-        // This is held by a unique_ptr to allow for polymorphism.
-        std::unique_ptr<IntervalMapper<TTime>> _intervalMapper;
+        IntervalMapper<TTime> _intervalMapper;
 
         DenseSliceStream(
             Time<TTime> initialTime,
             int sliverCount,
-            ContinuousDuration<TTime> exactDuration,
+            RationalDuration<TTime> exactDuration,
             bool isShut,
             Duration<TTime> discreteDuration,
-            std::unique_ptr<IntervalMapper<TTime>>&& intervalMapper)
+            IntervalMapper<TTime> intervalMapper)
             : SliceStream<TTime, TValue>(initialTime, sliverCount, exactDuration, isShut),
             _discreteDuration{ discreteDuration },
             // when appending, we always start out with identity mapping
-            _intervalMapper{ std::move(intervalMapper) }
+            _intervalMapper{ intervalMapper }
         { }
 
     public:
@@ -121,14 +123,26 @@ namespace NowSound
 
         Interval<TTime> DiscreteInterval() const { return Interval<TTime>(this->InitialTime(), this->DiscreteDuration()); }
 
-        IntervalMapper<TTime>* Mapper() const { return _intervalMapper.get(); }
-        void Mapper(IntervalMapper<TTime>&& value) { _intervalMapper = std::move(value); }
+        const IntervalMapper<TTime>& Mapper() const { return _intervalMapper; }
+        void Mapper(const IntervalMapper<TTime>& value) { _intervalMapper = value; }
+
+        // The stream state that mapping depends on.
+        StreamExtent<TTime> Extent() const
+        {
+            return StreamExtent<TTime>(this->_initialTime, _discreteDuration, this->_continuousDuration, this->_isShut);
+        }
+
+        // Map the input interval with the current mapper; see IntervalMapper.h.
+        Interval<TTime> MapNextSubInterval(Interval<TTime> input) const
+        {
+            return NowSound::MapNextSubInterval(_intervalMapper, Extent(), input);
+        }
 
         // Shut the stream; no further appends may be accepted.
         // 
         // finalDuration is the possibly fractional duration to be associated with the stream;
         // must be strictly equal to, or less than one sample smaller than, the discrete duration.</param>
-        virtual void Shut(ContinuousDuration<AudioSample> finalDuration)
+        virtual void Shut(RationalDuration<TTime> finalDuration)
         {
             Check(!this->IsShut());
             // Should always have as many samples as the rounded-up finalDuration.
@@ -136,7 +150,7 @@ namespace NowSound
             // or Math.Ceiling(finalDuration) samples on each iteration, such that it remains perfectly in
             // time with finalDuration's fractional value.  So, a shut loop should have DiscreteDuration
             // equal to rounded-up ContinuousDuration.
-            Check((int)std::ceil(finalDuration.Value()) == DiscreteDuration().Value());
+            Check(finalDuration.Ceiling() == DiscreteDuration());
             SliceStream<TTime, TValue>::Shut(finalDuration);
         }
 
@@ -163,6 +177,51 @@ namespace NowSound
         */
     };
 
+    template<typename TTime, typename TValue>
+    class BufferedSliceStream;
+
+    // Where the last sequential lookup into a BufferedSliceStream left off.
+    //
+    // Looping playback asks a stream for the slice at time T, then at T + (the duration it got), and so on, forever.
+    // A cursor remembers the slice index and mapped time that the last such lookup ended at, so that the next one can
+    // pick up right there, without going through the interval mapper or searching the stream's slices.  Only a seek
+    // (a lookup at any other time), a wrap back to the start of the loop, or a change to the stream itself causes a
+    // full lookup.
+    //
+    // A default-constructed cursor is not positioned anywhere; its first use always does a full lookup.
+    template<typename TTime>
+    class PlaybackCursor
+    {
+        template<typename, typename>
+        friend class BufferedSliceStream;
+
+    private:
+        // The stream (as of which change) this cursor is positioned in; null if not yet positioned.
+        const void* _stream;
+        int64_t _streamVersion;
+
+        // The unmapped time the next sequential lookup will ask for.
+        Time<TTime> _nextTime;
+
+        // The stream time that _nextTime maps to.
+        Time<TTime> _nextMappedTime;
+
+        // How much stream time remains from _nextMappedTime before the mapper needs consulting again (e.g. the
+        // rest of the current loop iteration).
+        Duration<TTime> _mappedRemaining;
+
+        // Index of the stream slice containing _nextMappedTime.
+        size_t _sliceIndex;
+
+    public:
+        PlaybackCursor()
+            : _stream{ nullptr }, _streamVersion{ 0 }, _nextTime{}, _nextMappedTime{}, _mappedRemaining{}, _sliceIndex{ 0 }
+        { }
+
+        // Forget the current position, so the next lookup does a full search.
+        void Reset() { _stream = nullptr; }
+    };
+
     // A stream that buffers some amount of data in memory.
     template<typename TTime, typename TValue>
     class BufferedSliceStream : public DenseSliceStream<TTime, TValue>
@@ -191,6 +250,9 @@ namespace NowSound
 
         bool _useExactLoopingMapper;
 
+        // Incremented whenever _data or the mapper changes, invalidating any PlaybackCursor positioned in this stream.
+        int64_t _version;
+
         void EnsureFreeSlice()
         {
             if (_remainingFreeSlice.IsEmpty())
@@ -234,6 +296,7 @@ namespace NowSound
 
             this->_discreteDuration = this->_discreteDuration + source.SliceDuration();
             _remainingFreeSlice = _remainingFreeSlice.SubsliceStartingAt(source.SliceDuration());
+            _version++;
         }
 
     public:
@@ -249,12 +312,13 @@ namespace NowSound
                 ContinuousDuration<TTime>{0},
                 false, // isShut
                 Duration<TTime>{},
-                std::unique_ptr<IntervalMapper<TTime>>(new IdentityIntervalMapper<TTime>())),
+                IdentityIntervalMapper<TTime>()),
             _allocator{ allocator },
             _buffers{ },
             _remainingFreeSlice{ },
             _maxBufferedDuration{ maxBufferedDuration },
-            _useExactLoopingMapper{ useExactLoopingMapper }
+            _useExactLoopingMapper{ useExactLoopingMapper },
+            _version{ 0 }
         { }
 
         BufferedSliceStream(
@@ -266,27 +330,29 @@ namespace NowSound
                 ContinuousDuration<TTime>{0},
                 false, // isShut
                 Duration<TTime>{},
-                std::unique_ptr<IntervalMapper<TTime>>(new IdentityIntervalMapper<TTime>())),
+                IdentityIntervalMapper<TTime>()),
             _allocator{ allocator },
             _buffers{},
             _remainingFreeSlice{},
             _maxBufferedDuration{ Duration<TTime>{} },
-            _useExactLoopingMapper{ false }
+            _useExactLoopingMapper{ false },
+            _version{ 0 }
         { }
 
         BufferedSliceStream(BufferedSliceStream<TTime, TValue>&& other)
             : DenseSliceStream<TTime, TValue>(
                 other.InitialTime(),
                 other.SliverCount(),
-                other.ExactDuration(),
+                other.ExactRationalDuration(),
                 other.IsShut(),
                 other.DiscreteDuration(),
-                std::move(other._intervalMapper)),
+                other._intervalMapper),
             _allocator{ other._allocator },
             _buffers{ std::move(other._buffers) },
             _remainingFreeSlice{ other._remainingFreeSlice },
             _maxBufferedDuration{ other._maxBufferedDuration },
-            _useExactLoopingMapper{ other._useExactLoopingMapper }
+            _useExactLoopingMapper{ other._useExactLoopingMapper },
+            _version{ 0 }
         {
             Check(_allocator != nullptr);
             Check(this->InitialTime() == other.InitialTime());
@@ -307,18 +373,19 @@ namespace NowSound
             }
         }
 
-        virtual void Shut(ContinuousDuration<AudioSample> finalDuration)
+        virtual void Shut(RationalDuration<TTime> finalDuration)
         {
             this->DenseSliceStream<TTime, TValue>::Shut(finalDuration);
             // swap out our mappers, we're looping now
             if (_useExactLoopingMapper)
             {
-                this->_intervalMapper.reset(new ExactLoopingIntervalMapper<TTime>());
+                this->_intervalMapper = ExactLoopingIntervalMapper<TTime>();
             }
             else
             {
-                this->_intervalMapper.reset(new SimpleLoopingIntervalMapper<TTime>());
+                this->_intervalMapper = SimpleLoopingIntervalMapper<TTime>();
             }
+            _version++;
 
 #if SPAMAUDIO
             foreach(TimedSlice<TTime, TValue> timedSlice in _data) {
@@ -329,6 +396,13 @@ namespace NowSound
             // and, do a microfade out at the end of the last slice, and in at the start of the first.
             // this avoids clicking that was empirically otherwise present and annoying.
             const int64_t microfadeDuration{ 20 };
+
+            // a stream too short to hold both fades without overlapping is no real loop; leave it as recorded
+            if (this->DiscreteDuration().Value() < microfadeDuration * 2)
+            {
+                return;
+            }
+
             TimedSlice<TTime, TValue>& firstSlice{ _data.at(0) };
             TValue* firstSliceData{ firstSlice.NonConstValue().OffsetPointer() };
             TimedSlice<TTime, TValue>& lastSlice{ _data.at(_data.size() - 1) };
@@ -347,6 +421,36 @@ namespace NowSound
             }
         }
 
+        // Append the given amount of data, held in SliverCount() separate arrays (e.g. one per audio channel),
+        // interleaving it into this stream's slivers.
+        void AppendChannels(Duration<TTime> duration, const TValue* const* channels)
+        {
+            Check(!this->IsShut());
+
+            int64_t channelOffset = 0;
+            while (duration > 0)
+            {
+                EnsureFreeSlice();
+
+                // if source is larger than available free buffer, then we'll iterate
+                Duration<TTime> durationToCopy(duration);
+                if (durationToCopy > _remainingFreeSlice.SliceDuration())
+                {
+                    durationToCopy = _remainingFreeSlice.SliceDuration();
+                }
+
+                Slice<TTime, TValue> dest(_remainingFreeSlice.SubsliceOfDuration(durationToCopy));
+                dest.CopyFromChannels(channels, channelOffset);
+
+                InternalAppend(dest);
+
+                duration = duration - durationToCopy;
+                channelOffset += durationToCopy.Value();
+
+                Trim();
+            }
+        }
+
         // Append the given amount of data.
         virtual void Append(Duration<TTime> duration, const TValue* p)
         {
@@ -447,6 +551,8 @@ namespace NowSound
                 return;
             }
 
+            _version++;
+
             while (this->DiscreteDuration() > _maxBufferedDuration)
             {
                 Duration<TTime> toTrim = this->DiscreteDuration() - _maxBufferedDuration;
@@ -512,7 +618,7 @@ namespace NowSound
         // (after the interval is mapped to stream time per the current mapping).
         virtual Slice<TTime, TValue> GetSliceContaining(Interval<TTime> interval) const
         {
-            Interval<TTime> firstMappedInterval = this->Mapper()->MapNextSubInterval(this, interval);
+            Interval<TTime> firstMappedInterval = this->MapNextSubInterval(interval);
 
             if (firstMappedInterval.IsEmpty())
             {
@@ -533,6 +639,70 @@ namespace NowSound
             return ret;
         }
 
+        // Get the next slice of the given interval, as GetSliceContaining(interval) does, but starting from where the
+        // cursor's last lookup left off if the interval starts there.  The cursor is advanced past the returned slice.
+        //
+        // Unlike GetSliceContaining(interval), the returned slice is never longer than the interval.
+        Slice<TTime, TValue> GetSliceContaining(PlaybackCursor<TTime>& cursor, Interval<TTime> interval) const
+        {
+            if (interval.IsEmpty())
+            {
+                return Slice<TTime, TValue>::Empty();
+            }
+
+            if (cursor._stream != this
+                || cursor._streamVersion != _version
+                || cursor._nextTime != interval.InitialTime()
+                || cursor._mappedRemaining == 0)
+            {
+                // A seek, a wrap, or the stream changed; map the interval from scratch.
+                // Asking for more than the whole stream gets us everything the mapper will map contiguously from here.
+                Interval<TTime> mappedRun = this->MapNextSubInterval(
+                    Interval<TTime>(interval.InitialTime(), this->DiscreteDuration() + Duration<TTime>{ 1 }));
+
+                if (mappedRun.IsEmpty())
+                {
+                    cursor.Reset();
+                    return Slice<TTime, TValue>::Empty();
+                }
+
+                const TimedSlice<TTime, TValue>& foundTimedSlice = GetInitialTimedSlice(mappedRun);
+
+                cursor._stream = this;
+                cursor._streamVersion = _version;
+                cursor._nextTime = interval.InitialTime();
+                cursor._nextMappedTime = mappedRun.InitialTime();
+                cursor._mappedRemaining = mappedRun.IntervalDuration();
+                cursor._sliceIndex = &foundTimedSlice - _data.data();
+            }
+            else
+            {
+                // Sequential; at most step forward into the next slice.
+                const TimedSlice<TTime, TValue>& current = _data[cursor._sliceIndex];
+                if (cursor._nextMappedTime >= current.InitialTime() + current.Value().SliceDuration())
+                {
+                    cursor._sliceIndex++;
+                }
+            }
+
+            const TimedSlice<TTime, TValue>& timedSlice = _data[cursor._sliceIndex];
+            Duration<TTime> offset = cursor._nextMappedTime - timedSlice.InitialTime();
+            Duration<TTime> duration = std::min(
+                std::min(interval.IntervalDuration().Value(), cursor._mappedRemaining.Value()),
+                (timedSlice.Value().SliceDuration() - offset).Value());
+
+            cursor._nextTime = cursor._nextTime + duration;
+            cursor._nextMappedTime = cursor._nextMappedTime + duration;
+            cursor._mappedRemaining = cursor._mappedRemaining - duration;
+
+            // the bounds are known good by construction, so skip Subslice's checks
+            return Slice<TTime, TValue>(
+                timedSlice.Value().Buffer(),
+                timedSlice.Value().Offset() + offset,
+                duration,
+                this->SliverCount());
+        }
+
         // Get the slice that intersects the given interval's start time.
         const TimedSlice<TTime, TValue>& GetInitialTimedSlice(Interval<TTime> firstMappedInterval) const
         {
@@ -562,4 +732,141 @@ namespace NowSound
             }
         }
     };
+
+    // A stream that holds only the most recent data appended to it, up to a fixed capacity, in a circular buffer.
+    //
+    // This is for bounded history (e.g. the last second of an input), which BufferedSliceStream supports only at the
+    // cost of shifting its slice and buffer vectors and round-tripping buffers through the allocator as it trims.
+    // Here, appending and trimming just move the start index around the ring; the storage is allocated once, up
+    // front, so nothing allocates on the audio thread.
+    //
+    // Slices returned from GetSliceContaining never span the wrap point, so reading across it takes two slices,
+    // just as reading across buffer boundaries in a BufferedSliceStream does.
+    template<typename TTime, typename TValue>
+    class RingSliceStream : public DenseSliceStream<TTime, TValue>
+    {
+    private:
+        // The circular backing store, holding _capacity slivers.
+        OwningBuf<TValue> _ringBuffer;
+
+        // Non-owning reference to _ringBuffer, for making slices from const methods.
+        Buf<TValue> _ring;
+
+        // The number of slivers the ring holds.
+        const Duration<TTime> _capacity;
+
+        // Index (in slivers) of the sliver in the ring holding InitialTime().
+        int64_t _startIndex;
+
+        // Get the part of the ring starting at the given sliver index, of at most the given duration, not wrapping.
+        Slice<TTime, TValue> RingSlice(int64_t index, int64_t duration) const
+        {
+            Check(index < _capacity.Value());
+            return Slice<TTime, TValue>(
+                _ring,
+                index,
+                std::min(duration, _capacity.Value() - index),
+                this->SliverCount());
+        }
+
+    public:
+        // Create a ring stream holding at most capacity slivers of sliverCount values each.
+        RingSliceStream(Time<TTime> initialTime, int sliverCount, Duration<TTime> capacity)
+            : DenseSliceStream<TTime, TValue>(
+                initialTime,
+                sliverCount,
+                ContinuousDuration<TTime>{0},
+                false, // isShut
+                Duration<TTime>{},
+                IdentityIntervalMapper<TTime>()),
+            _ringBuffer{ 0, (int)(capacity.Value() * sliverCount) },
+            _ring{ _ringBuffer },
+            _capacity{ capacity },
+            _startIndex{ 0 }
+        {
+            Check(capacity > 0);
+        }
+
+        RingSliceStream(const RingSliceStream<TTime, TValue>& other) = delete;
+
+        // The most slivers this stream will ever hold.
+        Duration<TTime> Capacity() const { return _capacity; }
+
+        // Append the given amount of data; if this overflows the capacity, the oldest data is dropped.
+        virtual void Append(Duration<TTime> duration, const TValue* p)
+        {
+            Check(!this->IsShut());
+            Check(duration >= 0);
+
+            int64_t count = duration.Value();
+            int64_t capacity = _capacity.Value();
+            int64_t held = this->DiscreteDuration().Value();
+
+            // only the last capacity slivers of the source can survive
+            int64_t skipped = count > capacity ? count - capacity : 0;
+            p += skipped * this->SliverCount();
+
+            // write the rest at the end of the ring, in at most two pieces
+            int64_t writeIndex = (_startIndex + held + skipped) % capacity;
+            int64_t remaining = count - skipped;
+            while (remaining > 0)
+            {
+                Slice<TTime, TValue> dest = RingSlice(writeIndex, remaining);
+                dest.CopyFrom(p);
+                p += dest.SliceDuration().Value() * this->SliverCount();
+                remaining -= dest.SliceDuration().Value();
+                writeIndex = (writeIndex + dest.SliceDuration().Value()) % capacity;
+            }
+
+            // and drop whatever fell off the start
+            int64_t total = held + count;
+            if (total > capacity)
+            {
+                int64_t dropped = total - capacity;
+                _startIndex = (_startIndex + dropped) % capacity;
+                this->_initialTime = this->_initialTime + Duration<TTime>(dropped);
+                total = capacity;
+            }
+            this->_discreteDuration = total;
+        }
+
+        // Append this slice's data, by copying it into the ring.
+        virtual void Append(const Slice<TTime, TValue>& source)
+        {
+            Check(source.SliverCount() == this->SliverCount());
+            Slice<TTime, TValue> sourceCopy = source;
+            Append(source.SliceDuration(), sourceCopy.OffsetPointer());
+        }
+
+        // Map the interval time to stream local time, and get the slice containing the start time of the interval
+        // (after the interval is mapped to stream time per the current mapping); this stops at the wrap point.
+        virtual Slice<TTime, TValue> GetSliceContaining(Interval<TTime> interval) const
+        {
+            Interval<TTime> mappedInterval = this->MapNextSubInterval(interval);
+
+            if (mappedInterval.IsEmpty())
+            {
+                return Slice<TTime, TValue>::Empty();
+            }
+
+            Check(mappedInterval.InitialTime() >= this->InitialTime());
+            Check(mappedInterval.InitialTime() + mappedInterval.IntervalDuration() <= this->InitialTime() + this->DiscreteDuration());
+
+            int64_t offset = (mappedInterval.InitialTime() - this->InitialTime()).Value();
+            return RingSlice((_startIndex + offset) % _capacity.Value(), mappedInterval.IntervalDuration().Value());
+        }
+
+        // Copy the given interval's worth of data to the destination pointer.
+        virtual void CopyTo(const Interval<TTime>& sourceIntervalArgument, TValue* p) const
+        {
+            Interval<TTime> sourceInterval = sourceIntervalArgument;
+            while (!sourceInterval.IsEmpty())
+            {
+                Slice<TTime, TValue> source(GetSliceContaining(sourceInterval));
+                source.CopyTo(p);
+                p += source.SliceDuration().Value() * this->SliverCount();
+                sourceInterval = sourceInterval.SubintervalStartingAt(source.SliceDuration());
+            }
+        }
+    };
 }
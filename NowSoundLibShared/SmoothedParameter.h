@@ -0,0 +1,118 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cmath>
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // How a SmoothedParameter moves toward a new target.
+    enum class RampShape
+    {
+        // At a constant rate, arriving exactly rampSamples after the change.
+        Linear,
+
+        // Exponentially (a one-pole lowpass), covering all but 1/1000 (-60dB) of the distance in rampSamples.
+        // Gentler on volume changes, which are heard logarithmically.
+        Exponential,
+    };
+
+    // A float parameter which any thread may set at any rate, and which the audio thread ramps toward its
+    // latest setting rather than jumping, so that changes never click.
+    //
+    // Setting only stores the new target in an atomic; the audio thread picks up whatever the target is at the
+    // start of each block.  So a client can push automation at any rate without locks, and settings made between
+    // two blocks simply coalesce into the last of them (which is all a ramp could ever use anyway).
+    //
+    // The audio thread calls Advance() once per block, to get the parameter's value at the start and end of the
+    // block; the gain kernels interpolate linearly between the two.
+    class SmoothedParameter
+    {
+    private:
+        // The shape of the ramps.
+        const RampShape _shape;
+
+        // The length of a ramp, in samples.
+        const int _rampSamples;
+
+        // The exponential ramp's per-sample decay of the remaining distance.
+        const double _decayPerSample;
+
+        // The latest setting.
+        std::atomic<float> _target;
+
+        // The remaining fields are touched only by the audio thread.
+
+        // The value as of the end of the last block.
+        float _current;
+
+        // The target the current ramp is heading for.
+        float _rampTarget;
+
+        // The linear ramp's per-sample step, and the number of samples left in it.
+        float _linearStep;
+        int _linearRemaining;
+
+    public:
+        SmoothedParameter(float initialValue, RampShape shape, int rampSamples)
+            : _shape{ shape },
+            _rampSamples{ rampSamples },
+            _decayPerSample{ std::pow(0.001, 1.0 / rampSamples) },
+            _target{ initialValue },
+            _current{ initialValue },
+            _rampTarget{ initialValue },
+            _linearStep{ 0 },
+            _linearRemaining{ 0 }
+        {
+            Check(rampSamples > 0);
+        }
+
+        SmoothedParameter(const SmoothedParameter&) = delete;
+        SmoothedParameter& operator=(const SmoothedParameter&) = delete;
+
+        // The latest setting (which the audio thread may still be ramping toward).
+        float Target() const { return _target.load(std::memory_order_relaxed); }
+
+        // Set a new target.  Safe from any thread; never blocks.
+        void Set(float value) { _target.store(value, std::memory_order_relaxed); }
+
+        // Audio thread only: the value as of the end of the last block.
+        float Current() const { return _current; }
+
+        // Audio thread only: advance by a block of sampleCount samples, returning the value at its start and end.
+        void Advance(int sampleCount, float& start, float& end)
+        {
+            float target = _target.load(std::memory_order_relaxed);
+            if (target != _rampTarget)
+            {
+                _rampTarget = target;
+                _linearStep = (target - _current) / _rampSamples;
+                _linearRemaining = _rampSamples;
+            }
+
+            start = _current;
+            if (_current != _rampTarget)
+            {
+                if (_shape == RampShape::Linear)
+                {
+                    int steps = sampleCount < _linearRemaining ? sampleCount : _linearRemaining;
+                    _linearRemaining -= steps;
+                    _current = _linearRemaining == 0 ? _rampTarget : _current + _linearStep * steps;
+                }
+                else
+                {
+                    float remaining = (float)((_current - _rampTarget) * std::pow(_decayPerSample, sampleCount));
+                    // once the rest of the distance is inaudible, land exactly on the target
+                    _current = std::abs(remaining) < 1e-6f ? _rampTarget : _rampTarget + remaining;
+                }
+            }
+            end = _current;
+        }
+    };
+}
@@ -0,0 +1,83 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "Check.h"
+
+namespace NowSound
+{
+    // A bounded, lock-free queue with exactly one producer thread and one consumer thread.
+    //
+    // All storage is allocated at construction, so pushing never allocates; this is what lets the audio thread hand
+    // work to other threads.  The head and tail counters live on separate cache lines so the producer and consumer
+    // don't contend for one.
+    template<typename T>
+    class SpscQueue
+    {
+    private:
+        // The number of slots; a power of two.
+        const int _capacity;
+
+        // The slots.
+        std::unique_ptr<T[]> _slots;
+
+        // The number of items ever pushed; written only by the producer.
+        alignas(64) std::atomic<int64_t> _tail;
+
+        // The number of items ever popped; written only by the consumer.
+        alignas(64) std::atomic<int64_t> _head;
+
+    public:
+        // capacity must be a power of two.
+        SpscQueue(int capacity)
+            : _capacity{ capacity },
+            _slots{ new T[capacity] },
+            _tail{ 0 },
+            _head{ 0 }
+        {
+            Check(capacity > 0 && (capacity & (capacity - 1)) == 0);
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // The number of slots.
+        int Capacity() const { return _capacity; }
+
+        // Is the queue empty?  Exact on the consumer thread; a snapshot elsewhere.
+        bool IsEmpty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+        // Push an item; returns false (and does nothing) if the queue is full.  Producer thread only.
+        bool TryPush(const T& item)
+        {
+            int64_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head.load(std::memory_order_acquire) == _capacity)
+            {
+                return false;
+            }
+            _slots[tail & (_capacity - 1)] = item;
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Pop an item into item; returns false (leaving item alone) if the queue is empty.  Consumer thread only.
+        bool TryPop(T& item)
+        {
+            int64_t head = _head.load(std::memory_order_relaxed);
+            if (head == _tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            item = _slots[head & (_capacity - 1)];
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+    };
+}
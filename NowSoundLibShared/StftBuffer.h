@@ -0,0 +1,164 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <memory>
+
+#include "Check.h"
+#include "rosetta_fft.h"
+
+namespace NowSound
+{
+    // The recent history of a mono audio signal, from which overlapping windowed frames can be read for a
+    // short-time Fourier transform.
+    //
+    // One thread (the audio thread) appends samples; another (the transforming thread) reads frames, each frameSize
+    // samples long and ending on a multiple of hopSize.  The history is a ring holding several frames' worth of
+    // samples, so the reader can fall behind by that much without missing any frame; if it falls further behind,
+    // ReadWindowedFrame reports that the frame was overwritten rather than returning torn data.
+    //
+    // Each frame is multiplied by a Blackman-Harris window as it is read.  The window is scaled to sum to frameSize,
+    // so a windowed sinusoid shows the same peak magnitude as an unwindowed one would.
+    class StftBuffer
+    {
+    private:
+        // Samples per frame.
+        const int _frameSize;
+
+        // Samples between the ends of successive frames.
+        const int _hopSize;
+
+        // Samples of history kept; a power of two.
+        const int _capacity;
+
+        // The window, _frameSize long.
+        std::unique_ptr<float[]> _window;
+
+        // The ring of history, _capacity long; sample number p is at _history[p & (_capacity - 1)].  The reader
+        // may race the writer for a sample, so samples are relaxed atomics (plain moves, on the hardware we run
+        // on); the write limit then tells the reader whether what it read can be trusted.
+        std::unique_ptr<std::atomic<float>[]> _history;
+
+        // The number of samples ever appended.
+        std::atomic<int64_t> _writePosition;
+
+        // The number of samples appended once the append in progress (if any) is done; this is bumped before
+        // writing, so that a reader can tell when samples it has read may have been overwritten.
+        std::atomic<int64_t> _writeLimit;
+
+    public:
+        // The smallest power of two that is at least value.
+        static int RoundUpToPowerOfTwo(int value)
+        {
+            int result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // historyFrameCount is how many frames of history to keep; it is rounded up to a power of two samples.
+        StftBuffer(int frameSize, int hopSize, int historyFrameCount)
+            : _frameSize{ frameSize },
+            _hopSize{ hopSize },
+            _capacity{ RoundUpToPowerOfTwo(frameSize * historyFrameCount) },
+            _window{ new float[frameSize] },
+            _history{ new std::atomic<float>[_capacity] },
+            _writePosition{ 0 },
+            _writeLimit{ 0 }
+        {
+            Check(frameSize > 1);
+            Check(hopSize > 0 && hopSize <= frameSize);
+            Check(historyFrameCount >= 2);
+
+            std::unique_ptr<double[]> window{ new double[frameSize] };
+            RosettaFFT::CreateBlackmanHarrisWindow(frameSize, window.get());
+            double sum = 0;
+            for (int i = 0; i < frameSize; i++)
+            {
+                sum += window[i];
+            }
+            for (int i = 0; i < frameSize; i++)
+            {
+                _window[i] = (float)(window[i] * frameSize / sum);
+            }
+        }
+
+        StftBuffer(const StftBuffer&) = delete;
+        StftBuffer& operator=(const StftBuffer&) = delete;
+
+        // Samples per frame.
+        int FrameSize() const { return _frameSize; }
+
+        // Samples between the ends of successive frames.
+        int HopSize() const { return _hopSize; }
+
+        // Samples of history kept.
+        int Capacity() const { return _capacity; }
+
+        // The number of samples ever appended.
+        int64_t WritePosition() const { return _writePosition.load(std::memory_order_acquire); }
+
+        // The end of the first frame.
+        int64_t FirstFrameEnd() const { return _frameSize; }
+
+        // The end of the earliest frame which is still entirely in the history, given how much has been written.
+        int64_t EarliestReadableFrameEnd(int64_t writePosition) const
+        {
+            int64_t earliest = writePosition - _capacity + _frameSize;
+            if (earliest <= _frameSize)
+            {
+                return _frameSize;
+            }
+            // round up to the next frame end
+            int64_t hops = (earliest - _frameSize + _hopSize - 1) / _hopSize;
+            return _frameSize + hops * _hopSize;
+        }
+
+        // Append the mono mixdown (left / 2 + right / 2) of count stereo samples.  Only one thread may append.
+        void AppendStereo(const float* left, const float* right, int count)
+        {
+            int64_t position = _writePosition.load(std::memory_order_relaxed);
+            _writeLimit.store(position + count, std::memory_order_relaxed);
+            // keep the sample stores below from being seen before the new limit
+            std::atomic_thread_fence(std::memory_order_release);
+
+            int mask = _capacity - 1;
+            for (int i = 0; i < count; i++)
+            {
+                _history[(position + i) & mask].store(left[i] / 2 + right[i] / 2, std::memory_order_relaxed);
+            }
+            _writePosition.store(position + count, std::memory_order_release);
+        }
+
+        // Copy the windowed frame ending at sample number frameEnd (exclusive) into frame, which must hold
+        // FrameSize() floats.  Returns false, leaving frame unspecified, if that frame has not yet been completely
+        // written or has already been (even partly) overwritten.
+        bool ReadWindowedFrame(int64_t frameEnd, float* frame) const
+        {
+            int64_t frameStart = frameEnd - _frameSize;
+            Check(frameStart >= 0);
+
+            int64_t writePosition = WritePosition();
+            if (writePosition < frameEnd || frameStart < writePosition - _capacity)
+            {
+                return false;
+            }
+
+            int mask = _capacity - 1;
+            for (int i = 0; i < _frameSize; i++)
+            {
+                frame[i] = _history[(frameStart + i) & mask].load(std::memory_order_relaxed) * _window[i];
+            }
+
+            // if the writer lapped us while we were copying, the copy may be torn
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return frameStart >= _writeLimit.load(std::memory_order_relaxed) - _capacity;
+        }
+    };
+}
@@ -0,0 +1,51 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <cstdint>
+
+namespace NowSound
+{
+    // Counts of work done by one thread, for benchmarks to difference around an audio callback.
+    //
+    // Nothing here is counted in ordinary builds; each count is maintained only when a benchmark opts in, so that
+    // production code pays nothing for it.
+    struct ThreadWorkCounters
+    {
+        // Heap allocations made by this thread, and their total size; counted only by programs which replace the
+        // global operator new to call CountAllocation() (as NowSoundBenchmark does).
+        int64_t Allocations;
+        int64_t AllocatedBytes;
+
+        // Bytes of sample data read and written by the AudioKernels on this thread; counted only when
+        // NOWSOUND_COUNT_KERNEL_TRAFFIC is defined.  Nearly all of NowSound's own sample traffic goes through the
+        // kernels; JUCE's copies between graph nodes do not.
+        int64_t KernelBytes;
+    };
+
+    // The current thread's counters.
+    inline ThreadWorkCounters& CurrentThreadWorkCounters()
+    {
+        // constant-initialized, so safe to touch from inside operator new
+        thread_local ThreadWorkCounters counters{ 0, 0, 0 };
+        return counters;
+    }
+
+    // Record an allocation of the given size by the current thread.
+    inline void CountAllocation(size_t size)
+    {
+        ThreadWorkCounters& counters = CurrentThreadWorkCounters();
+        counters.Allocations++;
+        counters.AllocatedBytes += (int64_t)size;
+    }
+}
+
+// Record kernel traffic, if counting it.
+#ifdef NOWSOUND_COUNT_KERNEL_TRAFFIC
+#define NOWSOUND_KERNEL_TRAFFIC(bytes) (NowSound::CurrentThreadWorkCounters().KernelBytes += (int64_t)(bytes))
+#else
+#define NOWSOUND_KERNEL_TRAFFIC(bytes) ((void)0)
+#endif
@@ -0,0 +1,341 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "Check.h"
+#include "TimingHistogram.h"
+
+namespace NowSound
+{
+    // What a TimelineEvent records.
+    enum class TimelineEventKind : int32_t
+    {
+        // An audio callback overran its deadline.
+        DeadlineMiss,
+        // A track was created.
+        TrackCreated,
+        // The JUCE graph was rebuilt (by handleAsyncUpdate).
+        GraphRebuild,
+        // An analysis worker ran a batch of FFT jobs.
+        FftBurst,
+    };
+
+    // One of the slowest processors in a callback which missed its deadline.
+    struct TimelineNode
+    {
+        static const int MaxNameLength = 24;
+
+        // The processor's name, truncated to fit and null-terminated.
+        char Name[MaxNameLength];
+
+        // How long the processor's processBlock took.
+        int64_t DurationNanoseconds;
+    };
+
+    // Something that happened, or took a while, on some thread.  Plain data, so it can be copied into and out of a
+    // TimelineRecorder without locks.
+    struct TimelineEvent
+    {
+        static const int MaxSlowNodes = 4;
+
+        // What happened.
+        TimelineEventKind Kind;
+
+        // What it happened to: the track ID of a TrackCreated, the number of sources run in an FftBurst; else 0.
+        int32_t Id;
+
+        // When it started, in TimingHistogram::Now() time, and how long it took.
+        int64_t StartNanoseconds;
+        int64_t DurationNanoseconds;
+
+        // For a DeadlineMiss: the Clock time (in samples) as the callback ended, and the callback's deadline.
+        int64_t SampleTime;
+        int64_t DeadlineNanoseconds;
+
+        // For a DeadlineMiss: the slowest processors in the callback, slowest first.
+        int32_t SlowNodeCount;
+        TimelineNode SlowNodes[MaxSlowNodes];
+
+        static TimelineEvent Create(
+            TimelineEventKind kind,
+            int32_t id,
+            int64_t startNanoseconds,
+            int64_t durationNanoseconds)
+        {
+            TimelineEvent event{};
+            event.Kind = kind;
+            event.Id = id;
+            event.StartNanoseconds = startNanoseconds;
+            event.DurationNanoseconds = durationNanoseconds;
+            return event;
+        }
+
+        // Note that the named processor took the given time, keeping it if it is among the MaxSlowNodes slowest
+        // noted so far.  Does not allocate; fine on the audio thread.
+        void AddSlowNode(const char* name, int64_t durationNanoseconds)
+        {
+            int index = SlowNodeCount;
+            while (index > 0 && SlowNodes[index - 1].DurationNanoseconds < durationNanoseconds)
+            {
+                index--;
+            }
+            if (index == MaxSlowNodes)
+            {
+                return;
+            }
+
+            int last = SlowNodeCount < MaxSlowNodes ? SlowNodeCount : MaxSlowNodes - 1;
+            for (int i = last; i > index; i--)
+            {
+                SlowNodes[i] = SlowNodes[i - 1];
+            }
+            if (SlowNodeCount < MaxSlowNodes)
+            {
+                SlowNodeCount++;
+            }
+
+            TimelineNode& node = SlowNodes[index];
+            int length = 0;
+            while (length < TimelineNode::MaxNameLength - 1 && name[length] != 0)
+            {
+                node.Name[length] = name[length];
+                length++;
+            }
+            node.Name[length] = 0;
+            node.DurationNanoseconds = durationNanoseconds;
+        }
+    };
+
+    // A fixed-size ring of the most recent TimelineEvents, recorded from any threads (the audio thread included)
+    // without locks or allocation, and exported as Chrome trace-event JSON for viewing in chrome://tracing or
+    // Perfetto.
+    //
+    // Each slot is a seqlock: a writer claims the next slot with one atomic increment, marks it busy, stores the
+    // event a word at a time, and then stamps the slot with its sequence number.  Readers keep only slots whose stamp
+    // is what they expected both before and after copying, so an event being overwritten is skipped rather than
+    // torn.  When the ring is full the oldest events are overwritten.
+    class TimelineRecorder
+    {
+    private:
+        static const int WordCount = (sizeof(TimelineEvent) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        static_assert(std::is_trivially_copyable<TimelineEvent>::value, "TimelineEvent must be plain data");
+
+        struct Slot
+        {
+            // The sequence number of the event in this slot; -1 if none, or while it is being written.
+            std::atomic<int64_t> Sequence;
+
+            // The event, as words.
+            std::atomic<uint64_t> Words[WordCount];
+        };
+
+        // The number of slots; a power of two.
+        const int _capacity;
+
+        // The slots.
+        std::unique_ptr<Slot[]> _slots;
+
+        // The number of events ever recorded.
+        std::atomic<int64_t> _recordedCount;
+
+        // TimingHistogram::Now() at construction; exported timestamps are relative to this.
+        const int64_t _originNanoseconds;
+
+    public:
+        // capacity must be a power of two.
+        TimelineRecorder(int capacity)
+            : _capacity{ capacity },
+            _slots{ new Slot[capacity] },
+            _recordedCount{ 0 },
+            _originNanoseconds{ TimingHistogram::Now() }
+        {
+            Check(capacity > 0 && (capacity & (capacity - 1)) == 0);
+            for (int i = 0; i < capacity; i++)
+            {
+                _slots[i].Sequence.store(-1, std::memory_order_relaxed);
+            }
+        }
+
+        TimelineRecorder(const TimelineRecorder&) = delete;
+        TimelineRecorder& operator=(const TimelineRecorder&) = delete;
+
+        // The number of slots.
+        int Capacity() const { return _capacity; }
+
+        // The number of events ever recorded, including any since overwritten.
+        int64_t RecordedCount() const { return _recordedCount.load(std::memory_order_acquire); }
+
+        // TimingHistogram::Now() when this recorder was created; exported timestamps count from here.
+        int64_t OriginNanoseconds() const { return _originNanoseconds; }
+
+        // Record an event.  May be called from any thread.
+        void Record(const TimelineEvent& event)
+        {
+            uint64_t words[WordCount] = {};
+            std::memcpy(words, &event, sizeof(TimelineEvent));
+
+            int64_t sequence = _recordedCount.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = _slots[sequence & (_capacity - 1)];
+
+            slot.Sequence.store(-1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (int i = 0; i < WordCount; i++)
+            {
+                slot.Words[i].store(words[i], std::memory_order_relaxed);
+            }
+            slot.Sequence.store(sequence, std::memory_order_release);
+        }
+
+        // Copy the events still in the ring into events, oldest first, replacing its contents.  May be called from
+        // any thread; allocates, so not from the audio thread.
+        void Snapshot(std::vector<TimelineEvent>& events) const
+        {
+            events.clear();
+
+            int64_t end = RecordedCount();
+            int64_t begin = end > _capacity ? end - _capacity : 0;
+            for (int64_t sequence = begin; sequence < end; sequence++)
+            {
+                const Slot& slot = _slots[sequence & (_capacity - 1)];
+                if (slot.Sequence.load(std::memory_order_acquire) != sequence)
+                {
+                    // still being written, or already overwritten
+                    continue;
+                }
+
+                uint64_t words[WordCount];
+                for (int i = 0; i < WordCount; i++)
+                {
+                    words[i] = slot.Words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.Sequence.load(std::memory_order_relaxed) != sequence)
+                {
+                    continue;
+                }
+
+                TimelineEvent event;
+                std::memcpy(&event, words, sizeof(TimelineEvent));
+                events.push_back(event);
+            }
+        }
+
+        // The name an event kind is exported under.
+        static const char* KindName(TimelineEventKind kind)
+        {
+            switch (kind)
+            {
+            case TimelineEventKind::DeadlineMiss: return "DeadlineMiss";
+            case TimelineEventKind::TrackCreated: return "TrackCreated";
+            case TimelineEventKind::GraphRebuild: return "GraphRebuild";
+            case TimelineEventKind::FftBurst: return "FftBurst";
+            default: return "Unknown";
+            }
+        }
+
+        // Write the events still in the ring as a Chrome trace-event JSON object.  Each kind of event is shown on
+        // the thread that records it: deadline misses on "Audio", track creation and graph rebuilds on "Message",
+        // FFT bursts on "Analysis".
+        void WriteChromeTrace(std::ostream& out) const
+        {
+            std::vector<TimelineEvent> events;
+            Snapshot(events);
+
+            const char* threadNames[] = { "Audio", "Message", "Analysis" };
+
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            for (int i = 0; i < 3; i++)
+            {
+                out << (i == 0 ? "" : ",")
+                    << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (i + 1)
+                    << ",\"args\":{\"name\":\"" << threadNames[i] << "\"}}";
+            }
+
+            for (const TimelineEvent& event : events)
+            {
+                int threadId = event.Kind == TimelineEventKind::DeadlineMiss ? 1
+                    : event.Kind == TimelineEventKind::FftBurst ? 3
+                    : 2;
+
+                out << ",\n{\"name\":\"" << KindName(event.Kind) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId
+                    << ",\"ts\":";
+                WriteMicroseconds(out, event.StartNanoseconds - _originNanoseconds);
+                out << ",\"dur\":";
+                WriteMicroseconds(out, event.DurationNanoseconds);
+                out << ",\"args\":{\"id\":" << event.Id;
+
+                if (event.Kind == TimelineEventKind::DeadlineMiss)
+                {
+                    out << ",\"sampleTime\":" << event.SampleTime
+                        << ",\"deadlineMicroseconds\":";
+                    WriteMicroseconds(out, event.DeadlineNanoseconds);
+                    out << ",\"slowestNodes\":[";
+                    for (int i = 0; i < event.SlowNodeCount; i++)
+                    {
+                        out << (i == 0 ? "" : ",") << "{\"name\":\"";
+                        WriteJsonStringContents(out, event.SlowNodes[i].Name);
+                        out << "\",\"microseconds\":";
+                        WriteMicroseconds(out, event.SlowNodes[i].DurationNanoseconds);
+                        out << "}";
+                    }
+                    out << "]";
+                }
+
+                out << "}}";
+            }
+            out << "\n]}\n";
+        }
+
+    private:
+        // Write a time in nanoseconds as microseconds, exactly: the whole microseconds, then (if any) the nanoseconds
+        // as three decimal places.  Going through a double and the stream's default six significant digits would
+        // blur timestamps to whole milliseconds a couple of minutes into a session.
+        static void WriteMicroseconds(std::ostream& out, int64_t nanoseconds)
+        {
+            if (nanoseconds < 0)
+            {
+                out << '-';
+                nanoseconds = -nanoseconds;
+            }
+            out << nanoseconds / 1000;
+            int fraction = (int)(nanoseconds % 1000);
+            if (fraction != 0)
+            {
+                out << '.' << (char)('0' + fraction / 100) << (char)('0' + fraction / 10 % 10) << (char)('0' + fraction % 10);
+            }
+        }
+
+        // Write str as the contents of a JSON string (without the quotes).
+        static void WriteJsonStringContents(std::ostream& out, const char* str)
+        {
+            for (; *str != 0; str++)
+            {
+                unsigned char c = (unsigned char)*str;
+                if (c == '"' || c == '\\')
+                {
+                    out << '\\' << (char)c;
+                }
+                else if (c < 0x20 || c >= 0x80)
+                {
+                    out << '?';
+                }
+                else
+                {
+                    out << (char)c;
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,195 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Check.h"
+#include "Platform.h"
+
+namespace NowSound
+{
+    // A summary of the durations in a TimingHistogram, in nanoseconds.
+    struct TimingSummary
+    {
+        // The number of durations recorded.
+        int64_t Count;
+
+        // The mean duration; exact.
+        double MeanNanoseconds;
+
+        // The 99th percentile duration, to within the histogram's resolution (and never more than the max).
+        int64_t P99Nanoseconds;
+
+        // The longest duration; exact.
+        int64_t MaxNanoseconds;
+    };
+
+    // A histogram of durations, recorded by one thread (typically the audio thread) and summarized by any other,
+    // without locks.
+    //
+    // Durations fall into log-scale buckets, eight per power of two, so percentiles are accurate to 12.5%; the
+    // count, total and max are exact.  All storage is inline and recording is a handful of relaxed atomic stores,
+    // so recording is cheap and never allocates or blocks.  A summary taken while durations are being recorded may
+    // straddle a recording (a bucket may already count a duration that the total does not yet include), which is
+    // harmless for a profile.
+    class TimingHistogram
+    {
+    public:
+        // Bucket resolution: 2^SubBucketBits buckets per power of two.
+        static const int SubBucketBits = 3;
+        static const int SubBucketCount = 1 << SubBucketBits;
+
+        // The largest bucket shift; durations past 2^(MaxShift + SubBucketBits + 1) ns (over two minutes) all land
+        // in the last bucket.
+        static const int MaxShift = 33;
+
+        static const int BucketCount = (MaxShift + 2) * SubBucketCount;
+
+        // The current time in nanoseconds, from a monotonic clock; the difference of two of these is a duration to
+        // Record().
+        static int64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // The bucket for a duration.  Below SubBucketCount ns each duration has its own bucket; above, each power of
+        // two is split into SubBucketCount equal buckets.
+        static int BucketIndex(int64_t nanoseconds)
+        {
+            if (nanoseconds < SubBucketCount)
+            {
+                return nanoseconds < 0 ? 0 : (int)nanoseconds;
+            }
+
+            int shift = Platform::HighestSetBit((uint64_t)nanoseconds) - SubBucketBits;
+            if (shift > MaxShift)
+            {
+                return BucketCount - 1;
+            }
+
+            int subBucket = (int)(nanoseconds >> shift) & (SubBucketCount - 1);
+            return (shift + 1) * SubBucketCount + subBucket;
+        }
+
+        // The longest duration in a bucket.
+        static int64_t BucketUpperBound(int bucketIndex)
+        {
+            Check(bucketIndex >= 0 && bucketIndex < BucketCount);
+
+            if (bucketIndex < SubBucketCount)
+            {
+                return bucketIndex;
+            }
+
+            int shift = bucketIndex / SubBucketCount - 1;
+            int64_t subBucket = bucketIndex % SubBucketCount;
+            return ((SubBucketCount + subBucket) << shift) + ((int64_t)1 << shift) - 1;
+        }
+
+    private:
+        // The number of durations in each bucket.
+        std::atomic<uint32_t> _buckets[BucketCount];
+
+        // The number, total and maximum of all durations.
+        std::atomic<int64_t> _count;
+        std::atomic<int64_t> _totalNanoseconds;
+        std::atomic<int64_t> _maxNanoseconds;
+
+        // Set by Reset(); the recording thread clears everything before its next Record().
+        std::atomic<bool> _resetRequested;
+
+    public:
+        TimingHistogram() : _count{ 0 }, _totalNanoseconds{ 0 }, _maxNanoseconds{ 0 }, _resetRequested{ false }
+        {
+            for (std::atomic<uint32_t>& bucket : _buckets)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // Record a duration.  Only ever call this from one thread at a time.
+        void Record(int64_t nanoseconds)
+        {
+            if (_resetRequested.load(std::memory_order_acquire))
+            {
+                for (std::atomic<uint32_t>& bucket : _buckets)
+                {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+                _count.store(0, std::memory_order_relaxed);
+                _totalNanoseconds.store(0, std::memory_order_relaxed);
+                _maxNanoseconds.store(0, std::memory_order_relaxed);
+                _resetRequested.store(false, std::memory_order_release);
+            }
+
+            // only this thread writes, so plain load-and-store suffices; no read-modify-write needed
+            std::atomic<uint32_t>& bucket = _buckets[BucketIndex(nanoseconds)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            _totalNanoseconds.store(_totalNanoseconds.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+            if (nanoseconds > _maxNanoseconds.load(std::memory_order_relaxed))
+            {
+                _maxNanoseconds.store(nanoseconds, std::memory_order_relaxed);
+            }
+            _count.store(_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Forget all durations recorded so far.  May be called from any thread; takes effect at the next Record().
+        void Reset()
+        {
+            _resetRequested.store(true, std::memory_order_release);
+        }
+
+        // Summarize the durations recorded so far (all zero if none, or if a Reset() is pending).
+        // May be called from any thread.
+        TimingSummary Summarize() const
+        {
+            TimingSummary summary{ 0, 0, 0, 0 };
+            if (_resetRequested.load(std::memory_order_acquire))
+            {
+                return summary;
+            }
+
+            // Take the buckets first and derive the count from them, so the percentile is over exactly the
+            // durations we saw.
+            uint32_t buckets[BucketCount];
+            int64_t bucketTotal = 0;
+            for (int i = 0; i < BucketCount; i++)
+            {
+                buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+                bucketTotal += buckets[i];
+            }
+            if (bucketTotal == 0)
+            {
+                return summary;
+            }
+
+            int64_t count = _count.load(std::memory_order_acquire);
+            summary.Count = bucketTotal;
+            summary.MeanNanoseconds = count == 0 ? 0 : (double)_totalNanoseconds.load(std::memory_order_relaxed) / count;
+            summary.MaxNanoseconds = _maxNanoseconds.load(std::memory_order_relaxed);
+
+            // nearest rank
+            int64_t rank = (bucketTotal * 99 + 99) / 100;
+            int64_t seen = 0;
+            for (int i = 0; i < BucketCount; i++)
+            {
+                seen += buckets[i];
+                if (seen >= rank)
+                {
+                    int64_t upperBound = BucketUpperBound(i);
+                    summary.P99Nanoseconds = upperBound < summary.MaxNanoseconds ? upperBound : summary.MaxNanoseconds;
+                    break;
+                }
+            }
+
+            return summary;
+        }
+    };
+}
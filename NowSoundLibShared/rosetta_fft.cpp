@@ -146,9 +146,10 @@ namespace RosettaFFT
         results[results.size() - 1] = FrequencyBinBounds(final.LowerBound, fftBinCount / 2);
     }
 
-    void RescaleFFT(const vector<FrequencyBinBounds>& bounds, const CArray& fftData, float* outputVector, int outputCapacity)
+    void RescaleFFT(const vector<FrequencyBinBounds>& bounds, const float* fftMagnitudes, int fftMagnitudeCount, float* outputVector, int outputCapacity)
     {
         NowSound::Check(bounds.size() == outputCapacity);
+        NowSound::Check(std::ceil(bounds[bounds.size() - 1].UpperBound) < fftMagnitudeCount);
 
         for (int i = 0; i < bounds.size(); i++)
         {
@@ -166,7 +167,7 @@ namespace RosettaFFT
 
             if (i > 0)
             {
-                double value = abs(fftData[lowerBoundFloor]);
+                double value = fftMagnitudes[lowerBoundFloor];
 
                 if (lowerBoundFloor == upperBoundFloor)
                 {
@@ -190,7 +191,7 @@ namespace RosettaFFT
             // now add in all full buckets up to upperBoundFloor
             for (int j = lowerBoundFloor; j < upperBoundFloor; j++)
             {
-                double value = abs(fftData[j]);
+                double value = fftMagnitudes[j];
                 count += 1;
                 total += value;
 
@@ -200,7 +201,7 @@ namespace RosettaFFT
             // finally, add in the fractional part of upperBound, if any
             if (upperBoundFraction > 0)
             {
-                double value = abs(fftData[upperBoundFloor]);
+                double value = fftMagnitudes[upperBoundFloor];
                 count += upperBoundFraction;
                 total += value * upperBoundFraction;
 
@@ -212,4 +213,100 @@ namespace RosettaFFT
             // wcout << L"outputVector[" << i << L"] = " << outputVector[i] << endl;
         }
     }
-}
\ No newline at end of file
+
+    const float BinMappingMatrix::MinimumDecibels = -120;
+
+    BinMappingMatrix::BinMappingMatrix()
+        : _inputCount{ 0 },
+        _rowStarts{ 0 },
+        _columns{},
+        _weights{}
+    {
+    }
+
+    BinMappingMatrix::BinMappingMatrix(const vector<FrequencyBinBounds>& bounds, int fftMagnitudeCount)
+        : _inputCount{ fftMagnitudeCount },
+        _rowStarts{ 0 },
+        _columns{},
+        _weights{}
+    {
+        NowSound::Check(bounds.size() > 0);
+        NowSound::Check(std::ceil(bounds[bounds.size() - 1].UpperBound) < fftMagnitudeCount);
+
+        // This walks the bounds exactly as RescaleFFT does, but records each magnitude's weight rather than using it.
+        for (size_t i = 0; i < bounds.size(); i++)
+        {
+            size_t rowStart = _weights.size();
+            double count = 0;
+
+            double lowerBound = bounds[i].LowerBound;
+            int lowerBoundFloor = (int)std::floor(lowerBound);
+            double lowerBoundFraction = lowerBound - lowerBoundFloor;
+            double upperBound = bounds[i].UpperBound;
+            int upperBoundFloor = (int)std::floor(upperBound);
+            double upperBoundFraction = upperBound - upperBoundFloor;
+
+            if (i > 0)
+            {
+                if (lowerBoundFloor == upperBoundFloor)
+                {
+                    count = upperBoundFraction - lowerBoundFraction;
+                    _columns.push_back(lowerBoundFloor);
+                    _weights.push_back((float)count);
+                    upperBoundFraction = 0;
+                }
+                else
+                {
+                    count += (1 - lowerBoundFraction);
+                    _columns.push_back(lowerBoundFloor);
+                    _weights.push_back((float)(1 - lowerBoundFraction));
+                    lowerBoundFloor++;
+                }
+            }
+
+            for (int j = lowerBoundFloor; j < upperBoundFloor; j++)
+            {
+                count += 1;
+                _columns.push_back(j);
+                _weights.push_back(1);
+            }
+
+            if (upperBoundFraction > 0)
+            {
+                count += upperBoundFraction;
+                _columns.push_back(upperBoundFloor);
+                _weights.push_back((float)upperBoundFraction);
+            }
+
+            // normalize, so applying the row yields the average directly
+            for (size_t w = rowStart; w < _weights.size(); w++)
+            {
+                _weights[w] = (float)(_weights[w] / count);
+            }
+
+            _rowStarts.push_back((int)_weights.size());
+        }
+    }
+
+    void BinMappingMatrix::Apply(const float* fftMagnitudes, float* outputVector, int outputCapacity, BinScale scale) const
+    {
+        NowSound::Check(outputCapacity == OutputCount());
+
+        for (int i = 0; i < outputCapacity; i++)
+        {
+            float total = 0;
+            for (int w = _rowStarts[i]; w < _rowStarts[i + 1]; w++)
+            {
+                total += _weights[w] * fftMagnitudes[_columns[w]];
+            }
+
+            if (scale == BinScale::Decibels)
+            {
+                float decibels = total > 0 ? 20 * std::log10(total) : MinimumDecibels;
+                total = decibels > MinimumDecibels ? decibels : MinimumDecibels;
+            }
+
+            outputVector[i] = total;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+#pragma once
+
+#include <complex>
+#include <iostream>
+#include <valarray>
+#include <vector>
+
+namespace RosettaFFT
+{
+    // C++ FFT code from http://rosettacode.org/wiki/Fast_Fourier_transform#C.2B.2B
+
+    const double PI = std::atan(1) * 4;
+
+    typedef std::complex<double> Complex;
+    typedef std::valarray<Complex> CArray;
+
+    void simple_fft(CArray& x);
+    void optimized_fft(CArray& x);
+
+    // Subsequent methods are not from rosettacode.
+
+    void CreateBlackmanHarrisWindow(int fftSize, double* data);
+
+    // The bounds of a particular output bin returned from the RescaleFFT method.
+    struct FrequencyBinBounds
+    {
+        double LowerBound;
+        double UpperBound;
+        FrequencyBinBounds() : LowerBound{}, UpperBound{} { }
+        FrequencyBinBounds(double l, double u) : LowerBound{ l }, UpperBound{ u } { }
+    };
+
+    // Return a vector of [lower, upper] bounds, in terms of indices into an FFT result array.
+    // This can be precalculated and reused for rescaling each new FFT.
+    void MakeBinBounds(
+        // The vector into which to place results (having more difficulty with && references here than expected...).
+        std::vector<FrequencyBinBounds>& results,
+        // The frequency on which this whole histogram is based.
+        double centralFrequency,
+        // The number of divisions to make in each octave.
+        // Preferably a factor of 12.
+        int octaveDivisions,
+        // The number of bins in the returned distribution.
+        size_t binCount,
+        // The index in the returned distribution of the bin centered on centralFrequency.
+        int centralBinIndex,
+        // The sample rate at which the FFT data was taken.
+        double sampleRate,
+        // The number of FFT bins in the FFT data.
+        int fftBinCount);
+
+    // Given a precalculated vector of FrequencyBinBounds and the magnitudes of some FFT bins, populate the output
+    // vector from the magnitudes according to the bounds.
+    // The output vector must be the same length as the bounds vector.
+    void RescaleFFT(const std::vector<FrequencyBinBounds>& bounds, const float* fftMagnitudes, int fftMagnitudeCount, float* outputVector, int outputCapacity);
+
+    // How BinMappingMatrix::Apply scales its output.
+    enum class BinScale
+    {
+        // Plain averaged magnitudes, as RescaleFFT produces.
+        Linear,
+        // 20 * log10 of the averaged magnitudes, floored at MinimumDecibels.
+        Decibels
+    };
+
+    // RescaleFFT's rescaling, compiled once into a sparse matrix.
+    //
+    // Each output bin is a weighted average of a few FFT magnitudes, and the weights depend only on the bin bounds,
+    // which never change once the graph is initialized.  So we work out every (FFT bin, weight) pair up front and
+    // store them in compressed sparse row form; applying the matrix is then one multiply-add per nonzero weight,
+    // with no floors, fractions or divisions.  The matrix is immutable once built, so any number of frequency
+    // trackers can share one.
+    class BinMappingMatrix
+    {
+    private:
+        // The number of FFT magnitudes each input must have.
+        int _inputCount;
+
+        // Row i's weights are _columns/_weights[_rowStarts[i] .. _rowStarts[i + 1]).
+        std::vector<int> _rowStarts;
+
+        // The FFT bin index of each nonzero weight.
+        std::vector<int> _columns;
+
+        // The nonzero weights, already divided by their row's total weight.
+        std::vector<float> _weights;
+
+    public:
+        // The floor applied to BinScale::Decibels output, so silence doesn't come out as -infinity.
+        static const float MinimumDecibels;
+
+        // An empty matrix, for graphs with no FFT.
+        BinMappingMatrix();
+
+        // Compile the given bounds, to be applied to fftMagnitudeCount magnitudes.
+        BinMappingMatrix(const std::vector<FrequencyBinBounds>& bounds, int fftMagnitudeCount);
+
+        // The number of output bins.
+        int OutputCount() const { return (int)_rowStarts.size() - 1; }
+
+        // The number of FFT magnitudes each input must have.
+        int InputCount() const { return _inputCount; }
+
+        // The number of nonzero weights.
+        int WeightCount() const { return (int)_weights.size(); }
+
+        // Map fftMagnitudes (InputCount() long) into outputVector (OutputCount() long).
+        void Apply(const float* fftMagnitudes, float* outputVector, int outputCapacity, BinScale scale = BinScale::Linear) const;
+    };
+}
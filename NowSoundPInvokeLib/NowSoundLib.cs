@@ -229,6 +229,50 @@ namespace NowSoundLib
         public readonly Int32 DryWet_0_100;
     }
 
+    // The kinds of audio processor whose timings GetProcessorTimings reports.
+    public enum NowSoundProcessorKind
+    {
+        ProcessorUndefined,
+        // An audio input, including its panning and volume; the Id is its AudioInputId.
+        ProcessorInput,
+        // The metering of an audio input's post-effects signal; the Id is its AudioInputId.
+        ProcessorInputMeasurement,
+        // A track, including its panning and volume; the Id is its TrackId.
+        ProcessorTrack,
+        // The metering of a track's post-effects signal; the Id is its TrackId.
+        ProcessorTrackMeasurement,
+        // The loop bank; its times include those of all the tracks (and track measurements) it renders.
+        ProcessorLoopBank,
+        // The metering of the final output mix.
+        ProcessorOutputMix,
+    }
+
+    // How long one audio processor's processBlock calls have taken.
+    // This marshalable struct corresponds to the C++ P/Invokable type.
+    public struct NowSoundProcessorTimingInfo
+    {
+        public readonly Int64 BlockCount;
+        public readonly NowSoundProcessorKind Kind;
+        public readonly Int32 Id;
+        public readonly float MeanMicroseconds;
+        public readonly float P99Microseconds;
+        public readonly float MaxMicroseconds;
+    }
+
+    // How long the whole audio callbacks have taken, and their load against their deadline.
+    // This marshalable struct corresponds to the C++ P/Invokable type.
+    public struct NowSoundCallbackTimingInfo
+    {
+        public readonly Int64 CallbackCount;
+        public readonly Int32 ProcessorCount;
+        public readonly float DeadlineMicroseconds;
+        public readonly float MeanMicroseconds;
+        public readonly float P99Microseconds;
+        public readonly float MaxMicroseconds;
+        public readonly float CpuLoad;
+        public readonly Int64 DeadlineMissCount;
+    }
+
     public class Id
     {
         public static void Check(int id)
@@ -313,6 +357,33 @@ namespace NowSoundLib
             return NowSoundGraph_State();
         }
 
+        [DllImport("NowSoundLib")]
+        static extern void NowSoundGraph_SetAudioBufferArenaCount(int audioBufferArenaCount);
+
+        /// <summary>
+        /// Back the first audioBufferArenaCount audio buffers with a single locked, prefaulted memory arena, so
+        /// that recording into them never page faults; 0 turns the arena off, as it is by default.
+        /// Graph must be Uninitialized; applies to every graph initialized afterwards.
+        /// </summary>
+        public static void SetAudioBufferArenaCount(int audioBufferArenaCount)
+        {
+            Contract.Requires(audioBufferArenaCount >= 0);
+
+            NowSoundGraph_SetAudioBufferArenaCount(audioBufferArenaCount);
+        }
+
+        [DllImport("NowSoundLib")]
+        static extern void NowSoundGraph_SetUseLoopBank(bool useLoopBank);
+
+        /// <summary>
+        /// Render all tracks without plugins in a single loop bank node, rather than two nodes per track;
+        /// off by default.  Graph must be Uninitialized; applies to every graph initialized afterwards.
+        /// </summary>
+        public static void SetUseLoopBank(bool useLoopBank)
+        {
+            NowSoundGraph_SetUseLoopBank(useLoopBank);
+        }
+
         [DllImport("NowSoundLib")]
         static extern void NowSoundGraph_InitializeInstance(
             int outputBinCount,
@@ -488,14 +559,14 @@ namespace NowSoundLib
         }
 
         [DllImport("NowSoundLib")]
-        static extern bool NowSoundGraph_GetInputFrequencies(AudioInputId audioInputId, float[] floatBuffer, int floatBufferCapacity);
+        static extern long NowSoundGraph_GetInputFrequencies(AudioInputId audioInputId, float[] floatBuffer, int floatBufferCapacity);
 
         // Get the current input frequency histogram; LPWSTR must actually reference a float buffer of the
         // same length as the outputBinCount argument passed to InitializeFFT, but must be typed as LPWSTR
         // and must have a capacity represented in two-byte wide characters (to match the P/Invoke style of
         // "pass in StringBuilder", known to work well).
-        // Returns true if there was enough data to update the buffer, or false if there was not.
-        public static bool GetInputFrequencies(AudioInputId audioInputId, float[] floatBuffer, int floatBufferCapacity)
+        // Returns the audio sample time at which the histogram's audio ended (0 if there is no histogram yet).
+        public static long GetInputFrequencies(AudioInputId audioInputId, float[] floatBuffer, int floatBufferCapacity)
         {
             Id.Check(audioInputId);
 
@@ -540,6 +611,49 @@ namespace NowSoundLib
             NowSoundGraph_StopRecording();
         }
 
+        [DllImport("NowSoundLib")]
+        static extern NowSoundCallbackTimingInfo NowSoundGraph_GetProcessorTimings(
+            [Out] NowSoundProcessorTimingInfo[] processorTimingBuffer,
+            int processorTimingBufferCapacity);
+
+        /// <summary>
+        /// Get how long the audio callbacks, and each audio processor's part of them, have taken.
+        /// As many processors' timings as fit are written into processorTimings; the result's ProcessorCount
+        /// says how many processors there are.
+        /// Graph must be Running.
+        /// </summary>
+        public static NowSoundCallbackTimingInfo GetProcessorTimings(NowSoundProcessorTimingInfo[] processorTimings)
+        {
+            return NowSoundGraph_GetProcessorTimings(processorTimings, processorTimings.Length);
+        }
+
+        [DllImport("NowSoundLib")]
+        static extern void NowSoundGraph_ResetProcessorTimings();
+
+        /// <summary>
+        /// Forget all timings so far, so that GetProcessorTimings reports only what happens from now on.
+        /// Graph must be Running.
+        /// </summary>
+        public static void ResetProcessorTimings()
+        {
+            NowSoundGraph_ResetProcessorTimings();
+        }
+
+        [DllImport("NowSoundLib")]
+        static extern void NowSoundGraph_WriteTimeline([MarshalAs(UnmanagedType.LPWStr)] string fileName, int fileNameLength);
+
+        /// <summary>
+        /// Write the recent timeline (deadline misses with their slowest processors, track creations, graph
+        /// rebuilds and FFT bursts) to the given file, as Chrome trace-event JSON.
+        /// Graph must be Running.
+        /// </summary>
+        public static void WriteTimeline(string fileName)
+        {
+            Contract.Requires(!string.IsNullOrEmpty(fileName));
+
+            NowSoundGraph_WriteTimeline(fileName, fileName.Length);
+        }
+
         [DllImport("NowSoundLib")]
         static extern TrackId NowSoundGraph_CreateRecordingTrackAsync(AudioInputId id);
 
@@ -828,14 +942,14 @@ namespace NowSoundLib
         }
 
         [DllImport("NowSoundLib")]
-        static extern bool NowSoundTrack_GetFrequencies(TrackId trackId, float[] floatBuffer, int floatBufferCapacity);
+        static extern long NowSoundTrack_GetFrequencies(TrackId trackId, float[] floatBuffer, int floatBufferCapacity);
 
         // Get the current track frequency histogram; LPWSTR must actually reference a float buffer of the
         // same length as the outputBinCount argument passed to InitializeFFT, but must be typed as LPWSTR
         // and must have a capacity represented in two-byte wide characters (to match the P/Invoke style of
         // "pass in StringBuilder", known to work well).
-        // Returns true if there was enough data to update the buffer, or false if there was not.
-        public static bool GetFrequencies(TrackId trackId, float[] floatBuffer)
+        // Returns the audio sample time at which the histogram's audio ended (0 if there is no histogram yet).
+        public static long GetFrequencies(TrackId trackId, float[] floatBuffer)
         {
             Id.Check(trackId);
             Contract.Requires(floatBuffer != null);
@@ -0,0 +1,90 @@
+#pragma once
+
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+// The part of the Visual Studio C++ unit test framework which UnitTestsDesktop uses, for the portable (CMake)
+// build.  Only the CMake build puts this directory on the include path; Visual Studio builds get the real thing.
+//
+// TEST_CLASS and TEST_METHOD register each test method by name at static initialization time; TestMain.cpp runs
+// them.  A test fails by failing a Check(), which aborts the process, so each test is best run in its own process
+// (as the CMake build's ctest tests do).
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Microsoft
+{
+    namespace VisualStudio
+    {
+        namespace CppUnitTestFramework
+        {
+            // One registered test method.
+            struct TestMethodInfo
+            {
+                std::string MethodName;
+                std::function<void()> Run;
+            };
+
+            // Every registered test method, in registration (that is, declaration) order.
+            inline std::vector<TestMethodInfo>& RegisteredTestMethods()
+            {
+                static std::vector<TestMethodInfo> s_testMethods;
+                return s_testMethods;
+            }
+
+            // Registers a test method when constructed.
+            struct TestMethodRegistration
+            {
+                TestMethodRegistration(const char* methodName, std::function<void()>&& run)
+                {
+                    RegisteredTestMethods().push_back(TestMethodInfo{ methodName, std::move(run) });
+                }
+            };
+
+            // Base of every TEST_CLASS, recording the class type for TEST_METHOD.
+            template<typename TTestClass>
+            struct TestClass
+            {
+                typedef TTestClass ThisTestClass;
+            };
+
+            // Writes test output to stdout.
+            class Logger
+            {
+            public:
+                static void WriteMessage(const char* message)
+                {
+                    std::fputs(message, stdout);
+                }
+
+                // Test output is ASCII; anything else is written as '?'.
+                static void WriteMessage(const wchar_t* message)
+                {
+                    for (; *message != 0; message++)
+                    {
+                        std::fputc(*message < 128 ? (char)*message : '?', stdout);
+                    }
+                }
+            };
+        }
+    }
+}
+
+#define TEST_CLASS(className) \
+    class className : public ::Microsoft::VisualStudio::CppUnitTestFramework::TestClass<className>
+
+#define TEST_METHOD(methodName) \
+    struct methodName##_Registration \
+    { \
+        methodName##_Registration() \
+        { \
+            ::Microsoft::VisualStudio::CppUnitTestFramework::TestMethodRegistration( \
+                #methodName, \
+                []() { ThisTestClass testClass; testClass.methodName(); }); \
+        } \
+    }; \
+    static inline methodName##_Registration methodName##_registration{}; \
+    void methodName()
@@ -0,0 +1,72 @@
+// NowSound library by Rob Jellinghaus, https://github.com/RobJellinghaus/NowSound
+// Licensed under the MIT license
+
+// Runs the UnitTestsDesktop tests in the portable (CMake) build.
+//
+// Usage: UnitTestsDesktop [--list] [TestName ...]
+//   --list      print the name of every test, one per line
+//   TestName    run just the named tests; with none, run every test
+//
+// A failing test aborts the process, so the exit status is nonzero exactly when some test failed.
+
+#include <cstdio>
+#include <cstring>
+
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+int main(int argc, char** argv)
+{
+    std::vector<TestMethodInfo>& testMethods = RegisteredTestMethods();
+
+    if (argc == 2 && std::strcmp(argv[1], "--list") == 0)
+    {
+        for (const TestMethodInfo& testMethod : testMethods)
+        {
+            std::printf("%s\n", testMethod.MethodName.c_str());
+        }
+        return 0;
+    }
+
+    int runCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        bool found = false;
+        for (const TestMethodInfo& testMethod : testMethods)
+        {
+            if (testMethod.MethodName == argv[i])
+            {
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            std::fprintf(stderr, "No test named %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    for (const TestMethodInfo& testMethod : testMethods)
+    {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc && !selected; i++)
+        {
+            selected = testMethod.MethodName == argv[i];
+        }
+        if (!selected)
+        {
+            continue;
+        }
+
+        std::printf("Running %s\n", testMethod.MethodName.c_str());
+        std::fflush(stdout);
+        testMethod.Run();
+        std::printf("\nPassed %s\n", testMethod.MethodName.c_str());
+        std::fflush(stdout);
+        runCount++;
+    }
+
+    std::printf("%d tests passed\n", runCount);
+    return 0;
+}
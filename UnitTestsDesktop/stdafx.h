@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#ifdef _WIN32
+
 #include "ppltasks.h"
 #include "winrt/Windows.ApplicationModel.Core.h"
 #include "winrt/Windows.Foundation.h"
@@ -7,4 +9,23 @@
 #include "winrt/Windows.Storage.Pickers.h"
 #include "winrt/Windows.UI.Composition.h"
 #include "winrt/Windows.UI.Core.h"
-WINRT_WARNING_PUSH
\ No newline at end of file
+WINRT_WARNING_PUSH
+
+#else
+
+// The portable (CMake) build: just the standard headers the shared sources take for granted.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#endif
+
+#include "Platform.h"
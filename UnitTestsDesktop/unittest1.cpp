@@ -1,18 +1,121 @@
 #include "stdafx.h"
 #include "CppUnitTest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "AnalysisWorkerPool.h"
+#include "AudioKernels.h"
 #include "BufferAllocator.h"
 #include "Check.h"
+#include "Clock.h"
+#include "FftEngine.h"
 #include "Histogram.h"
+#include "LatencyRecorder.h"
+#include "MeteringSnapshot.h"
 #include "Slice.h"
 #include "SliceStream.h"
+#include "SmoothedParameter.h"
+#include "SpscQueue.h"
+#include "StftBuffer.h"
+#include "ThreadWorkCounters.h"
+#include "TimelineRecorder.h"
+#include "TimingHistogram.h"
 #include "NowSoundTime.h"
+#include "Platform.h"
+#include "RenderList.h"
+#include "rosetta_fft.h"
+#include "SignalGenerator.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace NowSound;
 
 namespace UnitTestsDesktop
 {        
+    // An AnalysisJobSource whose jobs just log which source ran them.
+    class FakeJobSource : public AnalysisJobSource
+    {
+    private:
+        const int _id;
+        const int _fftSize;
+        const std::chrono::steady_clock::time_point _lastPolled;
+        const std::atomic<bool>& _released;
+        std::mutex& _logMutex;
+        std::vector<int>& _log;
+        SpscQueue<int> _jobs;
+
+    public:
+        // How long each RunPendingJobs() call takes.
+        std::chrono::milliseconds RunDuration;
+
+        // Is RunPendingJobs() in progress?
+        std::atomic<bool> Running;
+
+        // Jobs only become visible to the pool once released is set, so a test can queue up several sources'
+        // jobs for the pool to find all at once.
+        FakeJobSource(
+            int id,
+            int fftSize,
+            std::chrono::steady_clock::time_point lastPolled,
+            const std::atomic<bool>& released,
+            std::mutex& logMutex,
+            std::vector<int>& log)
+            : _id{ id },
+            _fftSize{ fftSize },
+            _lastPolled{ lastPolled },
+            _released{ released },
+            _logMutex{ logMutex },
+            _log{ log },
+            _jobs{ 4 },
+            RunDuration{ 0 },
+            Running{ false }
+        {}
+
+        // Queue a job; producer thread only.
+        void Queue() { Check(_jobs.TryPush(_id)); }
+
+        virtual int FftSize() const override { return _fftSize; }
+        virtual std::chrono::steady_clock::time_point LastPolled() const override { return _lastPolled; }
+        virtual bool HasPendingJobs() const override { return _released && !_jobs.IsEmpty(); }
+
+        // Log our id for each job.
+        virtual void RunPendingJobs(FftEngine& engine) override
+        {
+            Check(engine.Size() == _fftSize);
+            Running = true;
+            std::this_thread::sleep_for(RunDuration);
+            int id;
+            while (_jobs.TryPop(id))
+            {
+                std::lock_guard<std::mutex> guard(_logMutex);
+                _log.push_back(id);
+            }
+            Running = false;
+        }
+
+        // Log our negated id for each job.
+        virtual void DiscardPendingJobs() override
+        {
+            int id;
+            while (_jobs.TryPop(id))
+            {
+                std::lock_guard<std::mutex> guard(_logMutex);
+                _log.push_back(-id);
+            }
+        }
+    };
+
     TEST_CLASS(NowSoundDesktopTests)
     {
     public:        
@@ -22,6 +125,63 @@ namespace UnitTestsDesktop
             Check(true);
         }
 
+        // Exported API strings are UTF-16 on every platform; check copying into and out of them.
+        static bool WideStringEquals(const Platform::WideChar* actual, const wchar_t* expected)
+        {
+            size_t i = 0;
+            for (; expected[i] != 0; i++)
+            {
+                if (actual[i] != (Platform::WideChar)expected[i])
+                {
+                    return false;
+                }
+            }
+            return actual[i] == 0;
+        }
+
+        TEST_METHOD(TestCopyWideString)
+        {
+            const wchar_t* source = L"abcdef";
+            Platform::WideChar dest[8];
+
+            // all of it fits
+            Platform::CopyWideString(dest, 8, source, 6);
+            Check(WideStringEquals(dest, L"abcdef"));
+
+            // only some of it is asked for
+            Platform::CopyWideString(dest, 8, source, 3);
+            Check(WideStringEquals(dest, L"abc"));
+
+            // not all of it fits; the terminating null always does
+            Platform::CopyWideString(dest, 4, source, 6);
+            Check(WideStringEquals(dest, L"abc"));
+
+            // a count past the end of the source stops at its null
+            Platform::CopyWideString(dest, 8, L"ab", 6);
+            Check(WideStringEquals(dest, L"ab"));
+
+            // no room at all leaves dest alone
+            dest[0] = L'x';
+            Platform::CopyWideString(dest, 0, source, 6);
+            Check(dest[0] == L'x');
+
+            // and back again, up to a count or a null
+            Platform::CopyWideString(dest, 8, source, 6);
+            Check(Platform::ToWideString(dest) == L"abcdef");
+            Check(Platform::ToWideString(dest, 2) == L"ab");
+
+            // characters outside the Basic Multilingual Plane are surrogate pairs in UTF-16, and are never split
+            const wchar_t* clef = L"a\U0001D11Eb";
+            Platform::CopyWideString(dest, 8, clef, std::wcslen(clef));
+            Check(Platform::ToWideString(dest) == clef);
+            if (sizeof(wchar_t) > sizeof(Platform::WideChar))
+            {
+                Check(dest[1] == 0xD834 && dest[2] == 0xDD1E);
+                Platform::CopyWideString(dest, 3, clef, std::wcslen(clef));
+                Check(WideStringEquals(dest, L"a"));
+            }
+        }
+
         TEST_METHOD(TestHistogram)
         {
             Histogram h(4);
@@ -55,15 +215,591 @@ namespace UnitTestsDesktop
             Check(h.Average() == -15);
         }
 
+        // Sliding-window min and max agree with brute force, and the average does not drift.
+        TEST_METHOD(TestHistogramSlidingWindow)
+        {
+            const int capacity = 7;
+            Histogram h(capacity);
+            std::vector<float> added;
+            uint32_t random = 12345;
+            for (int i = 0; i < 1000; i++)
+            {
+                // a cheap LCG, with small values so there are plenty of duplicates
+                random = random * 1664525 + 1013904223;
+                float value = (float)((random >> 16) % 21) - 10;
+                h.Add(value);
+                added.push_back(value);
+
+                size_t windowStart = added.size() > capacity ? added.size() - capacity : 0;
+                float min = added[windowStart], max = added[windowStart], total = 0;
+                for (size_t j = windowStart; j < added.size(); j++)
+                {
+                    min = std::min(min, added[j]);
+                    max = std::max(max, added[j]);
+                    total += added[j];
+                }
+                Check(h.Min() == min);
+                Check(h.Max() == max);
+                Check(h.Average() == total / (added.size() - windowStart));
+            }
+
+            // A long stretch of loud values, then quiet ones: with a float running total, the quiet average
+            // would be swamped by leftover rounding error from the loud stretch.
+            Histogram drift(1000);
+            for (int i = 0; i < 1000000; i++)
+            {
+                drift.Add(i % 2 == 0 ? 1000.1f : 0.3f);
+            }
+            for (int i = 0; i < 1000; i++)
+            {
+                drift.Add(0.001f);
+            }
+            Check(std::abs(drift.Average() - 0.001f) < 0.000001f);
+            Check(drift.Min() == 0.001f);
+            Check(drift.Max() == 0.001f);
+        }
+
+        // A BlockHistogram fed equal-sized blocks that divide its capacity matches a Histogram fed the same samples
+        // one at a time, for single blocks of absolute values and for stereo magnitudes.
+        TEST_METHOD(TestBlockHistogramEquivalence)
+        {
+            const int capacity = 256;
+            // odd sizes exercise the kernels' scalar tails
+            const int blockSizes[3] = { 32, 37, 64 };
+            for (int blockSize : blockSizes)
+            {
+                int sampleCapacity = capacity - capacity % blockSize;
+                Histogram perSample(sampleCapacity);
+                Histogram perSampleStereo(sampleCapacity);
+                BlockHistogram perBlock(sampleCapacity, 16);
+                BlockHistogram perBlockStereo(sampleCapacity, 16);
+
+                std::vector<float> left(blockSize), right(blockSize);
+                uint32_t random = 54321;
+                for (int b = 0; b < 100; b++)
+                {
+                    for (int i = 0; i < blockSize; i++)
+                    {
+                        random = random * 1664525 + 1013904223;
+                        left[i] = ((float)(random >> 8) / (1 << 24)) * 2 - 1;
+                        random = random * 1664525 + 1013904223;
+                        right[i] = ((float)(random >> 8) / (1 << 24)) * 2 - 1;
+                    }
+
+                    perSample.AddAll(left.data(), blockSize, /*absoluteValue:*/ true);
+                    perBlock.AddBlock(left.data(), blockSize, /*absoluteValue:*/ true);
+                    for (int i = 0; i < blockSize; i++)
+                    {
+                        perSampleStereo.Add(std::abs(left[i]) / 2 + std::abs(right[i]) / 2);
+                    }
+                    perBlockStereo.AddStereoMagnitudeBlock(left.data(), right.data(), blockSize);
+
+                    Check(perBlock.Min() == perSample.Min());
+                    Check(perBlock.Max() == perSample.Max());
+                    Check(std::abs(perBlock.Average() - perSample.Average()) < 0.00001f);
+                    Check(perBlockStereo.Min() == perSampleStereo.Min());
+                    Check(perBlockStereo.Max() == perSampleStereo.Max());
+                    Check(std::abs(perBlockStereo.Average() - perSampleStereo.Average()) < 0.00001f);
+                }
+            }
+        }
+
+        // Time metering half a second of 48Khz audio in 256-sample blocks, per sample and per block.
+        TEST_METHOD(BenchmarkBlockHistogram)
+        {
+            const int capacity = 24000;
+            const int blockSize = 256;
+            const int blockCount = 100000;
+            std::vector<float> block(blockSize);
+            for (int i = 0; i < blockSize; i++)
+            {
+                block[i] = (float)std::sin(i * 0.1);
+            }
+
+            Histogram perSample(capacity);
+            BlockHistogram perBlock(capacity, 1024);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int b = 0; b < blockCount; b++)
+            {
+                perSample.AddAll(block.data(), blockSize, /*absoluteValue:*/ true);
+            }
+            double perSampleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (int b = 0; b < blockCount; b++)
+            {
+                perBlock.AddBlock(block.data(), blockSize, /*absoluteValue:*/ true);
+            }
+            double perBlockSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            Check(perBlock.Max() == perSample.Max());
+
+            double megasamples = (double)blockCount * blockSize / 1000000;
+            std::wstringstream wstr;
+            wstr << L"BenchmarkBlockHistogram: Histogram::AddAll " << (megasamples / perSampleSeconds)
+                << L" Msamples/sec, BlockHistogram::AddBlock " << (megasamples / perBlockSeconds) << L" Msamples/sec" << std::endl;
+            Logger::WriteMessage(wstr.str().c_str());
+        }
+
         static const int FloatSliverCount = 2;
         static const int FloatNumSlices = 128;
 
         // Exercise minimal buffer allocation and free list reuse.
+        // Run a synthetic audio thread that meters a block and publishes a bin histogram every half millisecond,
+        // while several threads poll the histogram as fast as they can.  Publishing goes through a MeteringSnapshot,
+        // or (for comparison) a mutex which the pollers also take.  Returns the worst callback duration in
+        // microseconds; sets tornReadCount to the number of polls which saw parts of two different publications.
+        static double RunMeteringStress(bool useSnapshot, int& tornReadCount)
+        {
+            const int binCount = 64;
+            const int blockSize = 256;
+            const int callbackCount = 2000;
+            const int pollerCount = 3;
+
+            MeteringSnapshot snapshot(binCount);
+            std::mutex mutex;
+            float lockedBins[binCount] = {};
+            BlockHistogram histogram(24000, 1024);
+
+            std::atomic<bool> done{ false };
+            std::atomic<int> torn{ 0 };
+            std::vector<std::thread> pollers;
+            for (int p = 0; p < pollerCount; p++)
+            {
+                pollers.push_back(std::thread([&]()
+                {
+                    float bins[binCount];
+                    while (!done)
+                    {
+                        if (useSnapshot)
+                        {
+                            snapshot.Read(bins, binCount);
+                        }
+                        else
+                        {
+                            std::lock_guard<std::mutex> guard(mutex);
+                            std::copy(lockedBins, lockedBins + binCount, bins);
+                        }
+
+                        // every publication stamps all bins with the same value
+                        for (int i = 1; i < binCount; i++)
+                        {
+                            if (bins[i] != bins[0])
+                            {
+                                torn++;
+                                break;
+                            }
+                        }
+                    }
+                }));
+            }
+
+            std::vector<float> left(blockSize), right(blockSize);
+            for (int i = 0; i < blockSize; i++)
+            {
+                left[i] = (float)std::sin(i * 0.1);
+                right[i] = (float)std::cos(i * 0.1);
+            }
+
+            double worstMicroseconds = 0;
+            std::chrono::steady_clock::time_point nextCallback = std::chrono::steady_clock::now();
+            for (int c = 0; c < callbackCount; c++)
+            {
+                nextCallback += std::chrono::microseconds(500);
+                std::this_thread::sleep_until(nextCallback);
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                histogram.AddStereoMagnitudeBlock(left.data(), right.data(), blockSize);
+                float bins[binCount];
+                for (int i = 0; i < binCount; i++)
+                {
+                    bins[i] = (float)c + histogram.Max();
+                }
+                if (useSnapshot)
+                {
+                    snapshot.Publish(bins, binCount);
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    std::copy(bins, bins + binCount, lockedBins);
+                }
+                double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                worstMicroseconds = microseconds > worstMicroseconds ? microseconds : worstMicroseconds;
+            }
+
+            done = true;
+            for (std::thread& poller : pollers)
+            {
+                poller.join();
+            }
+
+            tornReadCount = torn;
+            return worstMicroseconds;
+        }
+
+        TEST_METHOD(TestMeteringSnapshotStress)
+        {
+            int tornReadCount;
+            double snapshotWorst = RunMeteringStress(/*useSnapshot:*/ true, tornReadCount);
+            Check(tornReadCount == 0);
+
+            double mutexWorst = RunMeteringStress(/*useSnapshot:*/ false, tornReadCount);
+            Check(tornReadCount == 0);
+
+            std::wstringstream wstr;
+            wstr << L"TestMeteringSnapshotStress: worst callback " << snapshotWorst << L" usec with snapshot, "
+                << mutexWorst << L" usec with mutex" << std::endl;
+            Logger::WriteMessage(wstr.str().c_str());
+        }
+
+        // The fast FFT engine must agree with the reference one, at every size we might plausibly use.
+        TEST_METHOD(TestFftEngineAccuracy)
+        {
+            for (int size = 4; size <= 8192; size *= 2)
+            {
+                RealFftEngine fast(size);
+                ReferenceFftEngine reference(size);
+                Check(fast.Size() == size && reference.Size() == size);
+
+                std::vector<float> input(size);
+                uint32_t random = 12345;
+                for (int i = 0; i < size; i++)
+                {
+                    random = random * 1664525 + 1013904223;
+                    // a loud sinusoid plus noise, so some bins are large and most are small
+                    input[i] = (float)std::sin(i * 0.37) + ((float)(random >> 8) / (1 << 24)) - 0.5f;
+                }
+
+                int binCount = size / 2 + 1;
+                std::vector<float> fastReal(binCount), fastImaginary(binCount), referenceReal(binCount), referenceImaginary(binCount);
+                fast.Transform(input.data(), fastReal.data(), fastImaginary.data());
+                reference.Transform(input.data(), referenceReal.data(), referenceImaginary.data());
+
+                float peak = 0;
+                float worstError = 0;
+                for (int k = 0; k < binCount; k++)
+                {
+                    float magnitude = std::sqrt(referenceReal[k] * referenceReal[k] + referenceImaginary[k] * referenceImaginary[k]);
+                    peak = magnitude > peak ? magnitude : peak;
+                    float error = std::abs(fastReal[k] - referenceReal[k]) + std::abs(fastImaginary[k] - referenceImaginary[k]);
+                    worstError = error > worstError ? error : worstError;
+                }
+                Check(worstError <= peak * 0.00001f);
+            }
+        }
+
+        // Time both FFT engines at the sizes the frequency trackers use.
+        TEST_METHOD(BenchmarkFftEngine)
+        {
+            const int sizes[2] = { 1024, 4096 };
+            for (int size : sizes)
+            {
+                RealFftEngine fast(size);
+                ReferenceFftEngine reference(size);
+                std::vector<float> input(size);
+                for (int i = 0; i < size; i++)
+                {
+                    input[i] = (float)std::sin(i * 0.37);
+                }
+                std::vector<float> real(size / 2 + 1), imaginary(size / 2 + 1);
+
+                const int transformCount = 4000000 / size;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int t = 0; t < transformCount; t++)
+                {
+                    reference.Transform(input.data(), real.data(), imaginary.data());
+                }
+                double referenceMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / transformCount;
+
+                start = std::chrono::steady_clock::now();
+                for (int t = 0; t < transformCount; t++)
+                {
+                    fast.Transform(input.data(), real.data(), imaginary.data());
+                }
+                double fastMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / transformCount;
+
+                std::wstringstream wstr;
+                wstr << L"BenchmarkFftEngine: size " << size << L": reference " << referenceMicroseconds << L" usec, fast "
+                    << fastMicroseconds << L" usec, speedup " << (referenceMicroseconds / fastMicroseconds) << L"x" << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+            }
+        }
+
+        // Make bin bounds like the ones NowSoundGraph makes: twenty bins per octave around A440.
+        static void MakeTestBinBounds(std::vector<RosettaFFT::FrequencyBinBounds>& bounds, int fftSize)
+        {
+            bounds.resize(200);
+            RosettaFFT::MakeBinBounds(bounds, 440, 20, bounds.size(), 100, 48000, fftSize);
+        }
+
+        // The compiled bin mapping must give the same results as RescaleFFT.
+        TEST_METHOD(TestBinMappingMatrix)
+        {
+            const int fftSize = 2048;
+            const int magnitudeCount = fftSize / 2 + 1;
+            std::vector<RosettaFFT::FrequencyBinBounds> bounds;
+            MakeTestBinBounds(bounds, fftSize);
+            RosettaFFT::BinMappingMatrix matrix(bounds, magnitudeCount);
+            Check(matrix.OutputCount() == (int)bounds.size());
+            Check(matrix.InputCount() == magnitudeCount);
+
+            std::vector<float> magnitudes(magnitudeCount);
+            uint32_t random = 777;
+            for (int i = 0; i < magnitudeCount; i++)
+            {
+                random = random * 1664525 + 1013904223;
+                magnitudes[i] = (float)(random >> 8) / (1 << 20);
+            }
+
+            std::vector<float> expected(bounds.size()), actual(bounds.size()), decibels(bounds.size());
+            RosettaFFT::RescaleFFT(bounds, magnitudes.data(), magnitudeCount, expected.data(), (int)bounds.size());
+            matrix.Apply(magnitudes.data(), actual.data(), (int)bounds.size());
+            matrix.Apply(magnitudes.data(), decibels.data(), (int)bounds.size(), RosettaFFT::BinScale::Decibels);
+            for (int i = 0; i < (int)bounds.size(); i++)
+            {
+                Check(std::abs(actual[i] - expected[i]) <= std::abs(expected[i]) * 0.0001f);
+                Check(std::abs(decibels[i] - 20 * std::log10(expected[i])) < 0.001f);
+            }
+
+            // silence bottoms out rather than going to -infinity
+            std::fill(magnitudes.begin(), magnitudes.end(), 0.0f);
+            matrix.Apply(magnitudes.data(), decibels.data(), (int)bounds.size(), RosettaFFT::BinScale::Decibels);
+            Check(decibels[0] == RosettaFFT::BinMappingMatrix::MinimumDecibels);
+        }
+
+        // Time RescaleFFT against the compiled bin mapping.
+        TEST_METHOD(BenchmarkBinMappingMatrix)
+        {
+            const int fftSize = 2048;
+            const int magnitudeCount = fftSize / 2 + 1;
+            std::vector<RosettaFFT::FrequencyBinBounds> bounds;
+            MakeTestBinBounds(bounds, fftSize);
+            RosettaFFT::BinMappingMatrix matrix(bounds, magnitudeCount);
+            std::vector<float> magnitudes(magnitudeCount, 1.0f);
+            std::vector<float> output(bounds.size());
+
+            const int iterationCount = 20000;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterationCount; i++)
+            {
+                RosettaFFT::RescaleFFT(bounds, magnitudes.data(), magnitudeCount, output.data(), (int)bounds.size());
+            }
+            double rescaleMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterationCount;
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterationCount; i++)
+            {
+                matrix.Apply(magnitudes.data(), output.data(), (int)bounds.size());
+            }
+            double matrixMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterationCount;
+
+            std::wstringstream wstr;
+            wstr << L"BenchmarkBinMappingMatrix: RescaleFFT " << rescaleMicroseconds << L" usec, BinMappingMatrix::Apply "
+                << matrixMicroseconds << L" usec (" << matrix.WeightCount() << L" weights)" << std::endl;
+            Logger::WriteMessage(wstr.str().c_str());
+        }
+
+        // Frames read from a StftBuffer are the windowed mono mix of the right samples, every frame is readable if the
+        // reader keeps up, and frames the writer has lapped are reported as lost.
+        TEST_METHOD(TestStftBuffer)
+        {
+            const int frameSize = 256;
+            const int hopSize = 64;
+            StftBuffer stft(frameSize, hopSize, 4);
+            Check(stft.Capacity() == 1024);
+
+            // the window of a frame of all ones, read back
+            std::vector<float> ones(frameSize, 1.0f), window(frameSize);
+            {
+                StftBuffer windowProbe(frameSize, hopSize, 4);
+                windowProbe.AppendStereo(ones.data(), ones.data(), frameSize);
+                Check(windowProbe.ReadWindowedFrame(frameSize, window.data()));
+            }
+
+            std::vector<float> left(100), right(100), mono, frame(frameSize);
+            uint32_t random = 4242;
+            int64_t nextFrameEnd = stft.FirstFrameEnd();
+            int framesRead = 0;
+            while (mono.size() < 20000)
+            {
+                random = random * 1664525 + 1013904223;
+                int count = 1 + (random >> 8) % 100;
+                for (int i = 0; i < count; i++)
+                {
+                    random = random * 1664525 + 1013904223;
+                    left[i] = (float)(random >> 8) / (1 << 24);
+                    right[i] = 1 - left[i] * 2;
+                    mono.push_back(left[i] / 2 + right[i] / 2);
+                }
+                stft.AppendStereo(left.data(), right.data(), count);
+                Check(stft.WritePosition() == (int64_t)mono.size());
+
+                while (stft.WritePosition() >= nextFrameEnd)
+                {
+                    Check(stft.ReadWindowedFrame(nextFrameEnd, frame.data()));
+                    for (int i = 0; i < frameSize; i++)
+                    {
+                        Check(frame[i] == mono[nextFrameEnd - frameSize + i] * window[i]);
+                    }
+                    nextFrameEnd += hopSize;
+                    framesRead++;
+                }
+            }
+            Check(framesRead == (int)((mono.size() - frameSize) / hopSize) + 1);
+            // not yet written
+            Check(!stft.ReadWindowedFrame(nextFrameEnd, frame.data()));
+
+            // lap the reader: the history holds 1024 samples, so after 5000, frames starting before 3976 are gone
+            StftBuffer lapped(frameSize, hopSize, 4);
+            std::vector<float> silence(5000, 0.0f);
+            lapped.AppendStereo(silence.data(), silence.data(), 5000);
+            Check(!lapped.ReadWindowedFrame(frameSize, frame.data()));
+            Check(lapped.EarliestReadableFrameEnd(lapped.WritePosition()) == 4288);
+            Check(lapped.ReadWindowedFrame(4288, frame.data()));
+            Check(!lapped.ReadWindowedFrame(4288 - hopSize, frame.data()));
+        }
+
+        // The window is scaled so that a sinusoid centered on an FFT bin shows the same peak as without a window.
+        TEST_METHOD(TestStftWindowGain)
+        {
+            const int frameSize = 1024;
+            StftBuffer stft(frameSize, frameSize / 4, 2);
+            std::vector<float> sine(frameSize);
+            for (int i = 0; i < frameSize; i++)
+            {
+                sine[i] = (float)std::sin(2 * RosettaFFT::PI * 32 * i / frameSize);
+            }
+            stft.AppendStereo(sine.data(), sine.data(), frameSize);
+
+            std::vector<float> frame(frameSize), real(frameSize / 2 + 1), imaginary(frameSize / 2 + 1), magnitudes(frameSize / 2 + 1);
+            Check(stft.ReadWindowedFrame(frameSize, frame.data()));
+            RealFftEngine engine(frameSize);
+            engine.Transform(frame.data(), real.data(), imaginary.data());
+            AudioKernels::Magnitude(real.data(), imaginary.data(), magnitudes.data(), frameSize / 2 + 1);
+
+            // an unwindowed unit sinusoid exactly on bin 32 has magnitude frameSize / 2 there
+            Check(std::abs(magnitudes[32] - frameSize / 2) < frameSize * 0.005f);
+            // and the window keeps leakage to distant bins tiny
+            Check(magnitudes[64] < frameSize * 0.0001f);
+        }
+
+        // One thread pushes a sequence through a small queue while another pops it; nothing is lost or reordered.
+        TEST_METHOD(TestSpscQueue)
+        {
+            const int itemCount = 200000;
+            SpscQueue<int> queue(16);
+            Check(queue.Capacity() == 16);
+            Check(queue.IsEmpty());
+
+            int item = -1;
+            Check(!queue.TryPop(item));
+            Check(item == -1);
+            for (int i = 0; i < 16; i++)
+            {
+                Check(queue.TryPush(i));
+            }
+            Check(!queue.TryPush(16));
+            for (int i = 0; i < 16; i++)
+            {
+                Check(queue.TryPop(item));
+                Check(item == i);
+            }
+            Check(queue.IsEmpty());
+
+            std::thread producer([&queue]()
+            {
+                for (int i = 0; i < itemCount; i++)
+                {
+                    while (!queue.TryPush(i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            for (int expected = 0; expected < itemCount; expected++)
+            {
+                while (!queue.TryPop(item))
+                {
+                    std::this_thread::yield();
+                }
+                Check(item == expected);
+            }
+            producer.join();
+            Check(queue.IsEmpty());
+        }
+
+        // The pool runs sources grouped by FFT size, most recently polled first, discards the jobs of sources
+        // nobody has polled lately, and Unregister waits out a running job.
+        TEST_METHOD(TestAnalysisWorkerPool)
+        {
+            using namespace std::chrono;
+
+            std::atomic<bool> released{ false };
+            std::mutex logMutex;
+            std::vector<int> log;
+
+            steady_clock::time_point now = steady_clock::now();
+            // ids 1 and 3 share one size, 2 and 4 another; 5 has not been polled for a minute
+            FakeJobSource source1(1, 256, now, released, logMutex, log);
+            FakeJobSource source2(2, 512, now - milliseconds(1), released, logMutex, log);
+            FakeJobSource source3(3, 256, now - milliseconds(2), released, logMutex, log);
+            FakeJobSource source4(4, 512, now - milliseconds(3), released, logMutex, log);
+            FakeJobSource source5(5, 256, now - seconds(60), released, logMutex, log);
+            FakeJobSource* sources[] = { &source4, &source2, &source5, &source3, &source1 };
+
+            {
+                // a single worker, so the whole ordering is observable
+                AnalysisWorkerPool pool(1, microseconds(1000), milliseconds(10000));
+                for (FakeJobSource* source : sources)
+                {
+                    pool.Register(source);
+                    source->Queue();
+                }
+                released = true;
+
+                while (pool.RunCount() + pool.DiscardCount() < 5)
+                {
+                    std::this_thread::sleep_for(milliseconds(1));
+                }
+                Check(pool.RunCount() == 4);
+                Check(pool.DiscardCount() == 1);
+                {
+                    std::lock_guard<std::mutex> guard(logMutex);
+                    // the 256 group (with the most recent poll) first, then the 512 group; 5 discarded in its group
+                    std::vector<int> expected{ 1, 3, -5, 2, 4 };
+                    Check(log == expected);
+                }
+
+                // now make a job slow, and unregister its source while it runs
+                source1.RunDuration = milliseconds(50);
+                source1.Queue();
+                while (!source1.Running)
+                {
+                    std::this_thread::yield();
+                }
+                pool.Unregister(&source1);
+                Check(!source1.Running);
+                Check(pool.RunCount() == 5);
+
+                for (FakeJobSource* source : sources)
+                {
+                    if (source != &source1)
+                    {
+                        pool.Unregister(source);
+                    }
+                }
+            }
+        }
+
         TEST_METHOD(TestBufferAllocator)
         {
             BufferAllocator<float> bufferAllocator(FloatNumSlices * 2048, 1);
             OwningBuf<float> f(bufferAllocator.Allocate());
             Check(f.Length() == FloatSliverCount * 1024 * FloatNumSlices);
+            Check(((uintptr_t)f.Data() % OwningBuf<float>::Alignment) == 0);
 
             OwningBuf<float> f2(bufferAllocator.Allocate());
             Check(f.Length() == f2.Length());
@@ -74,6 +810,1094 @@ namespace UnitTestsDesktop
             Check(f2ptr == f3.Data()); // need to pull from free list first
         }
 
+        // Hammer a single allocator from several threads at once; every buffer must be exclusively owned
+        // by one thread between Allocate and Free, and all buffers must wind up back on the free list.
+        TEST_METHOD(TestBufferAllocatorConcurrency)
+        {
+            const int threadCount = 4;
+            const int iterationCount = 10000;
+            const int maxBuffersPerIteration = 4;
+            const int bufferLength = 64;
+            BufferAllocator<float> bufferAllocator(bufferLength, 2);
+
+            std::atomic<bool> failed{ false };
+            std::vector<std::thread> threads;
+            for (int t = 0; t < threadCount; t++)
+            {
+                threads.push_back(std::thread([&bufferAllocator, &failed, t]()
+                {
+                    std::vector<OwningBuf<float>> held;
+                    for (int i = 0; i < iterationCount; i++)
+                    {
+                        // stamp each buffer with a value unique to this thread and iteration
+                        float stamp = (float)(t * iterationCount + i);
+                        int count = 1 + (i % maxBuffersPerIteration);
+                        for (int j = 0; j < count; j++)
+                        {
+                            held.push_back(bufferAllocator.Allocate());
+                            float* data = held.back().Data();
+                            for (int k = 0; k < bufferLength; k++)
+                            {
+                                data[k] = stamp;
+                            }
+                        }
+
+                        std::this_thread::yield();
+
+                        // nobody else may have written to our buffers meanwhile
+                        for (OwningBuf<float>& buf : held)
+                        {
+                            if (buf.Data()[0] != stamp || buf.Data()[bufferLength - 1] != stamp)
+                            {
+                                failed = true;
+                            }
+                            bufferAllocator.Free(std::move(buf));
+                        }
+                        held.clear();
+                    }
+                }));
+            }
+
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+
+            Check(!failed);
+            // no buffer should be lost, and no more buffers than could ever be simultaneously held should exist
+            Check(bufferAllocator.TotalFreeListSpace() == bufferAllocator.TotalReservedSpace());
+            Check(bufferAllocator.TotalReservedSpace() <= (long)((threadCount * maxBuffersPerIteration + 2) * bufferLength * sizeof(float)));
+        }
+
+        // Time freeing many buffers, with and without free checking.  Freeing must be O(1) either way, so
+        // the per-buffer cost should not depend on how many buffers are already on the free list.
+        static double TimeFreeingBuffers(bool checkFrees, int bufferCount)
+        {
+            BufferAllocator<float> bufferAllocator(16, 1, checkFrees);
+            std::vector<OwningBuf<float>> buffers;
+            for (int i = 0; i < bufferCount; i++)
+            {
+                buffers.push_back(bufferAllocator.Allocate());
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (OwningBuf<float>& buffer : buffers)
+            {
+                bufferAllocator.Free(std::move(buffer));
+            }
+            std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+            Check(bufferAllocator.TotalFreeListSpace() == bufferAllocator.TotalReservedSpace());
+            return elapsed.count();
+        }
+
+        TEST_METHOD(BenchmarkBufferAllocatorFree)
+        {
+            const int bufferCount = 10000;
+            for (bool checkFrees : { true, false })
+            {
+                double microseconds = TimeFreeingBuffers(checkFrees, bufferCount);
+                std::wstringstream wstr;
+                wstr << L"BenchmarkBufferAllocatorFree: checkFrees " << checkFrees
+                    << L", " << bufferCount << L" frees in " << microseconds << L" usec ("
+                    << (microseconds * 1000 / bufferCount) << L" nsec/free)" << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+            }
+        }
+
+        // The refill thread should keep the free list above its low watermark, so draining it gradually
+        // never forces Allocate() onto the heap.
+        TEST_METHOD(TestBufferAllocatorRefill)
+        {
+            BufferAllocator<float> bufferAllocator(64, 1);
+            Check(bufferAllocator.Refill(2, 4) == 3);
+            Check(bufferAllocator.FreeBufferCount() == 4);
+            // above the low watermark, so nothing to do
+            Check(bufferAllocator.Refill(2, 4) == 0);
+
+            bufferAllocator.StartRefillThread(2, 4, std::chrono::milliseconds(1));
+
+            std::vector<OwningBuf<float>> held;
+            for (int i = 0; i < 20; i++)
+            {
+                held.push_back(bufferAllocator.Allocate());
+                // give the refill thread ample time to catch up
+                for (int j = 0; j < 1000 && bufferAllocator.FreeBufferCount() < 2; j++)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            bufferAllocator.StopRefillThread();
+            Check(bufferAllocator.ForcedAllocationCount() == 0);
+
+            for (OwningBuf<float>& buf : held)
+            {
+                bufferAllocator.Free(std::move(buf));
+            }
+            Check(bufferAllocator.TotalFreeListSpace() == bufferAllocator.TotalReservedSpace());
+
+            // with no refill thread, draining the free list forces allocation
+            while (bufferAllocator.FreeBufferCount() > 0)
+            {
+                held.push_back(bufferAllocator.Allocate());
+            }
+            held.push_back(bufferAllocator.Allocate());
+            Check(bufferAllocator.ForcedAllocationCount() == 1);
+        }
+
+        // The kernels must give the same results whether or not their arguments are aligned, and whatever
+        // the length of the scalar tail.
+        TEST_METHOD(TestAudioKernels)
+        {
+            const int length = 64;
+            OwningBuf<float> source(1, length + 1);
+            OwningBuf<float> left(2, length + 1);
+            OwningBuf<float> right(3, length + 1);
+            for (int offset = 0; offset <= 1; offset++)
+            {
+                for (int count = 0; count <= length; count += 7)
+                {
+                    float* src = source.Data() + offset;
+                    float* l = left.Data() + offset;
+                    float* r = right.Data() + offset;
+                    for (int i = 0; i < count; i++)
+                    {
+                        src[i] = (float)i - 20;
+                        l[i] = 1;
+                    }
+
+                    AudioKernels::Mix(l, src, 0.5f, count);
+                    for (int i = 0; i < count; i++)
+                    {
+                        Check(l[i] == 1 + src[i] * 0.5f);
+                    }
+
+                    AudioKernels::Scale(r, src, 2, count);
+                    for (int i = 0; i < count; i++)
+                    {
+                        Check(r[i] == src[i] * 2);
+                    }
+
+                    AudioKernels::Copy(l, src, count);
+                    AudioKernels::Pan(l, l, r, 0.25f, 0.75f, 10, count);
+                    for (int i = 0; i < count; i++)
+                    {
+                        Check(l[i] == AudioKernels::Clamp(src[i] * 0.25f, 10));
+                        Check(r[i] == AudioKernels::Clamp(src[i] * 0.75f, 10));
+                    }
+
+                    AudioKernels::Copy(l, src, count);
+                    AudioKernels::PanRamp(l, l, r, 0.25f, 0.5f, 1, 0, 10, count);
+                    for (int i = 0; i < count; i++)
+                    {
+                        Check(std::abs(l[i] - AudioKernels::Clamp(src[i] * (0.25f + 0.25f * i / count), 10)) < 1e-5f);
+                        Check(std::abs(r[i] - AudioKernels::Clamp(src[i] * (1 - (float)i / count), 10)) < 1e-5f);
+                    }
+
+                    std::vector<float> pannedLeft(l, l + count);
+                    std::vector<float> pannedRight(r, r + count);
+                    AudioKernels::Balance(l, r, 0.5f, 2, 10, count);
+                    for (int i = 0; i < count; i++)
+                    {
+                        Check(l[i] == AudioKernels::Clamp(pannedLeft[i] * 0.5f, 10));
+                        Check(r[i] == AudioKernels::Clamp(pannedRight[i] * 2, 10));
+                    }
+
+                    // stereo round trip through the interleaving kernels, using source as the interleaved buffer
+                    const float* stereoIn[2] = { l, r };
+                    AudioKernels::Interleave(stereoIn, 2, 0, source.Data(), count / 2);
+                    float* stereoOut[2] = { left.Data(), right.Data() };
+                    std::vector<float> expectedLeft(l, l + count / 2);
+                    std::vector<float> expectedRight(r, r + count / 2);
+                    AudioKernels::Deinterleave((const float*)source.Data(), 2, stereoOut, 0, count / 2);
+                    for (int i = 0; i < count / 2; i++)
+                    {
+                        Check(left.Data()[i] == expectedLeft[i]);
+                        Check(right.Data()[i] == expectedRight[i]);
+                    }
+                }
+            }
+        }
+
+        // Panning keeps a mono source's power constant; balancing passes stereo through at center and silences
+        // the far channel at the extremes.
+        TEST_METHOD(TestPanAndBalanceGains)
+        {
+            float leftGain, rightGain;
+            for (int step = 0; step <= 10; step++)
+            {
+                float pan = step / 10.0f;
+                AudioKernels::PanGains(pan, 0.5f, leftGain, rightGain);
+                Check(std::abs(leftGain * leftGain + rightGain * rightGain - 0.25f) < 1e-6f);
+
+                AudioKernels::BalanceGains(pan, 0.5f, leftGain, rightGain);
+                Check(leftGain <= 0.5f && rightGain <= 0.5f);
+                Check(pan <= 0.5f ? leftGain == 0.5f : rightGain == 0.5f);
+            }
+
+            AudioKernels::PanGains(0, 1, leftGain, rightGain);
+            Check(leftGain == 1 && rightGain == 0);
+
+            AudioKernels::BalanceGains(0.5f, 1, leftGain, rightGain);
+            Check(leftGain == 1 && rightGain == 1);
+            AudioKernels::BalanceGains(0, 1, leftGain, rightGain);
+            Check(leftGain == 1 && rightGain == 0);
+            AudioKernels::BalanceGains(1, 1, leftGain, rightGain);
+            Check(std::abs(leftGain) < 1e-6f && rightGain == 1);
+        }
+
+        // Ramps arrive on time however the blocks fall, and a signal run through ramped blocks never jumps.
+        TEST_METHOD(TestSmoothedParameter)
+        {
+            float start, end;
+
+            SmoothedParameter linear(0, RampShape::Linear, 100);
+            linear.Advance(32, start, end);
+            Check(start == 0 && end == 0);
+            linear.Set(1);
+            Check(linear.Target() == 1);
+            linear.Advance(32, start, end);
+            Check(start == 0 && std::abs(end - 0.32f) < 1e-6f);
+            linear.Advance(32, start, end);
+            linear.Advance(32, start, end);
+            Check(end < 1);
+            linear.Advance(32, start, end);
+            Check(end == 1);
+            // retargeting mid-ramp ramps from wherever the value has got to
+            linear.Set(0);
+            linear.Advance(50, start, end);
+            Check(start == 1 && std::abs(end - 0.5f) < 1e-6f);
+            linear.Set(1);
+            linear.Advance(50, start, end);
+            Check(std::abs(end - 0.75f) < 1e-6f);
+
+            SmoothedParameter exponential(1, RampShape::Exponential, 480);
+            exponential.Set(0);
+            exponential.Advance(480, start, end);
+            Check(start == 1 && std::abs(end - 0.001f) < 1e-5f);
+            for (int i = 0; i < 10; i++)
+            {
+                exponential.Advance(480, start, end);
+            }
+            Check(end == 0);
+
+            // automate the pan of a full-scale DC signal, as fast as a client could, from another thread
+            const int blockSize = 64;
+            const int blockCount = 2000;
+            SmoothedParameter pan(0.5f, RampShape::Linear, 480);
+            std::atomic<bool> done{ false };
+            std::thread automation([&pan, &done]()
+            {
+                for (int i = 0; !done; i++)
+                {
+                    pan.Set(i % 2 == 0 ? 0.0f : 1.0f);
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                }
+            });
+
+            std::vector<float> left(blockSize), right(blockSize);
+            float lastLeft = std::cos(0.25f * RosettaFFT::PI), lastRight = lastLeft;
+            float maxJump = 0;
+            for (int block = 0; block < blockCount; block++)
+            {
+                std::fill(left.begin(), left.end(), 1.0f);
+                float leftStart, rightStart, leftEnd, rightEnd;
+                pan.Advance(blockSize, start, end);
+                Check(start >= 0 && start <= 1 && end >= 0 && end <= 1);
+                AudioKernels::PanGains(start, 1, leftStart, rightStart);
+                AudioKernels::PanGains(end, 1, leftEnd, rightEnd);
+                AudioKernels::PanRamp(left.data(), left.data(), right.data(), leftStart, leftEnd, rightStart, rightEnd, 1, blockSize);
+                for (int i = 0; i < blockSize; i++)
+                {
+                    float leftJump = std::abs(left[i] - lastLeft);
+                    float rightJump = std::abs(right[i] - lastRight);
+                    maxJump = leftJump > maxJump ? leftJump : maxJump;
+                    maxJump = rightJump > maxJump ? rightJump : maxJump;
+                    lastLeft = left[i];
+                    lastRight = right[i];
+                }
+            }
+            done = true;
+            automation.join();
+
+            // a full left-to-right sweep over 480 samples moves each gain about pi / 2 / 480 per sample at most
+            Check(maxJump < 0.005f);
+        }
+
+        TEST_METHOD(TestSignalGenerators)
+        {
+            const int sampleRate = 48000;
+            const int length = 4800;
+
+            // a sine generated in uneven blocks matches one generated all at once
+            std::vector<float> whole(length);
+            std::vector<float> pieces(length);
+            SineGenerator wholeSine(sampleRate, 441, 0.5f);
+            wholeSine.Generate(whole.data(), length);
+            SineGenerator pieceSine(sampleRate, 441, 0.5f);
+            for (int offset = 0, block = 1; offset < length; offset += block, block = block * 2 + 1)
+            {
+                pieceSine.Generate(pieces.data() + offset, (offset + block > length ? length - offset : block));
+            }
+            for (int i = 0; i < length; i++)
+            {
+                Check(whole[i] == pieces[i]);
+                Check(std::abs(whole[i] - 0.5f * (float)std::sin(2 * RosettaFFT::PI * 441 * i / sampleRate)) < 1e-4f);
+            }
+
+            // noise is reproducible from its seed, within its amplitude, and roughly zero-mean
+            NoiseGenerator noise1(1234, 0.25f);
+            NoiseGenerator noise2(1234, 0.25f);
+            NoiseGenerator noise3(5678, 0.25f);
+            std::vector<float> noiseSamples1(length);
+            std::vector<float> noiseSamples2(length);
+            std::vector<float> noiseSamples3(length);
+            noise1.Generate(noiseSamples1.data(), length);
+            noise2.Generate(noiseSamples2.data(), length);
+            noise3.Generate(noiseSamples3.data(), length);
+            double sum = 0;
+            int differences = 0;
+            for (int i = 0; i < length; i++)
+            {
+                Check(noiseSamples1[i] == noiseSamples2[i]);
+                Check(noiseSamples1[i] >= -0.25f && noiseSamples1[i] < 0.25f);
+                differences += noiseSamples1[i] != noiseSamples3[i] ? 1 : 0;
+                sum += noiseSamples1[i];
+            }
+            Check(differences > length / 2);
+            Check(std::abs(sum / length) < 0.01);
+
+            // impulses land every period, across block boundaries
+            ImpulseGenerator impulse(100, 1);
+            std::vector<float> impulses(length);
+            for (int offset = 0; offset < length; offset += 64)
+            {
+                impulse.Generate(impulses.data() + offset, (offset + 64 > length ? length - offset : 64));
+            }
+            for (int i = 0; i < length; i++)
+            {
+                Check(impulses[i] == (i % 100 == 0 ? 1.0f : 0.0f));
+            }
+
+            SilenceGenerator silence;
+            silence.Generate(impulses.data(), length);
+            for (int i = 0; i < length; i++)
+            {
+                Check(impulses[i] == 0);
+            }
+        }
+
+        TEST_METHOD(TestLatencyRecorder)
+        {
+            LatencyRecorder recorder(100);
+            Check(recorder.Percentile(50) == 0);
+            Check(recorder.Max() == 0);
+
+            // record 1..100 out of order, then some more which don't fit
+            for (int i = 0; i < 100; i++)
+            {
+                recorder.Record((i * 37) % 100 + 1);
+            }
+            recorder.Record(1000);
+            Check(recorder.Count() == 100);
+
+            Check(recorder.Percentile(0) == 1);
+            Check(recorder.Percentile(50) == 50);
+            Check(recorder.Percentile(99) == 99);
+            Check(recorder.Percentile(99.5) == 100);
+            Check(recorder.Percentile(100) == 100);
+            Check(recorder.Max() == 100);
+            Check(recorder.Mean() == 50.5);
+
+            recorder.Clear();
+            Check(recorder.Count() == 0);
+        }
+
+        TEST_METHOD(TestThreadWorkCounters)
+        {
+            ThreadWorkCounters before = CurrentThreadWorkCounters();
+            CountAllocation(100);
+            CountAllocation(28);
+            Check(CurrentThreadWorkCounters().Allocations - before.Allocations == 2);
+            Check(CurrentThreadWorkCounters().AllocatedBytes - before.AllocatedBytes == 128);
+
+            // other threads' counts are their own
+            std::thread other([]() { CountAllocation(1000); });
+            other.join();
+            Check(CurrentThreadWorkCounters().AllocatedBytes - before.AllocatedBytes == 128);
+
+            std::vector<float> source(256, 1.0f);
+            std::vector<float> destination(256);
+            AudioKernels::Copy(destination.data(), source.data(), 256);
+            AudioKernels::Mix(destination.data(), source.data(), 1, 256);
+#ifdef NOWSOUND_COUNT_KERNEL_TRAFFIC
+            Check(CurrentThreadWorkCounters().KernelBytes - before.KernelBytes == (2 + 3) * 256 * sizeof(float));
+#else
+            Check(CurrentThreadWorkCounters().KernelBytes == before.KernelBytes);
+#endif
+        }
+
+        TEST_METHOD(TestTimingHistogram)
+        {
+            // buckets are contiguous and ordered, and each duration lands in the bucket that bounds it
+            for (int i = 0; i < TimingHistogram::BucketCount - 1; i++)
+            {
+                int64_t upperBound = TimingHistogram::BucketUpperBound(i);
+                Check(TimingHistogram::BucketIndex(upperBound) == i);
+                Check(TimingHistogram::BucketIndex(upperBound + 1) == i + 1);
+            }
+            Check(TimingHistogram::BucketIndex(-5) == 0);
+            Check(TimingHistogram::BucketIndex(INT64_MAX) == TimingHistogram::BucketCount - 1);
+
+            // and are within 12.5% of the durations in them
+            for (int64_t nanoseconds = 8; nanoseconds < 1000000000; nanoseconds = nanoseconds * 3 + 1)
+            {
+                int64_t upperBound = TimingHistogram::BucketUpperBound(TimingHistogram::BucketIndex(nanoseconds));
+                Check(upperBound >= nanoseconds);
+                Check(upperBound - nanoseconds <= nanoseconds / 8);
+            }
+
+            TimingHistogram histogram;
+            Check(histogram.Summarize().Count == 0);
+
+            // 1..100 microseconds
+            for (int i = 0; i < 100; i++)
+            {
+                histogram.Record(((i * 37) % 100 + 1) * 1000);
+            }
+            TimingSummary summary = histogram.Summarize();
+            Check(summary.Count == 100);
+            Check(summary.MeanNanoseconds == 50500);
+            Check(summary.MaxNanoseconds == 100000);
+            Check(summary.P99Nanoseconds >= 99000);
+            Check(summary.P99Nanoseconds <= 100000);
+
+            // one outlier shows in the max, but not the p99
+            histogram.Record(5000000);
+            summary = histogram.Summarize();
+            Check(summary.MaxNanoseconds == 5000000);
+            Check(summary.P99Nanoseconds <= 100000 + 100000 / 8);
+
+            // a reset hides everything at once, and clears it at the next recording
+            histogram.Reset();
+            Check(histogram.Summarize().Count == 0);
+            histogram.Record(2000);
+            summary = histogram.Summarize();
+            Check(summary.Count == 1);
+            Check(summary.MeanNanoseconds == 2000);
+            Check(summary.P99Nanoseconds == 2000);
+            Check(summary.MaxNanoseconds == 2000);
+
+            // summarizing while another thread records sees a consistent-enough prefix
+            TimingHistogram concurrent;
+            std::atomic<bool> done{ false };
+            std::thread recorder([&]()
+            {
+                for (int i = 0; i < 1000000; i++)
+                {
+                    concurrent.Record(1000 + i % 1000);
+                }
+                done = true;
+            });
+            while (!done)
+            {
+                TimingSummary partial = concurrent.Summarize();
+                Check(partial.MaxNanoseconds <= 1999);
+                Check(partial.P99Nanoseconds <= partial.MaxNanoseconds);
+            }
+            recorder.join();
+            Check(concurrent.Summarize().Count == 1000000);
+        }
+
+        // The ring keeps the latest events in order, never hands out a torn one while writers race, and exports
+        // them as Chrome trace events; a deadline miss keeps only its slowest nodes.
+        TEST_METHOD(TestTimelineRecorder)
+        {
+            TimelineEvent miss = TimelineEvent::Create(TimelineEventKind::DeadlineMiss, 0, 1000, 3000000);
+            miss.SampleTime = 48000;
+            miss.DeadlineNanoseconds = 2666666;
+            const char* names[] = { "Track 1", "Track 2", "LoopBank", "Input 1", "OutputMix", "Track 3 Output \"long\" name" };
+            int64_t durations[] = { 100, 500, 2000, 50, 300, 1000 };
+            for (int i = 0; i < 6; i++)
+            {
+                miss.AddSlowNode(names[i], durations[i]);
+            }
+            Check(miss.SlowNodeCount == TimelineEvent::MaxSlowNodes);
+            Check(std::strcmp(miss.SlowNodes[0].Name, "LoopBank") == 0);
+            Check(miss.SlowNodes[1].DurationNanoseconds == 1000);
+            Check(std::strlen(miss.SlowNodes[1].Name) == TimelineNode::MaxNameLength - 1);
+            Check(std::strcmp(miss.SlowNodes[2].Name, "Track 2") == 0);
+            Check(std::strcmp(miss.SlowNodes[3].Name, "OutputMix") == 0);
+
+            TimelineRecorder timeline(8);
+            std::vector<TimelineEvent> events;
+            timeline.Snapshot(events);
+            Check(events.empty());
+
+            for (int i = 0; i < 10; i++)
+            {
+                timeline.Record(TimelineEvent::Create(TimelineEventKind::TrackCreated, i, i * 1000, 10));
+            }
+            Check(timeline.RecordedCount() == 10);
+            timeline.Snapshot(events);
+            Check(events.size() == 8);
+            for (int i = 0; i < 8; i++)
+            {
+                Check(events[i].Id == i + 2);
+            }
+
+            {
+                TimelineRecorder exported(4);
+                exported.Record(miss);
+                exported.Record(TimelineEvent::Create(TimelineEventKind::FftBurst, 3, 5000, 2000));
+                // an hour in, timestamps must still be exact to the nanosecond
+                const int64_t hour = (int64_t)3600 * 1000000000;
+                exported.Record(TimelineEvent::Create(TimelineEventKind::GraphRebuild, 0, exported.OriginNanoseconds() + hour + 1234567, 1500));
+                std::stringstream trace{};
+                exported.WriteChromeTrace(trace);
+                std::string json = trace.str();
+                Check(json.find("\"traceEvents\":[") != std::string::npos);
+                Check(json.find("{\"name\":\"DeadlineMiss\",\"ph\":\"X\",\"pid\":1,\"tid\":1,") != std::string::npos);
+                Check(json.find("\"sampleTime\":48000") != std::string::npos);
+                Check(json.find("{\"name\":\"LoopBank\",\"microseconds\":2}") != std::string::npos);
+                Check(json.find("\\\"long\\\"") != std::string::npos);
+                Check(json.find("{\"name\":\"FftBurst\",\"ph\":\"X\",\"pid\":1,\"tid\":3,") != std::string::npos);
+                Check(json.find("{\"name\":\"GraphRebuild\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":3600001234.567,\"dur\":1.500,") != std::string::npos);
+                Check(std::count(json.begin(), json.end(), '{') == std::count(json.begin(), json.end(), '}'));
+                Check(std::count(json.begin(), json.end(), '[') == std::count(json.begin(), json.end(), ']'));
+            }
+
+            // four writers lapping a small ring; every event read must be one some writer wrote whole
+            TimelineRecorder raced(16);
+            std::atomic<bool> done{ false };
+            std::vector<std::thread> writers;
+            for (int writer = 0; writer < 4; writer++)
+            {
+                writers.push_back(std::thread([&raced, writer]()
+                {
+                    for (int i = 0; i < 100000; i++)
+                    {
+                        TimelineEvent event = TimelineEvent::Create(TimelineEventKind::FftBurst, writer, i, -i);
+                        event.SampleTime = i * 3;
+                        raced.Record(event);
+                    }
+                }));
+            }
+            std::thread reader([&]()
+            {
+                std::vector<TimelineEvent> snapshot;
+                while (!done)
+                {
+                    raced.Snapshot(snapshot);
+                    Check(snapshot.size() <= 16);
+                    for (const TimelineEvent& event : snapshot)
+                    {
+                        Check(event.Kind == TimelineEventKind::FftBurst);
+                        Check(event.Id >= 0 && event.Id < 4);
+                        Check(event.DurationNanoseconds == -event.StartNanoseconds);
+                        Check(event.SampleTime == event.StartNanoseconds * 3);
+                    }
+                }
+            });
+            for (std::thread& writer : writers)
+            {
+                writer.join();
+            }
+            done = true;
+            reader.join();
+            Check(raced.RecordedCount() == 400000);
+
+            // and an analysis pool given a timeline records its bursts there
+            std::atomic<bool> released{ true };
+            std::mutex logMutex;
+            std::vector<int> log;
+            FakeJobSource source(1, 256, std::chrono::steady_clock::now(), released, logMutex, log);
+            TimelineRecorder poolTimeline(8);
+            {
+                AnalysisWorkerPool pool(1, std::chrono::microseconds(1000), std::chrono::milliseconds(10000), &poolTimeline);
+                pool.Register(&source);
+                source.Queue();
+                while (poolTimeline.RecordedCount() == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                pool.Unregister(&source);
+            }
+            poolTimeline.Snapshot(events);
+            Check(events.size() == 1);
+            Check(events[0].Kind == TimelineEventKind::FftBurst);
+            Check(events[0].Id == 1);
+            Check(events[0].DurationNanoseconds >= 0);
+        }
+
+        // Time what profiling costs a processBlock: two clock reads and a Record().
+        TEST_METHOD(BenchmarkTimingHistogram)
+        {
+            const int iterationCount = 10000000;
+            TimingHistogram histogram;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterationCount; i++)
+            {
+                int64_t blockStart = TimingHistogram::Now();
+                histogram.Record(TimingHistogram::Now() - blockStart);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            Check(histogram.Summarize().Count == iterationCount);
+
+            std::wstringstream wstr{};
+            wstr << L"TimingHistogram: " << (seconds * 1e9 / iterationCount) << L" ns per timed block" << std::endl;
+            Logger::WriteMessage(wstr.str().c_str());
+        }
+
+        // The per-sample loop SpatialAudioProcessor used to run: double coefficients, with the mute check inside.
+        static void ScalarPan(const float* source, float* left, float* right, double pan, double volume, bool isMuted, int count)
+        {
+            double angularPosition = pan * RosettaFFT::PI / 2;
+            double leftCoefficient = std::cos(angularPosition);
+            double rightCoefficient = std::sin(angularPosition);
+            for (int i = 0; i < count; i++)
+            {
+                float value = isMuted ? 0 : source[i];
+                left[i] = AudioKernels::Clamp((float)(value * leftCoefficient * volume), 1);
+                right[i] = AudioKernels::Clamp((float)(value * rightCoefficient * volume), 1);
+            }
+        }
+
+        // Time the pan and balance kernels against the scalar loop, at block sizes from 32 to 4096 samples.
+        TEST_METHOD(BenchmarkPanKernels)
+        {
+            const int maxBlockSize = 4096;
+            const int samplesPerRun = 1 << 24;
+            OwningBuf<float> source(1, maxBlockSize);
+            OwningBuf<float> left(2, maxBlockSize);
+            OwningBuf<float> right(3, maxBlockSize);
+            for (int i = 0; i < maxBlockSize; i++)
+            {
+                source.Data()[i] = (float)std::sin(i * 0.01);
+                left.Data()[i] = source.Data()[i];
+                right.Data()[i] = -source.Data()[i];
+            }
+
+            for (int blockSize = 32; blockSize <= maxBlockSize; blockSize *= 2)
+            {
+                int iterationCount = samplesPerRun / blockSize;
+                float leftGain, rightGain;
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterationCount; i++)
+                {
+                    ScalarPan(source.Data(), left.Data(), right.Data(), 0.3, 0.9, false, blockSize);
+                }
+                std::chrono::duration<double> scalarTime = std::chrono::steady_clock::now() - start;
+
+                start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterationCount; i++)
+                {
+                    AudioKernels::PanGains(0.3f, 0.9f, leftGain, rightGain);
+                    AudioKernels::Pan(source.Data(), left.Data(), right.Data(), leftGain, rightGain, 1, blockSize);
+                }
+                std::chrono::duration<double> panTime = std::chrono::steady_clock::now() - start;
+
+                start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterationCount; i++)
+                {
+                    // a centered balance (0.5) at unit volume leaves the data unchanged, so repeated runs stay in range
+                    AudioKernels::BalanceGains(0.5f, 1, leftGain, rightGain);
+                    AudioKernels::Balance(left.Data(), right.Data(), leftGain, rightGain, 1, blockSize);
+                }
+                std::chrono::duration<double> balanceTime = std::chrono::steady_clock::now() - start;
+
+                double megasamples = (double)iterationCount * blockSize / 1000000;
+                std::wstringstream wstr;
+                wstr << L"BenchmarkPanKernels: block " << blockSize
+                    << L": scalar pan " << (megasamples / scalarTime.count())
+                    << L" Msamples/sec, pan " << (megasamples / panTime.count())
+                    << L" Msamples/sec, balance " << (megasamples / balanceTime.count())
+                    << L" Msamples/sec" << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+            }
+        }
+
+        // The audio thread never sees an item after Remove() returns, however adds and removes interleave with
+        // its renders; items are checked for liveness when visited, and destroyed right after removal.
+        TEST_METHOD(TestRenderList)
+        {
+            struct Item
+            {
+                std::atomic<int> Alive;
+                Item() : Alive{ 1 } {}
+            };
+
+            RenderList<Item> list(4);
+            Item a, b, c;
+            Check(list.Capacity() == 4);
+            Check(list.TryAdd(&a));
+            Check(list.TryAdd(&b));
+            Check(list.TryAdd(&c));
+            Check(list.Count() == 3 && list.Contains(&b));
+            list.Remove(&b);
+            Check(list.Count() == 2 && !list.Contains(&b));
+            // the emptied slot is reused
+            Check(list.TryAdd(&b));
+            Check(list.At(1) == &b);
+            Item d, e;
+            Check(list.TryAdd(&d));
+            Check(!list.TryAdd(&e));
+            list.Remove(&a);
+            list.Remove(&b);
+            list.Remove(&c);
+            list.Remove(&d);
+            Check(list.Count() == 0);
+
+            RenderList<Item> shared(16);
+            std::atomic<bool> done{ false };
+            std::atomic<int> deadVisits{ 0 };
+            std::atomic<int64_t> renders{ 0 };
+            std::thread audio([&]()
+            {
+                while (!done)
+                {
+                    shared.BeginRender();
+                    int slotCount = shared.SlotCount();
+                    for (int slot = 0; slot < slotCount; slot++)
+                    {
+                        Item* item = shared.At(slot);
+                        if (item != nullptr && item->Alive.load(std::memory_order_relaxed) != 1)
+                        {
+                            deadVisits++;
+                        }
+                    }
+                    shared.EndRender();
+                    renders++;
+                }
+            });
+
+            // make sure the renders overlap the churn
+            while (renders == 0)
+            {
+                std::this_thread::yield();
+            }
+
+            std::vector<Item*> live;
+            for (int i = 0; i < 20000; i++)
+            {
+                if (live.size() < 16 && (i % 3 != 0 || live.empty()))
+                {
+                    Item* item = new Item();
+                    Check(shared.TryAdd(item));
+                    live.push_back(item);
+                }
+                else
+                {
+                    Item* item = live[i % live.size()];
+                    live.erase(live.begin() + (i % live.size()));
+                    shared.Remove(item);
+                    item->Alive.store(0, std::memory_order_relaxed);
+                    delete item;
+                }
+            }
+            done = true;
+            audio.join();
+            for (Item* item : live)
+            {
+                delete item;
+            }
+
+            Check(deadVisits == 0);
+        }
+
+        // A looping track, as BenchmarkLoopBankRendering models one.
+        struct BenchmarkLoop
+        {
+            // The loop's interleaved stereo samples.
+            std::vector<float> Samples;
+
+            // Where the loop was when the benchmark started.
+            int64_t Phase;
+
+            // The track's output meter.
+            std::unique_ptr<BlockHistogram> Meter;
+        };
+
+        // Model one track's share of an audio callback: render a block from its loop into the render pair, pan it,
+        // copy it into the output pair (if that is a different pair, as when the track's output processor is a
+        // separate node with a connection between them), meter it and sum it into the mix.
+        static void RenderLoop(
+            BenchmarkLoop& loop,
+            int64_t position,
+            int blockSize,
+            float* render0,
+            float* render1,
+            float* output0,
+            float* output1,
+            float* mix0,
+            float* mix1)
+        {
+            int64_t loopLength = loop.Samples.size() / 2;
+            int64_t offset = (position + loop.Phase) % loopLength;
+            float* channels[2] = { render0, render1 };
+            int64_t first = loopLength - offset < blockSize ? loopLength - offset : blockSize;
+            AudioKernels::Deinterleave(loop.Samples.data() + offset * 2, 2, channels, 0, first);
+            if (first < blockSize)
+            {
+                AudioKernels::Deinterleave(loop.Samples.data(), 2, channels, first, blockSize - first);
+            }
+
+            AudioKernels::BalanceRamp(render0, render1, 0.8f, 0.8f, 0.7f, 0.7f, 1, blockSize);
+            if (output0 != render0)
+            {
+                AudioKernels::Copy(output0, render0, blockSize);
+                AudioKernels::Copy(output1, render1, blockSize);
+            }
+            loop.Meter->AddStereoMagnitudeBlock(output0, output1, blockSize);
+            AudioKernels::Mix(mix0, output0, 1, blockSize);
+            AudioKernels::Mix(mix1, output1, 1, blockSize);
+        }
+
+        // Time a callback's worth of loop rendering against track count, with each track as separate nodes (its
+        // own render and output pairs) or fused into a loop bank.  The fused runs walk a RenderList just as
+        // NowSoundLoopBankAudioProcessor::processBlock does, rendering every track into one shared scratch pair.
+        // This models only the buffer traffic; JUCE's own per-node scheduling, which fusing also saves, comes on
+        // top.  NowSoundBenchmark's loopBank scenarios measure the real processor in a real graph.
+        TEST_METHOD(BenchmarkLoopBankRendering)
+        {
+            const int blockSize = 256;
+            const int maxTrackCount = 256;
+            const int loopLength = 48000 * 2;
+            const int callbacksPerRun = 2000;
+
+            std::vector<std::unique_ptr<BenchmarkLoop>> loops;
+            for (int t = 0; t < maxTrackCount; t++)
+            {
+                std::unique_ptr<BenchmarkLoop> loop{ new BenchmarkLoop() };
+                loop->Samples.resize(loopLength * 2);
+                for (int i = 0; i < loopLength * 2; i++)
+                {
+                    loop->Samples[i] = (float)std::sin((i + t) * 0.001) * 0.1f;
+                }
+                loop->Phase = t * 101;
+                loop->Meter.reset(new BlockHistogram(24000, 1024));
+                loops.push_back(std::move(loop));
+            }
+            std::vector<float> buffers(maxTrackCount * 4 * blockSize);
+            std::vector<float> mix(blockSize * 2);
+            float* mix0 = mix.data();
+            float* mix1 = mix0 + blockSize;
+
+            RenderList<BenchmarkLoop> bank(maxTrackCount);
+            for (int trackCount = 1; trackCount <= maxTrackCount; trackCount *= 4)
+            {
+                while (bank.Count() < trackCount)
+                {
+                    Check(bank.TryAdd(loops[bank.Count()].get()));
+                }
+
+                // separate nodes: each track has a render pair and an output pair
+                int64_t position = 0;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int i = 0; i < callbacksPerRun; i++)
+                {
+                    memset(mix0, 0, sizeof(float) * blockSize);
+                    memset(mix1, 0, sizeof(float) * blockSize);
+                    for (int t = 0; t < trackCount; t++)
+                    {
+                        float* render0 = buffers.data() + t * 4 * blockSize;
+                        float* output0 = render0 + 2 * blockSize;
+                        RenderLoop(*loops[t], position, blockSize, render0, render0 + blockSize, output0, output0 + blockSize, mix0, mix1);
+                    }
+                    position += blockSize;
+                }
+                std::chrono::duration<double> separateTime = std::chrono::steady_clock::now() - start;
+
+                // fused: every track in the bank renders into the first pair
+                position = 0;
+                start = std::chrono::steady_clock::now();
+                for (int i = 0; i < callbacksPerRun; i++)
+                {
+                    memset(mix0, 0, sizeof(float) * blockSize);
+                    memset(mix1, 0, sizeof(float) * blockSize);
+                    float* render0 = buffers.data();
+                    float* render1 = render0 + blockSize;
+                    bank.BeginRender();
+                    int slotCount = bank.SlotCount();
+                    for (int slot = 0; slot < slotCount; slot++)
+                    {
+                        BenchmarkLoop* loop = bank.At(slot);
+                        if (loop == nullptr)
+                        {
+                            continue;
+                        }
+                        RenderLoop(*loop, position, blockSize, render0, render1, render0, render1, mix0, mix1);
+                    }
+                    bank.EndRender();
+                    position += blockSize;
+                }
+                std::chrono::duration<double> fusedTime = std::chrono::steady_clock::now() - start;
+
+                std::wstringstream wstr;
+                wstr << L"BenchmarkLoopBankRendering: " << trackCount << L" tracks, " << blockSize
+                    << L"-sample blocks: separate nodes " << (separateTime.count() * 1000000 / callbacksPerRun)
+                    << L" us/callback, fused " << (fusedTime.count() * 1000000 / callbacksPerRun)
+                    << L" us/callback (block period " << (blockSize * 1000000.0 / 48000) << L" us)" << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+            }
+        }
+
+        // Time copying and mixing a quantum at a time, with buffers aligned (as OwningBufs are) and misaligned by one float.
+        TEST_METHOD(BenchmarkAlignedCopyAndMix)
+        {
+            const int quantumLength = 1024;
+            const int iterationCount = 100000;
+            OwningBuf<float> source(1, quantumLength + 1);
+            OwningBuf<float> destination(2, quantumLength + 1);
+            for (int i = 0; i <= quantumLength; i++)
+            {
+                source.Data()[i] = (float)i / quantumLength;
+                destination.Data()[i] = 0;
+            }
+
+            for (int misalignment = 0; misalignment <= 1; misalignment++)
+            {
+                float* src = source.Data() + misalignment;
+                float* dest = destination.Data() + misalignment;
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterationCount; i++)
+                {
+                    AudioKernels::Copy(dest, src, quantumLength);
+                }
+                std::chrono::duration<double> copyTime = std::chrono::steady_clock::now() - start;
+
+                start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterationCount; i++)
+                {
+                    AudioKernels::Mix(dest, src, 0.001f, quantumLength);
+                }
+                std::chrono::duration<double> mixTime = std::chrono::steady_clock::now() - start;
+
+                double megasamples = (double)iterationCount * quantumLength / 1000000;
+                std::wstringstream wstr;
+                wstr << L"BenchmarkAlignedCopyAndMix: " << (misalignment == 0 ? L"aligned" : L"unaligned")
+                    << L" copy " << (megasamples / copyTime.count()) << L" Msamples/sec, mix "
+                    << (megasamples / mixTime.count()) << L" Msamples/sec" << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+            }
+        }
+
+#ifdef __linux__
+        // Number of minor and major page faults taken so far by the calling thread.
+        static long ThreadPageFaults()
+        {
+            rusage usage;
+            Check(getrusage(RUSAGE_THREAD, &usage) == 0);
+            return usage.ru_minflt + usage.ru_majflt;
+        }
+
+        // Simulate recording the given number of seconds of 48Khz stereo audio, a quantum at a time, into buffers
+        // from the given allocator; return the number of page faults taken while allocating and writing them.
+        // (Faults taken while appending to the recorded vector are the test's own bookkeeping, and are not counted.)
+        static long PageFaultsWhileRecording(BufferAllocator<float>& bufferAllocator, int seconds, std::vector<OwningBuf<float>>& recorded)
+        {
+            const int samplesPerQuantum = 480;
+            const int floatsPerQuantum = samplesPerQuantum * 2;
+            std::vector<float> quantum(floatsPerQuantum, 0.5f);
+
+            // Warm up the code path first, so we don't count faults from paging in code or resolving symbols.
+            {
+                OwningBuf<float> warmup = bufferAllocator.Allocate();
+                std::memcpy(warmup.Data(), quantum.data(), floatsPerQuantum * sizeof(float));
+                bufferAllocator.Free(std::move(warmup));
+            }
+
+            long faults = 0;
+            int quantaPerBuffer = bufferAllocator.BufferLength / floatsPerQuantum;
+            for (int second = 0; second < seconds; second++)
+            {
+                long faultsBefore = ThreadPageFaults();
+                OwningBuf<float> buffer = bufferAllocator.Allocate();
+                for (int i = 0; i < quantaPerBuffer; i++)
+                {
+                    std::memcpy(buffer.Data() + i * floatsPerQuantum, quantum.data(), floatsPerQuantum * sizeof(float));
+                }
+                faults += ThreadPageFaults() - faultsBefore;
+
+                recorded.push_back(std::move(buffer));
+            }
+            return faults;
+        }
+
+        // Recording ten minutes into an arena-backed allocator should never take a page fault, whereas
+        // recording into fresh heap buffers does.
+        TEST_METHOD(TestBufferAllocatorArenaPageFaults)
+        {
+            const int bufferLength = 48000 * 2;
+            const int tenMinutes = 600;
+
+            {
+                BufferAllocator<float> arenaAllocator(bufferLength, 1, BufferAllocator<float>::DefaultCheckFrees, tenMinutes);
+                Check(arenaAllocator.Arena() != nullptr);
+                Check(arenaAllocator.Arena()->Size() >= (size_t)tenMinutes * bufferLength * sizeof(float));
+                Check(arenaAllocator.FreeBufferCount() == tenMinutes);
+
+                std::vector<OwningBuf<float>> recorded;
+                long faults = PageFaultsWhileRecording(arenaAllocator, tenMinutes, recorded);
+
+                std::wstringstream wstr;
+                wstr << L"TestBufferAllocatorArenaPageFaults: arena faults " << faults
+                    << L", huge pages " << arenaAllocator.Arena()->UsesHugePages()
+                    << L", locked " << arenaAllocator.Arena()->IsLocked() << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+
+                Check(faults == 0);
+                Check(arenaAllocator.ForcedAllocationCount() == 0);
+
+                for (OwningBuf<float>& buf : recorded)
+                {
+                    Check(arenaAllocator.Arena()->Contains(buf.Data()));
+                    Check(buf.IsBorrowed());
+                    arenaAllocator.Free(std::move(buf));
+                }
+                Check(arenaAllocator.TotalFreeListSpace() == arenaAllocator.TotalReservedSpace());
+
+                // arena buffers are borrowed, so dropping one rather than freeing it leaves the heap alone
+                {
+                    OwningBuf<float> dropped = arenaAllocator.Allocate();
+                    Check(dropped.IsBorrowed());
+                }
+                Check(arenaAllocator.FreeBufferCount() == tenMinutes - 1);
+
+                // and heap buffers past the arena are owned as before
+                std::vector<OwningBuf<float>> overflow;
+                for (int i = 0; i < tenMinutes; i++)
+                {
+                    overflow.push_back(arenaAllocator.Allocate());
+                }
+                Check(!overflow.back().IsBorrowed());
+                Check(!arenaAllocator.Arena()->Contains(overflow.back().Data()));
+                for (OwningBuf<float>& buf : overflow)
+                {
+                    arenaAllocator.Free(std::move(buf));
+                }
+            }
+
+            // sanity check that we are measuring anything at all
+            {
+                BufferAllocator<float> heapAllocator(bufferLength, 1);
+                std::vector<OwningBuf<float>> recorded;
+                long faults = PageFaultsWhileRecording(heapAllocator, 10, recorded);
+                Check(faults > 0);
+
+                for (OwningBuf<float>& buf : recorded)
+                {
+                    heapAllocator.Free(std::move(buf));
+                }
+            }
+        }
+#endif
+
         // Fill a slice with simple linear data.
         static void PopulateFloatSlice(Slice<AudioSample, float> slice)
         {
@@ -175,9 +1999,10 @@ namespace UnitTestsDesktop
             return f;
         }
 
-        static float* AllocateSmall4FloatArray(int numSlices)
+        static OwningBuf<float> AllocateSmall4FloatArray(int numSlices)
         {
-            float* tinyBuffer = new float[numSlices * 4];
+            OwningBuf<float> result(0, numSlices * 4);
+            float* tinyBuffer = result.Data();
             float f = 0;
             for (int i = 0; i < numSlices; i++) {
                 tinyBuffer[i * 4] = f;
@@ -186,7 +2011,7 @@ namespace UnitTestsDesktop
                 tinyBuffer[i * 4 + 3] = f + 0.75f;
                 f++;
             }
-            return tinyBuffer;
+            return result;
         }
 
         TEST_METHOD(TestStreamChunky)
@@ -239,8 +2064,8 @@ namespace UnitTestsDesktop
             int bufferLength = sliceCount * sliverCount;
             BufferAllocator<float> bufferAllocator(bufferLength, 1);
 
-            float* buffer = AllocateSmall4FloatArray(sliceCount);
-            OwningBuf<float> owningBuf(0, bufferLength, buffer);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(sliceCount));
+            float* buffer = owningBuf.Data();
 
             BufferedSliceStream<AudioSample, float> stream(sliverCount, &bufferAllocator);
 
@@ -270,8 +2095,7 @@ namespace UnitTestsDesktop
             int bufferLength = sliceCount * sliverCount;
             BufferAllocator<float> bufferAllocator(bufferLength, 1);
 
-            float* buffer = AllocateSmall4FloatArray(sliceCount * 2);
-            OwningBuf<float> owningBuf(0, bufferLength * 2, buffer);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(sliceCount * 2));
 
             BufferedSliceStream<AudioSample, float> stream(sliverCount, &bufferAllocator);
             stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), sliverCount));
@@ -327,8 +2151,7 @@ namespace UnitTestsDesktop
 
             float continuousDuration = 2.4f;
             int discreteDuration = (int)std::floor(continuousDuration + 1);
-            float* buffer = AllocateSmall4FloatArray(discreteDuration);
-            OwningBuf<float> owningBuf(0, discreteDuration * sliverCount, buffer);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(discreteDuration));
             BufferedSliceStream<AudioSample, float> stream(0, sliverCount, &bufferAllocator, 0, /*useExactLoopingMapper:*/true);
             stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), sliverCount));
 
@@ -394,6 +2217,163 @@ namespace UnitTestsDesktop
             Check(slice.Get(0, 0) == 0);
         }
 
+        // Loop boundaries and beat positions stay sample-exact far into a session (10^10 samples is over
+        // two days at 48Khz), where float arithmetic would be off by whole samples.
+        TEST_METHOD(TestExactLoopingAfterLongSession)
+        {
+            // floats convert exactly
+            Check(RationalDuration<AudioSample>(0.5f) == RationalDuration<AudioSample>(1, 2));
+            Check(RationalDuration<AudioSample>(3.0f) == RationalDuration<AudioSample>(3, 1));
+            Check(RationalDuration<AudioSample>(2.4f).Ceiling() == 3);
+            Check((RationalDuration<AudioSample>(12, 5) * 5) == RationalDuration<AudioSample>(12, 1));
+
+            // products that overflow 64 bits still divide exactly
+            const int64_t big = (int64_t)1 << 40;
+            int64_t quotient, remainder;
+            RationalDuration<AudioSample>::MultiplyDivide(3000000000000, big, 3 * big, quotient, remainder);
+            Check(quotient == 1000000000000 && remainder == 0);
+            RationalDuration<AudioSample>::MultiplyDivide(3000000000001, big, 3 * big, quotient, remainder);
+            Check(quotient == 1000000000000 && remainder == big);
+
+            // A loop of exactly 12/5 samples: five iterations take exactly 12 samples, so the mapping depends only
+            // on the time modulo 12.  Offset and duration at each time modulo 12, per the table in ExactLoopingIntervalMapper:
+            const int expectedOffset[12] = { 0, 1, 2, 0, 1, 0, 1, 2, 0, 1, 0, 1 };
+            const int expectedDuration[12] = { 3, 2, 1, 2, 1, 3, 2, 1, 2, 1, 2, 1 };
+
+            const int sliverCount = 4;
+            BufferAllocator<float> bufferAllocator(sliverCount * 11, 1);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(3));
+            BufferedSliceStream<AudioSample, float> stream(0, sliverCount, &bufferAllocator, 0, /*useExactLoopingMapper:*/ true);
+            stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), sliverCount));
+            stream.Shut(RationalDuration<AudioSample>(12, 5));
+
+            const int64_t late = 10000000000;
+            for (int64_t t = late - 12; t < late + 24; t++)
+            {
+                Interval<AudioSample> mapped = stream.MapNextSubInterval(Interval<AudioSample>(t, 3));
+                Check(mapped.InitialTime() == expectedOffset[t % 12]);
+                Check(mapped.IntervalDuration() == expectedDuration[t % 12]);
+            }
+
+            // And the clock: 91 BPM at 48Khz is exactly 2880000/91 samples per beat, which no float can represent.
+            Clock::Initialize(48000, 2, 91, 4);
+            Check(Clock::Instance().ExactBeatDuration() == RationalDuration<AudioSample>(2880000, 91));
+            // Beat 315973 starts at 315973 * 2880000 / 91 = 10000024615.38..., so its first sample is 10000024616.
+            Check(Clock::Instance().TimeToCompleteBeats(10000024615) == 315972);
+            Check(Clock::Instance().TimeToCompleteBeats(10000024616) == 315973);
+            Check(Clock::Instance().TimeToFractionalBeat(10000024616).Value() < 0.0001f);
+            Check(Clock::Instance().TimeToFractionalBeat(10000024615).Value() > 0.9999f);
+
+            // Times before zero round down to the beat they fall in, like any other.
+            Check(Clock::Instance().TimeToCompleteBeats(-1) == -1);
+            Check(Clock::Instance().TimeToFractionalBeat(-1).Value() > 0.9999f);
+            Check(Clock::Instance().TimeToCompleteBeats(-10000024615) == -315973);
+            Check(Clock::Instance().TimeToCompleteBeats(-10000024616) == -315974);
+            Clock::Shutdown();
+
+            // Exact multiples divide with no remainder, whatever their sign.
+            RationalDuration<AudioSample>(12, 5).Divide(-24, quotient, remainder);
+            Check(quotient == -10 && remainder == 0);
+            RationalDuration<AudioSample>(12, 5).Divide(-25, quotient, remainder);
+            Check(quotient == -11 && remainder == 7);
+        }
+
+        // The mapping design before IntervalMapper became a variant: a virtual mapper, calling back through a
+        // virtual stream interface.  Kept only as BenchmarkIntervalMapping's baseline.
+        class VirtualStream
+        {
+        public:
+            virtual Time<AudioSample> InitialTime() const = 0;
+            virtual Duration<AudioSample> DiscreteDuration() const = 0;
+            virtual RationalDuration<AudioSample> ExactRationalDuration() const = 0;
+            virtual bool IsShut() const = 0;
+        };
+
+        class VirtualStreamOf : public VirtualStream
+        {
+            const DenseSliceStream<AudioSample, float>& _stream;
+        public:
+            VirtualStreamOf(const DenseSliceStream<AudioSample, float>& stream) : _stream(stream) {}
+            virtual Time<AudioSample> InitialTime() const { return _stream.InitialTime(); }
+            virtual Duration<AudioSample> DiscreteDuration() const { return _stream.DiscreteDuration(); }
+            virtual RationalDuration<AudioSample> ExactRationalDuration() const { return _stream.ExactRationalDuration(); }
+            virtual bool IsShut() const { return _stream.IsShut(); }
+        };
+
+        class VirtualMapper
+        {
+        public:
+            virtual Interval<AudioSample> MapNextSubInterval(const VirtualStream* stream, Interval<AudioSample> input) const = 0;
+        };
+
+        template<typename TMapper>
+        class VirtualMapperOf : public VirtualMapper
+        {
+        public:
+            virtual Interval<AudioSample> MapNextSubInterval(const VirtualStream* stream, Interval<AudioSample> input) const
+            {
+                return TMapper().MapNextSubInterval(
+                    StreamExtent<AudioSample>(stream->InitialTime(), stream->DiscreteDuration(), stream->ExactRationalDuration(), stream->IsShut()),
+                    input);
+            }
+        };
+
+        // Time mapping TestStreamShutting's looping intervals, through the IntervalMapper variant and through
+        // virtual calls as before.
+        TEST_METHOD(BenchmarkIntervalMapping)
+        {
+            const int sliverCount = 4;
+            const int iterationCount = 1000000;
+            BufferAllocator<float> bufferAllocator(sliverCount * 11, 2);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(3));
+
+            // TestStreamShutting's two streams: 2.4 samples long, mapped exactly and simply
+            BufferedSliceStream<AudioSample, float> exactStream(0, sliverCount, &bufferAllocator, 0, /*useExactLoopingMapper:*/ true);
+            exactStream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), sliverCount));
+            exactStream.Shut(2.4f);
+            BufferedSliceStream<AudioSample, float> simpleStream(0, sliverCount, &bufferAllocator, 0, /*useExactLoopingMapper:*/ false);
+            simpleStream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), sliverCount));
+            simpleStream.Shut(2.4f);
+
+            const DenseSliceStream<AudioSample, float>* streams[2] = { &exactStream, &simpleStream };
+            VirtualStreamOf virtualStreams[2] = { VirtualStreamOf(exactStream), VirtualStreamOf(simpleStream) };
+            VirtualMapperOf<ExactLoopingIntervalMapper<AudioSample>> virtualExactMapper;
+            VirtualMapperOf<SimpleLoopingIntervalMapper<AudioSample>> virtualSimpleMapper;
+            const VirtualMapper* virtualMappers[2] = { &virtualExactMapper, &virtualSimpleMapper };
+
+            for (int s = 0; s < 2; s++)
+            {
+                int64_t checksum[2] = { 0, 0 };
+                double seconds[2];
+                for (int useVariant = 0; useVariant <= 1; useVariant++)
+                {
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < iterationCount; i++)
+                    {
+                        // map ten samples at a time, as TestStreamShutting does
+                        Interval<AudioSample> interval((int64_t)i * 10, 10);
+                        while (!interval.IsEmpty())
+                        {
+                            Interval<AudioSample> mapped = useVariant
+                                ? streams[s]->MapNextSubInterval(interval)
+                                : virtualMappers[s]->MapNextSubInterval(&virtualStreams[s], interval);
+                            checksum[useVariant] += mapped.InitialTime().Value() * 7 + mapped.IntervalDuration().Value();
+                            interval = interval.SubintervalStartingAt(mapped.IntervalDuration());
+                        }
+                    }
+                    seconds[useVariant] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                }
+
+                Check(checksum[0] == checksum[1]);
+
+                std::wstringstream wstr;
+                wstr << L"BenchmarkIntervalMapping: " << (s == 0 ? L"exact" : L"simple") << L" looping, "
+                    << L"virtual " << (seconds[0] * 1e9 / iterationCount) << L" ns/interval, "
+                    << L"variant " << (seconds[1] * 1e9 / iterationCount) << L" ns/interval" << std::endl;
+                Logger::WriteMessage(wstr.str().c_str());
+            }
+        }
+
         /* TODO: perhaps revive this test? I think I already have coverage of Free(), so postponing porting this.
         [TestMethod]
         public void TestDispose()
@@ -435,8 +2415,7 @@ namespace UnitTestsDesktop
             const int sliceCount = 11; // 11 slices per buffer, to test various cases
             BufferAllocator<float> bufferAllocator(sliverCount * sliceCount, 1);
 
-            float* tempBuffer = AllocateSmall4FloatArray(20);
-            OwningBuf<float> owningBuf(0, 20 * sliverCount, tempBuffer);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(20));
 
             BufferedSliceStream<AudioSample, float> stream(0, sliverCount, &bufferAllocator, /*maxBufferedDuration:*/ 5, /*useContinuousLoopingMapper:*/ false);
             stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), 0, 11, sliverCount));
@@ -451,6 +2430,216 @@ namespace UnitTestsDesktop
             Check(slice.Get(0, 0) == 11);
         }
 
+        // A ring stream keeps only its most recent capacity slivers, and reads correctly across its wrap point.
+        TEST_METHOD(TestRingStream)
+        {
+            const int sliverCount = 4;
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(20));
+
+            RingSliceStream<AudioSample, float> stream(0, sliverCount, 5);
+            stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), 0, 3, sliverCount));
+            Check(stream.DiscreteDuration() == 3);
+            Check(stream.InitialTime() == 0);
+            Check(stream.GetSliceContaining(stream.DiscreteInterval()).SliceDuration() == 3);
+
+            // this wraps, and drops the first two slivers
+            stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), 3, 4, sliverCount));
+            Check(stream.DiscreteDuration() == 5);
+            Check(stream.InitialTime() == 2);
+
+            // the first slice stops at the wrap point
+            Slice<AudioSample, float> slice = stream.GetSliceContaining(stream.DiscreteInterval());
+            Check(slice.SliceDuration() == 3);
+            Check(slice.Get(0, 0) == 2);
+
+            // copying across the wrap point gets everything in order
+            std::vector<float> copied(5 * sliverCount);
+            stream.CopyTo(stream.DiscreteInterval(), copied.data());
+            for (int i = 0; i < 5; i++)
+            {
+                Check(copied[i * sliverCount] == i + 2);
+                Check(copied[i * sliverCount + 3] == i + 2.75f);
+            }
+
+            // appending more than the capacity at once keeps only the end of it
+            stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), 7, 13, sliverCount));
+            Check(stream.DiscreteDuration() == 5);
+            Check(stream.InitialTime() == 15);
+            stream.CopyTo(stream.DiscreteInterval(), copied.data());
+            for (int i = 0; i < 5; i++)
+            {
+                Check(copied[i * sliverCount] == i + 15);
+            }
+        }
+
+        // Record separate channels into one interleaved stream, across buffer boundaries, and play them back out
+        // as separate channels, as tracks do.
+        TEST_METHOD(TestStreamChannels)
+        {
+            const int channelCount = 3;
+            const int sliceCount = 11; // 11 slices per buffer, so appends straddle buffers
+            BufferAllocator<float> bufferAllocator(channelCount * sliceCount, 1);
+
+            // 30 samples per channel; channel c, sample i has value i + c/10
+            const int sampleCount = 30;
+            std::vector<float> inputChannels[channelCount];
+            const float* inputPointers[channelCount];
+            for (int c = 0; c < channelCount; c++)
+            {
+                for (int i = 0; i < sampleCount; i++)
+                {
+                    inputChannels[c].push_back(i + c / 10.0f);
+                }
+                inputPointers[c] = inputChannels[c].data();
+            }
+
+            BufferedSliceStream<AudioSample, float> stream(channelCount, &bufferAllocator);
+            stream.AppendChannels(Duration<AudioSample>(7), inputPointers);
+            const float* remainingPointers[channelCount];
+            for (int c = 0; c < channelCount; c++)
+            {
+                remainingPointers[c] = inputPointers[c] + 7;
+            }
+            stream.AppendChannels(Duration<AudioSample>(sampleCount - 7), remainingPointers);
+            Check(stream.DiscreteDuration() == sampleCount);
+
+            // slivers are interleaved
+            Slice<AudioSample, float> first = stream.GetSliceContaining(stream.DiscreteInterval());
+            Check(first.SliverCount() == channelCount);
+            Check(first.Get(3, 2) == inputChannels[2][3]);
+
+            // read back into separate channels, one slice at a time, with an output offset of 1
+            std::vector<float> outputChannels[channelCount];
+            float* outputPointers[channelCount];
+            for (int c = 0; c < channelCount; c++)
+            {
+                outputChannels[c].resize(sampleCount + 1);
+                outputPointers[c] = outputChannels[c].data();
+            }
+
+            Interval<AudioSample> remaining = stream.DiscreteInterval();
+            int64_t completed = 0;
+            while (!remaining.IsEmpty())
+            {
+                Slice<AudioSample, float> slice = stream.GetSliceContaining(remaining);
+                slice.CopyToChannels(outputPointers, completed + 1);
+                completed += slice.SliceDuration().Value();
+                remaining = remaining.SubintervalStartingAt(slice.SliceDuration());
+            }
+            Check(completed == sampleCount);
+
+            for (int c = 0; c < channelCount; c++)
+            {
+                for (int i = 0; i < sampleCount; i++)
+                {
+                    Check(outputChannels[c][i + 1] == inputChannels[c][i]);
+                }
+            }
+        }
+
+        // Sequential lookups through a playback cursor give the same slices as full lookups, across buffer
+        // boundaries, loop wraps and seeks, with both looping mappers.
+        TEST_METHOD(TestPlaybackCursor)
+        {
+            const int sliverCount = 4;
+            const int sliceCount = 11; // 11 slices per buffer, so the loop spans several buffers
+            BufferAllocator<float> bufferAllocator(sliverCount * sliceCount, 1);
+            OwningBuf<float> owningBuf(AllocateSmall4FloatArray(30));
+
+            for (int exact = 0; exact <= 1; exact++)
+            {
+                BufferedSliceStream<AudioSample, float> stream(0, sliverCount, &bufferAllocator, 0, /*useExactLoopingMapper:*/ exact == 1);
+                stream.Append(Slice<AudioSample, float>(Buf<float>(owningBuf), 0, 30, sliverCount));
+                stream.Shut(29.4f);
+
+                PlaybackCursor<AudioSample> cursor{};
+                Time<AudioSample> time{ 0 };
+                for (int block = 0; block < 100; block++)
+                {
+                    // a seek, every so often
+                    if (block % 37 == 36)
+                    {
+                        time = time + Duration<AudioSample>(5);
+                    }
+
+                    Duration<AudioSample> blockDuration{ 4 };
+                    while (blockDuration > 0)
+                    {
+                        Interval<AudioSample> interval(time, blockDuration);
+                        Slice<AudioSample, float> cursorSlice = stream.GetSliceContaining(cursor, interval);
+                        Slice<AudioSample, float> searchedSlice = stream.GetSliceContaining(interval);
+                        Check(cursorSlice.OffsetPointer() == searchedSlice.OffsetPointer());
+                        Check(cursorSlice.SliceDuration() == std::min(searchedSlice.SliceDuration().Value(), blockDuration.Value()));
+
+                        time = time + cursorSlice.SliceDuration();
+                        blockDuration = blockDuration - cursorSlice.SliceDuration();
+                    }
+                }
+            }
+        }
+
+        // Time looking up one block's worth of slices for each of 64 looping tracks, with and without playback cursors.
+        TEST_METHOD(BenchmarkPlaybackCursor)
+        {
+            const int trackCount = 64;
+            const int blockDuration = 32;
+            const int blockCount = 100000;
+            const int sliverCount = 2;
+            const int bufferSlivers = 4096;
+            BufferAllocator<float> bufferAllocator(sliverCount * bufferSlivers, 1);
+
+            std::vector<float> silence(sliverCount * 1000);
+            std::vector<std::unique_ptr<BufferedSliceStream<AudioSample, float>>> streams;
+            for (int t = 0; t < trackCount; t++)
+            {
+                // loops of various lengths from 0.25 to about 1 second, spanning several buffers each
+                int loopDuration = 12000 + t * 571;
+                streams.push_back(std::unique_ptr<BufferedSliceStream<AudioSample, float>>(
+                    new BufferedSliceStream<AudioSample, float>(0, sliverCount, &bufferAllocator, 0, false)));
+                for (int appended = 0; appended < loopDuration; appended += 1000)
+                {
+                    streams[t]->Append(Duration<AudioSample>(std::min(1000, loopDuration - appended)), silence.data());
+                }
+                streams[t]->Shut((float)loopDuration);
+            }
+
+            std::vector<PlaybackCursor<AudioSample>> cursors(trackCount);
+            int64_t checksum[2] = { 0, 0 };
+            double seconds[2];
+            for (int useCursor = 0; useCursor <= 1; useCursor++)
+            {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int t = 0; t < trackCount; t++)
+                {
+                    Time<AudioSample> time{ 0 };
+                    for (int b = 0; b < blockCount; b++)
+                    {
+                        Duration<AudioSample> remaining{ blockDuration };
+                        while (remaining > 0)
+                        {
+                            Interval<AudioSample> interval(time, remaining);
+                            Slice<AudioSample, float> slice = useCursor
+                                ? streams[t]->GetSliceContaining(cursors[t], interval)
+                                : streams[t]->GetSliceContaining(interval);
+                            checksum[useCursor] += slice.Offset().Value();
+                            time = time + slice.SliceDuration();
+                            remaining = remaining - slice.SliceDuration();
+                        }
+                    }
+                }
+                seconds[useCursor] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            // both ways should find exactly the same slices
+            Check(checksum[0] == checksum[1]);
+
+            std::wstringstream wstr;
+            wstr << L"BenchmarkPlaybackCursor: " << trackCount << L" tracks, " << blockDuration << L"-sample blocks: "
+                << L"searching " << (seconds[0] * 1e9 / ((double)trackCount * blockCount)) << L" ns/block, "
+                << L"cursor " << (seconds[1] * 1e9 / ((double)trackCount * blockCount)) << L" ns/block" << std::endl;
+            Logger::WriteMessage(wstr.str().c_str());
+        }
+
         /*
         [TestMethod]
         public void TestSparseSampleByteStream()